@@ -80,7 +80,9 @@ inline void mark_hash (__global plain_t *plains_buf, __global u32 *d_result, con
 {
   const u32 idx = atomic_inc (d_result);
 
-  if (idx >= digests_cnt)
+  // d_result[1] is the size of plains_buf, the host may collect the cracks of all salts at once
+
+  if (idx >= d_result[1])
   {
     // this is kind of tricky: we *must* call atomic_inc() to know about the current value from a multi-thread perspective
     // this action creates a buffer overflow, so we need to fix it here
@@ -11021,3 +11023,19 @@ __kernel void gpu_memset (__global uint4 *buf, const u32 value, const u32 gid_ma
 
   buf[gid] = (uint4) (value);
 }
+
+__kernel void gpu_pws_unpack (__global const u32 *pws_packed, __global pw_t *pws, const u32 stride, const u32 gid_max)
+{
+  const u32 gid = get_global_id (0);
+
+  if (gid >= gid_max) return;
+
+  __global const u32 *src = pws_packed + (gid * stride);
+
+  for (u32 i = 0; i < 16; i++)
+  {
+    pws[gid].i[i] = ((i + 1) < stride) ? src[1 + i] : 0;
+  }
+
+  pws[gid].pw_len = src[0];
+}
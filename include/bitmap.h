@@ -8,6 +8,9 @@
 
 #include <string.h>
 
+/// random digest words pushed through the bitmaps of each word to measure how often check () lets a miss pass
+#define BITMAP_PROBES (1u << 20)
+
 int  bitmap_ctx_init    (hashcat_ctx_t *hashcat_ctx);
 void bitmap_ctx_destroy (hashcat_ctx_t *hashcat_ctx);
 
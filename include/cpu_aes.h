@@ -13,5 +13,6 @@ void AES_encrypt (AES_KEY *aes_key, const u8 *input, u8 *output);
 void AES_decrypt (AES_KEY *aes_key, const u8 *input, u8 *output);
 
 void AES128_decrypt_cbc (const u32 key[4], const u32 iv[4], const u32 in[16], u32 out[16]);
+void AES256_decrypt_cbc (const u8 *key, const u32 iv[4], const u32 *in, u32 *out, const u32 blocks_cnt);
 
 #endif // _CPU_AES_H
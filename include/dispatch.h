@@ -8,5 +8,6 @@
 
 void *thread_calc_stdin (void *p);
 void *thread_calc (void *p);
+void *thread_calc_reader (void *p);
 
 #endif // _DISPATCH_H
@@ -1875,7 +1875,7 @@ int ethereum_scrypt_parse_hash    (u8 *input_buf, u32 input_len, hash_t *hash_bu
  * hook functions
  */
 
-void seven_zip_hook_func (hc_device_param_t *device_param, hashes_t *hashes, const u32 salt_pos, const u32 pws_cnt);
+void seven_zip_hook_func (hc_device_param_t *device_param, hashes_t *hashes, const u32 salt_pos, const u32 pw_beg, const u32 pw_end);
 
 /**
  * output functions
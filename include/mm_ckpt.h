@@ -0,0 +1,26 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+#ifndef _MM_CKPT_H
+#define _MM_CKPT_H
+
+#include "types.h"
+
+int  mm_ckpt_init     (hashcat_ctx_t *hashcat_ctx);
+int  mm_ckpt_begin    (hashcat_ctx_t *hashcat_ctx);
+void mm_ckpt_split    (hashcat_ctx_t *hashcat_ctx);
+void mm_ckpt_end      (hashcat_ctx_t *hashcat_ctx);
+void mm_ckpt_report   (hashcat_ctx_t *hashcat_ctx);
+void mm_ckpt_position (const hashcat_ctx_t *hashcat_ctx, u32 *masks_pos, u32 *dicts_pos);
+
+void mm_ckpt_merge    (hashcat_ctx_t *hashcat_ctx, const mm_range_t *ranges, const u32 cnt);
+void mm_ckpt_own      (hashcat_ctx_t *hashcat_ctx, const u64 start, const u64 end);
+void mm_ckpt_map      (hashcat_ctx_t *hashcat_ctx, const u64 start, const u64 end);
+u64  mm_ckpt_pop      (hashcat_ctx_t *hashcat_ctx);
+
+int  mm_degraded_init   (hashcat_ctx_t *hashcat_ctx, const int inited_all);
+int  mm_degraded_repair (hashcat_ctx_t *hashcat_ctx);
+
+#endif // _MM_CKPT_H
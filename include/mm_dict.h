@@ -0,0 +1,41 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+#ifndef _MM_DICT_H
+#define _MM_DICT_H
+
+#include "types.h"
+
+long left_size (mm_extend_fd_t *mfd, FILE *fd);
+int mm_feof (mm_extend_fd_t *mfd, FILE *fd);
+int get_entry_cnt(hashcat_ctx_t *hashcat_ctx, char *dict_file, mm_extend_fd_t * mfd);
+void release_entry_cnt (mm_extend_fd_t *mfd);
+u64 mm_word_offset (const mm_extend_fd_t *mfd, FILE *fd, const u64 idx);
+FILE *mm_dict_open (hashcat_ctx_t *hashcat_ctx, const char *dict_file);
+char *mm_realpath (const char *path);
+
+void mm_seek_word    (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd, FILE *fd, const u64 idx);
+
+int  mm_map_open     (const char *dictfile, const mm_extend_fd_t *mfd, mm_map_t *map);
+void mm_map_advise   (const mm_map_t *map, const u64 words_off, const u64 words_fin);
+void mm_map_word     (const mm_map_t *map, const u64 idx, char **out_buf, u32 *out_len);
+void mm_map_close    (mm_map_t *map);
+
+/// line index of newline dicts, kept in the profile dir next to hashcat.dictstat
+#define MM_DICT_INDEX_MAGIC     0x48434c49
+#define MM_DICT_INDEX_VERSION   1
+#define MM_DICT_INDEX_STRIDE    4096
+
+/// block-compressed dicts, see tools/mm_pack_dict.py
+#define MM_WLZ_MAGIC            0x5a574348
+#define MM_WLZ_VERSION          1
+#define MM_WLZ_BLOCK_MAX        (64 * 1024 * 1024)
+
+/// they are read through a fopencookie () stream, which only glibc and musl have
+#if defined (__linux__)
+#define MM_WLZ_STREAM           1
+#endif
+
+#endif // _MM_DICT_H
@@ -8,10 +8,11 @@
 
 #include "types.h"
 
-long left_size (mm_extend_fd_t *mfd, FILE *fd);
-int mm_feof (mm_extend_fd_t *mfd, FILE *fd);
-int get_entry_cnt(char *dict_file, mm_extend_fd_t * mfd);
+int  mm_fd_list_count   (hashcat_ctx_t *hashcat_ctx, const u32 dicts_first);
+void mm_fd_list_destroy (hashcat_ctx_t *hashcat_ctx);
 int straight_divide_workload (hashcat_ctx_t *hashcat_ctx);
+int combi_divide_workload (hashcat_ctx_t *hashcat_ctx);
+int mm_hybrid_split (hashcat_ctx_t *hashcat_ctx);
 mm_extend_fd_t * create_mm_fd();
 void destory_mm_fd(mm_extend_fd_t * mfd);
 void update_log(hashcat_ctx_t * hashcat_ctx, bool last);
@@ -28,8 +29,64 @@ typedef enum mm_attack_mode_enum
 
 void mm_logfile_append (hashcat_ctx_t *hashcat_ctx, const char *fmt, ...);
 
+int  mm_work_init    (hashcat_ctx_t *hashcat_ctx);
+void mm_node_release (hashcat_ctx_t *hashcat_ctx);
+void mm_work_destroy (hashcat_ctx_t *hashcat_ctx);
+void mm_work_begin   (hashcat_ctx_t *hashcat_ctx, const u32 epoch);
+u64  mm_work_refill  (hashcat_ctx_t *hashcat_ctx);
+
+bool mm_reader_begin (hashcat_ctx_t *hashcat_ctx);
+void mm_reader_end   (hashcat_ctx_t *hashcat_ctx);
+
+int  mm_leader_of    (const hashcat_ctx_t *hashcat_ctx, const int rank);
+
+void mm_get_slice      (hashcat_ctx_t *hashcat_ctx, const u64 total, u64 *start, u64 *end);
+int  mm_speed_exchange (hashcat_ctx_t *hashcat_ctx);
+int  mm_speed_split    (hashcat_ctx_t *hashcat_ctx);
+void mm_speed_finish   (hashcat_ctx_t *hashcat_ctx);
+int  mm_rules_split    (hashcat_ctx_t *hashcat_ctx);
+int  mm_mask_plan      (hashcat_ctx_t *hashcat_ctx);
+bool mm_mask_owned     (hashcat_ctx_t *hashcat_ctx, const u32 masks_pos);
+void mm_mask_slice     (hashcat_ctx_t *hashcat_ctx);
+
+int  mm_potfile_remove_parse (hashcat_ctx_t *hashcat_ctx);
+
+#if defined (ENABLE_MPI)
+void mm_bcast_bytes (hashcat_ctx_t *hashcat_ctx, void *buf, const u64 len);
+#endif
+
+bool mm_bcast_init_enabled (const hashcat_ctx_t *hashcat_ctx);
+int  mm_hashes_bcast       (hashcat_ctx_t *hashcat_ctx, const int rc);
+int  mm_hash_cache_load    (hashcat_ctx_t *hashcat_ctx);
+void mm_hash_cache_save    (hashcat_ctx_t *hashcat_ctx);
+void mm_kernel_cache_add   (hashcat_ctx_t *hashcat_ctx, const char *cached_file);
+int  mm_kernel_cache_bcast (hashcat_ctx_t *hashcat_ctx, const int rc);
+
 /// default time interval set to 30 sec
 #define DEFAULT_MM_LOG_INTERVAL 30
 #define HOSTNAME_DISPLAY_LEN    32
 
+/// seconds of work a rank asks for when it claims a new chunk
+#define DEFAULT_MM_CHUNK_TIME   10
+
+/// part of the kernel cache key. the cache is keyed on the device and the build, not on the .cl sources, bump this
+/// whenever the fork changes a shared include such as OpenCL/inc_common.cl. 1: gpu_pws_unpack, 2: mark_hash
+#define MM_KERNEL_VERSION       2
+
+/// upper limit of --mm-parse-threads
+#define MM_PARSE_THREADS_MAX    256
+
+/// upper limit of --mm-hook-threads
+#define MM_HOOK_THREADS_MAX     256
+
+/// --mm-bitmap-fpr N aims at a false positive rate of 10^-N, the probes of bitmap.c cannot resolve much less
+#define MM_BITMAP_FPR_MAX       20
+
+/// --mm-hash-cache file, bump the version whenever the layout of a section changes
+#define MM_HASH_CACHE_MAGIC     0x48434848
+#define MM_HASH_CACHE_VERSION   1
+
+/// seconds between two merges of the potfile shards on rank 0
+#define MM_POTFILE_MERGE_INTERVAL 60
+
 #endif // _MONITOR_H
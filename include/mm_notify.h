@@ -0,0 +1,44 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+#ifndef _MM_NOTIFY_H
+#define _MM_NOTIFY_H
+
+#include "types.h"
+
+typedef enum mm_notify_event
+{
+  MM_EVENT_NONE,
+  MM_EVENT_CRACKED,
+  MM_EVENT_FINISHED,
+  MM_EVENT_ERROR,
+  MM_EVENT_FAILED  /// --mm-degraded, local only and never sent
+} mm_notify_event_t;
+
+/// tags on mm_ctx->comm used by the stop propagation
+typedef enum mm_notify_tag
+{
+  MM_TAG_STOP = 0x5301, /// origin -> all ranks, { event, origin }
+  MM_TAG_DONE = 0x5302, /// rank -> rank 0, no work left on that rank
+  MM_TAG_ACK  = 0x5303, /// rank -> origin of a crack STOP
+  MM_TAG_HASH = 0x5304, /// rank -> all ranks, { salt_pos, hash_pos } pairs of new cracks
+  MM_TAG_CKPT = 0x5305  /// rank -> rank 0, mm_range_t of finished words
+} mm_notify_tag_t;
+
+void mm_notify_init   (hashcat_ctx_t *hashcat_ctx);
+int  mm_notify_wait   (hashcat_ctx_t *hashcat_ctx, const u32 msec);
+void mm_notify_finish (hashcat_ctx_t *hashcat_ctx);
+
+void mm_share_crack   (hashcat_ctx_t *hashcat_ctx, const u32 salt_pos, const u32 hash_pos, const char *line);
+
+#if defined (ENABLE_MPI)
+void mm_notify_isend  (hashcat_ctx_t *hashcat_ctx, const void *buf, const int cnt, MPI_Datatype type, const int dest, const int tag);
+void mm_share_keep    (hashcat_ctx_t *hashcat_ctx, void *buf);
+#endif
+
+/// how often the monitor looks for stop messages of other ranks
+#define MM_NOTIFY_POLL_MSEC     10
+
+#endif // _MM_NOTIFY_H
@@ -28,5 +28,6 @@ int   mask_ctx_update_loop    (hashcat_ctx_t *hashcat_ctx);
 int   mask_ctx_init           (hashcat_ctx_t *hashcat_ctx);
 void  mask_ctx_destroy        (hashcat_ctx_t *hashcat_ctx);
 int   mask_ctx_parse_maskfile (hashcat_ctx_t *hashcat_ctx);
+int   mask_ctx_keyspace       (hashcat_ctx_t *hashcat_ctx, const u32 masks_pos, u64 *result);
 
 #endif // _MPSP_H
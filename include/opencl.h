@@ -63,7 +63,10 @@ int run_kernel_tm     (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_par
 int run_kernel_amp    (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 num);
 int run_kernel_memset (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, cl_mem buf, const u32 value, const u32 num);
 int run_kernel_bzero  (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, cl_mem buf, const size_t size);
+int run_kernel_pws_unpack (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 num);
 int run_copy          (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt);
+int run_copy_next     (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt);
+int run_copy_swap     (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt);
 int run_cracker       (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt);
 
 int  opencl_ctx_init                  (hashcat_ctx_t *hashcat_ctx);
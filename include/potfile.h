@@ -12,6 +12,10 @@
 
 #define INCR_POT 1000
 
+/// shard write buffer growth and initial size of the merged line set
+#define POTFILE_SHARD_BUF (1024 * 1024)
+#define POTFILE_SHARD_SET 1024
+
 int  potfile_init             (hashcat_ctx_t *hashcat_ctx);
 int  potfile_read_open        (hashcat_ctx_t *hashcat_ctx);
 void potfile_read_close       (hashcat_ctx_t *hashcat_ctx);
@@ -19,10 +23,16 @@ int  potfile_write_open       (hashcat_ctx_t *hashcat_ctx);
 void potfile_write_close      (hashcat_ctx_t *hashcat_ctx);
 void potfile_write_append     (hashcat_ctx_t *hashcat_ctx, const char *out_buf, u8 *plain_ptr, unsigned int plain_len);
 int  potfile_remove_parse     (hashcat_ctx_t *hashcat_ctx);
+int  potfile_remove_parse_file (hashcat_ctx_t *hashcat_ctx);
 void potfile_destroy          (hashcat_ctx_t *hashcat_ctx);
 int  potfile_handle_show      (hashcat_ctx_t *hashcat_ctx);
 int  potfile_handle_left      (hashcat_ctx_t *hashcat_ctx);
 
+void potfile_shard_flush      (hashcat_ctx_t *hashcat_ctx);
+int  potfile_shard_merge      (hashcat_ctx_t *hashcat_ctx);
+int  potfile_shard_prepare    (hashcat_ctx_t *hashcat_ctx);
+void potfile_shard_renumber   (hashcat_ctx_t *hashcat_ctx);
+
 void potfile_update_hash      (hashcat_ctx_t *hashcat_ctx, hash_t *found, char *line_pw_buf, int line_pw_len);
 void potfile_update_hashes    (hashcat_ctx_t *hashcat_ctx, hash_t *found, hash_t *hashes_buf, u32 hashes_cnt, int (*compar) (const void *, const void *, void *), char *line_pw_buf, int line_pw_len);
 
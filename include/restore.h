@@ -18,8 +18,12 @@
 #define RESTORE_VERSION_MIN 340
 #define RESTORE_VERSION_CUR 350
 
+#define RESTORE_RANGES_VERSION 1
+
 int cycle_restore (hashcat_ctx_t *hashcat_ctx);
 
+int read_restore_ranges (hashcat_ctx_t *hashcat_ctx);
+
 void unlink_restore (hashcat_ctx_t *hashcat_ctx);
 
 int restore_ctx_init (hashcat_ctx_t *hashcat_ctx, int argc, char **argv);
@@ -26,6 +26,12 @@
 #define hc_thread_mutex_init(m)     InitializeCriticalSection (&m)
 #define hc_thread_mutex_delete(m)   DeleteCriticalSection     (&m)
 
+#define hc_thread_cond_wait(c,m)    SleepConditionVariableCS    (&c, &m, INFINITE)
+#define hc_thread_cond_signal(c)    WakeConditionVariable       (&c)
+#define hc_thread_cond_broadcast(c) WakeAllConditionVariable    (&c)
+#define hc_thread_cond_init(c)      InitializeConditionVariable (&c)
+#define hc_thread_cond_delete(c)
+
 #else
 
 #define hc_thread_create(t,f,a)     pthread_create (&t, NULL, f, a)
@@ -37,6 +43,12 @@
 #define hc_thread_mutex_init(m)     pthread_mutex_init     (&m, NULL)
 #define hc_thread_mutex_delete(m)   pthread_mutex_destroy  (&m)
 
+#define hc_thread_cond_wait(c,m)    pthread_cond_wait      (&c, &m)
+#define hc_thread_cond_signal(c)    pthread_cond_signal    (&c)
+#define hc_thread_cond_broadcast(c) pthread_cond_broadcast (&c)
+#define hc_thread_cond_init(c)      pthread_cond_init      (&c, NULL)
+#define hc_thread_cond_delete(c)    pthread_cond_destroy   (&c)
+
 #endif
 
 /*
@@ -23,6 +23,10 @@
 
 #include <iconv.h>
 
+#if defined (ENABLE_MPI)
+#include <mpi.h>
+#endif
+
 #if defined (_WIN)
 #include <windows.h>
 #if defined (_BASETSD_H)
@@ -58,11 +62,13 @@ typedef struct timeval    hc_timer_t;
 #endif
 
 #if defined (_WIN)
-typedef HANDLE            hc_thread_t;
-typedef CRITICAL_SECTION  hc_thread_mutex_t;
+typedef HANDLE              hc_thread_t;
+typedef CRITICAL_SECTION    hc_thread_mutex_t;
+typedef CONDITION_VARIABLE  hc_thread_cond_t;
 #else
-typedef pthread_t         hc_thread_t;
-typedef pthread_mutex_t   hc_thread_mutex_t;
+typedef pthread_t           hc_thread_t;
+typedef pthread_mutex_t     hc_thread_mutex_t;
+typedef pthread_cond_t      hc_thread_cond_t;
 #endif
 
 // stat
@@ -666,7 +672,25 @@ typedef enum user_options_map
   IDX_MM_LOG_DIR               = 0xeee2,
   IDX_MM_LOG_INTERVAL          = 0xeee3,
   IDX_MM_HELP                  = 0xeee4,
-  IDX_MM_STDOUT_ENABLE         = 0xeee5
+  IDX_MM_STDOUT_ENABLE         = 0xeee5,
+  IDX_MM_DYNAMIC               = 0xeee6,
+  IDX_MM_CHUNK_TIME            = 0xeee7,
+  IDX_MM_SPEED_SPLIT           = 0xeee8,
+  IDX_MM_MULTI_TARGET          = 0xeee9,
+  IDX_MM_POTFILE_SHARDS        = 0xeeea,
+  IDX_MM_BCAST_INIT            = 0xeeeb,
+  IDX_MM_NODE_TOPOLOGY         = 0xeeec,
+  IDX_MM_CLUSTER_RESTORE       = 0xeeed,
+  IDX_MM_DEGRADED              = 0xeeee,
+  IDX_MM_SHARED_READER         = 0xeeef,
+  IDX_MM_PIPELINE              = 0xeef0,
+  IDX_MM_PACK_PWS              = 0xeef1,
+  IDX_MM_SALT_BATCH            = 0xeef2,
+  IDX_MM_PARSE_THREADS         = 0xeef3,
+  IDX_MM_HASH_CACHE            = 0xeef4,
+  IDX_MM_BITMAP_FPR            = 0xeef5,
+  IDX_MM_PINNED                = 0xeef6,
+  IDX_MM_HOOK_THREADS          = 0xeef7
 
 } user_options_map_t;
 
@@ -934,6 +958,7 @@ typedef struct hc_device_param
   u32     kernel_threads_by_wgs_kernel_amp;
   u32     kernel_threads_by_wgs_kernel_tm;
   u32     kernel_threads_by_wgs_kernel_memset;
+  u32     kernel_threads_by_wgs_kernel_pws_unpack;
 
   u32     kernel_loops;
   u32     kernel_accel;
@@ -946,6 +971,12 @@ typedef struct hc_device_param
   u32     kernel_power;
   u32     hardware_power;
 
+  double  autotune_speed; // candidates per msec at the autotuned accel/loops
+
+  bool    digests_shown_dirty; // other MPI ranks cracked something, d_digests_shown needs an update
+
+  bool    kernel_defer; // --mm-salt-batch, the kernels of all salts go into the queue back to back, run_cracker() waits once
+
   size_t  size_pws;
   size_t  size_tmps;
   size_t  size_hooks;
@@ -969,6 +1000,12 @@ typedef struct hc_device_param
   pw_t   *pws_buf;
   u32     pws_cnt;
 
+  pw_t   *pws_buf_next; // --mm-pipeline, filled and uploaded while pws_buf is cracked
+
+  u32     pws_stride;   // --mm-pack-pws, u32 per packed candidate in pws_buf, 0 while it holds pw_t
+
+  plain_t *plain_bufs;  // --mm-pinned, check_cracked() reads the cracks into it, NULL without
+
   u64     words_off;
   u64     words_done;
 
@@ -1027,6 +1064,7 @@ typedef struct hc_device_param
   cl_kernel  kernel_amp;
   cl_kernel  kernel_tm;
   cl_kernel  kernel_memset;
+  cl_kernel  kernel_pws_unpack;
 
   cl_context context;
 
@@ -1035,8 +1073,18 @@ typedef struct hc_device_param
   cl_program program_amp;
 
   cl_command_queue command_queue;
+  cl_command_queue command_queue_copy; // --mm-pipeline, uploads d_pws_buf_next next to the kernels
+
+  cl_event pws_event;
+  cl_event pws_unpack_event;           // --mm-pipeline with --mm-pack-pws, the next upload into d_pws_packed waits for it
 
   cl_mem  d_pws_buf;
+  cl_mem  d_pws_buf_next;
+  cl_mem  d_pws_packed;
+  cl_mem  h_pws_buf;      // --mm-pinned, the pinned host memory mapped at pws_buf, swaps along with it
+  cl_mem  h_pws_buf_next;
+  cl_mem  h_hooks;
+  cl_mem  h_plain_bufs;
   cl_mem  d_pws_amp_buf;
   cl_mem  d_words_buf_l;
   cl_mem  d_words_buf_r;
@@ -1306,6 +1354,23 @@ typedef struct potfile_ctx
   u8      *out_buf; // allocates [HCBUFSIZ_LARGE];
   u8      *tmp_buf; // allocates [HCBUFSIZ_LARGE];
 
+  /// --mm-potfile-shards, every rank appends to its own <filename>.<rank>, rank 0 merges them into filename
+
+  bool     shards;
+  char    *shard_filename;
+  char    *shard_buf;       /// records not written to the shard yet
+  size_t   shard_len;
+  size_t   shard_avail;
+  long    *shard_off;       /// rank 0, bytes of each shard already merged
+  u64     *merged;          /// rank 0, hash set of the lines in filename
+  u64     *merged_off;      /// offset of each line in filename, duplicates are confirmed byte by byte against it
+  u64      merged_cnt;
+  u64      merged_avail;    /// power of 2
+  bool     merged_loaded;   /// the set holds filename, not yet for a new rank 0 of --mm-degraded
+  FILE    *merged_fp;       /// filename during a merge, new lines are appended and known ones read back
+  u64      merged_end;      /// where the next new line goes
+  bool     merged_seek;     /// merged_fp was read from since the last write
+
 } potfile_ctx_t;
 
 typedef struct restore_data
@@ -1332,6 +1397,7 @@ typedef struct pidfile_data
 typedef struct restore_ctx
 {
   bool    enabled;
+  bool    restored;         /// started with --restore, user_options->restore is gone after the argv of the file are parsed
 
   int     argc;
   char  **argv;
@@ -1339,6 +1405,9 @@ typedef struct restore_ctx
   char   *eff_restore_file;
   char   *new_restore_file;
 
+  char   *eff_ranges_file;  /// --mm-cluster-restore, finished ranges of the whole job
+  char   *new_ranges_file;
+
   restore_data_t *rd;
 
 } restore_ctx_t;
@@ -1537,6 +1606,24 @@ typedef struct user_options
   char*        mm_log_dir;
   bool         mm_usage;
   bool         mm_stdout_enable;
+  bool         mm_dynamic;
+  u32          mm_chunk_time;
+  bool         mm_speed_split;
+  bool         mm_multi_target;
+  bool         mm_potfile_shards;
+  bool         mm_bcast_init;
+  bool         mm_node_topology;
+  bool         mm_cluster_restore;
+  bool         mm_degraded;
+  bool         mm_shared_reader;
+  bool         mm_pipeline;
+  bool         mm_pack_pws;
+  bool         mm_salt_batch;
+  u32          mm_parse_threads;
+  bool         mm_hash_cache;
+  u32          mm_bitmap_fpr;
+  bool         mm_pinned;
+  u32          mm_hook_threads;
 
 } user_options_t;
 
@@ -1576,6 +1663,9 @@ typedef struct bitmap_ctx
   u32  *bitmap_s2_c;
   u32  *bitmap_s2_d;
 
+  double bitmap_fill;   /// share of the bits set in the s1 bitmaps, measured
+  double bitmap_fpr;    /// share of non-matching digests which pass all eight bitmaps, measured
+
 } bitmap_ctx_t;
 
 typedef struct folder_config
@@ -1614,6 +1704,7 @@ typedef struct straight_ctx
   bool enabled;
 
   u32             kernel_rules_cnt;
+  u32             kernel_rules_off; /// first rule this rank runs, kernel_rules_cnt is only our share if the ranks split the rules too
   kernel_rule_t  *kernel_rules_buf;
 
   char **dicts;
@@ -1636,6 +1727,8 @@ typedef struct combinator_ctx
 
   u32 combs_mode;
   u64 combs_cnt;
+  u64 combs_off;    /// first amplifier this rank runs, combs_cnt is only our share if the ranks split the mask of a hybrid attack
+  u64 combs_width;  /// record width of the amplifier dict of a combinator attack
 
 } combinator_ctx_t;
 
@@ -1750,6 +1843,9 @@ typedef struct hashcat_status
   double      cpt_avg_hour;
   double      cpt_avg_day;
   char       *cpt;
+  int         bitmap_bits;
+  double      bitmap_fill;
+  double      bitmap_fpr;
 
   device_info_t device_info_buf[DEVICES_MAX];
   int           device_info_cnt;
@@ -1896,9 +1992,343 @@ typedef struct mm_extend_fd
   unsigned long words_cnt;    /// total words in dict file
   unsigned long words_start;  /// start pos, 0-based
   unsigned long words_end;    /// end pos, also 0-based;
-  int word_base;              /// how many bytes per word
+  int word_base;              /// how many bytes per word, 0 for a newline dict
+  u64 file_size;
+  u64 *line_offs;             /// newline dict: byte offset of line i * MM_DICT_INDEX_STRIDE
+  u64 offs_cnt;               /// entries of line_offs
+  u64 words_end_off;          /// byte offset right behind words_end, set with the range
+  char *dict_file;
+  bool packed;                /// block-compressed dict, read through mm_dict_open (), offsets are uncompressed ones
+  bool counted;               /// filled by get_entry_cnt (), see mm_fd_list_count ()
 } mm_extend_fd_t;
 
+/// header of a line index file, the offsets of every MM_DICT_INDEX_STRIDE-th line follow
+typedef struct mm_dict_index_hdr
+{
+  u32  magic;
+  u32  version;
+  u32  stride;
+  u32  pad;
+  u64  file_size;
+  u64  file_mtime;
+
+  /// not part of the key
+
+  u64  lines_cnt;
+  u64  offs_cnt;
+  char dictfile[HCBUFSIZ_TINY];
+
+} mm_dict_index_hdr_t;
+
+/// header of a block-compressed dict. every block is an LZMA2 stream of its own, so a reader
+/// starts decoding at any block. blocks_cnt + 1 compressed offsets follow at index_off, the last
+/// one is where the last block ends
+typedef struct mm_wlz_hdr
+{
+  u32  magic;
+  u32  version;
+  u32  word_base;             /// record width, 0 for a newline dict
+  u32  props;                 /// LZMA2 dictionary size byte
+  u64  block_size;            /// uncompressed bytes per block, only the last one may be shorter
+  u64  raw_size;
+  u64  blocks_cnt;
+  u64  index_off;
+
+} mm_wlz_hdr_t;
+
+/// blocks a compressed dict reader keeps decoded, the one that is read and the ones ahead of it
+#define MM_WLZ_SLOTS 4
+
+typedef struct mm_wlz_slot
+{
+  u8   *buf;
+  u64   block;
+  u64   len;
+  bool  ready;
+
+} mm_wlz_slot_t;
+
+/// stream behind the FILE * of mm_dict_open (). block b is decoded into slots[b % MM_WLZ_SLOTS]
+/// by the decoder thread, up to MM_WLZ_SLOTS - 1 blocks ahead of the one that is read
+typedef struct mm_wlz
+{
+  FILE          *fp;
+  mm_wlz_hdr_t   hdr;
+  u64           *block_offs;
+
+  u64            pos;         /// uncompressed offset of the next read
+  u64            cur;         /// block of pos
+  bool           quit;
+  bool           error;       /// a block did not decode, reads fail from then on
+
+  struct hashcat_ctx *hashcat_ctx;  /// the decoder thread reports a broken block through the event log
+  char              *dict_file;
+
+  mm_wlz_slot_t  slots[MM_WLZ_SLOTS];
+
+  hc_thread_t        thread;
+  hc_thread_mutex_t  mux;
+  hc_thread_cond_t   cond_work;   /// the decoder waits for cur to move or for quit
+  hc_thread_cond_t   cond_ready;  /// a read waits for its block or for an error
+
+} mm_wlz_t;
+
+/// read-only mapping of a fixed-width dict, word idx of the mfd range starts at base + (start + idx) * word_base
+typedef struct mm_map
+{
+  char *base;                 /// NULL if the dict is read through a FILE * instead
+  u64   size;
+  u64   start;
+  u64   word_base;
+
+} mm_map_t;
+
+#define MM_NODE_SHARES_MAX 16
+
+/// [start, end) words of one (mask, dict) epoch, as kept by the cluster checkpoint
+typedef struct mm_range
+{
+  u64 epoch;
+  u64 total;                  /// unamplified keyspace of the epoch, a restore checks it still matches
+  u64 start;
+  u64 end;
+
+} mm_range_t;
+
+/// one batch of the shared reader, the words [words_off, words_fin) of the dict after the filters
+typedef struct mm_batch
+{
+  pw_t *pws;
+  u32   pws_cnt;
+  u32   words_extra;          /// rejected by the filters
+  u64   words_off;
+  u64   words_fin;
+  bool  busy;                 /// a device thread copies it out, the reader must not fill it yet
+
+} mm_batch_t;
+
+/// --mm-parse-threads: the lines [beg, end) of the mapped hashfile, parsed into the hash_t from hashes_base on
+typedef struct mm_parse
+{
+  struct hashcat_ctx *hashcat_ctx;
+
+  const char *beg;
+  const char *end;
+  u32   hashlist_format;
+  u32   line_base;            /// lines before beg, for the warnings
+  u32   lines_cnt;
+  u32   hashes_base;          /// first hash_t of ours, the non-empty lines before beg
+  u32   hashes_avail;         /// non-empty lines in range, what we may use from hashes_base on
+  u32   hashes_cnt;           /// parsed, they sit at the start of our hash_t
+
+  hc_thread_mutex_t *mux_log; /// event_log_*() shares one msg_buf
+
+} mm_parse_t;
+
+/// --mm-parse-threads: sort one run of hash_t in place, or merge two adjacent runs into out
+typedef struct mm_sort
+{
+  hash_t *buf;
+  hash_t *out;                /// NULL to sort
+  u32     cnt;
+  u32     cnt2;               /// the second run follows the first one in buf
+
+  int   (*compar) (const void *, const void *, void *);
+  void   *arg;
+
+} mm_sort_t;
+
+/// --mm-hook-threads: the share of one worker in a hook call, the candidates [pw_beg, pw_end) of the batch
+typedef struct mm_hook
+{
+  hc_device_param_t *device_param;
+  hashes_t          *hashes;
+
+  u32   hash_mode;
+  u32   salt_pos;
+  u32   pw_beg;
+  u32   pw_end;
+
+} mm_hook_t;
+
+/// --mm-hash-cache: header of profile_dir/hashcat.hashcache.*, the sections follow it. everything up to hashlist_format
+/// is the key and has to match the current session, hashfile is compared on its own
+typedef struct mm_hash_cache_hdr
+{
+  u32   magic;
+  u32   version;
+  u32   hash_mode;
+  u32   keep_all_hashes;      /// stage2 does not remove duplicates then
+  u64   opts_type;            /// includes --hex-salt
+  u64   file_size;
+  u64   file_mtime;
+  u32   dgst_size;
+  u32   salt_size;            /// sizeof (salt_t) of the build which wrote it
+  u32   esalt_size;
+  u32   hook_salt_size;
+
+  u32   hashlist_format;
+  u32   hashes_cnt;
+  u32   hashes_cnt_orig;
+  u32   salts_cnt;
+
+  char  hashfile[HCBUFSIZ_TINY];
+
+} mm_hash_cache_hdr_t;
+
+typedef struct mm_ctx
+{
+  bool        thread_multiple;  /// MPI_THREAD_MULTIPLE granted by MPI_Init_thread
+
+  #if defined (ENABLE_MPI)
+  MPI_Comm    comm;             /// private duplicate of MPI_COMM_WORLD, keeps us apart from the monitor collectives
+  MPI_Comm    speed_comm;       /// duplicate of comm for the speed exchange, the monitor thread has its own traffic on comm
+  MPI_Request speed_req;        /// the one speed exchange of this rank, MPI_REQUEST_NULL once it completed
+  #endif
+
+  /// static split weighted by the autotuned speed of each rank
+
+  bool        speed_split;
+  bool        speed_pending;    /// speeds not exchanged yet, straight mode keeps the dicts undivided until then
+  bool        speed_posted;     /// this rank joined the exchange, every rank joins it exactly once
+  double     *speeds;           /// candidates per msec, one per rank
+  double      speed_own;        /// send buffer of the speed exchange
+
+  /// straight mode, words x rules tiles if the dicts are too small to keep every rank busy
+
+  u32         rule_groups;      /// rank id runs rule group id % rule_groups and word group id / rule_groups, 1 if only the words are split
+
+  /// -a 3 with several masks, the keyspaces of all masks laid end to end and split once
+
+  u64        *mask_plan;        /// offset of each mask in the combined keyspace, masks_cnt + 1 entries, NULL if every mask is split on its own
+  u64         plan_start;       /// [plan_start, plan_end) of the combined keyspace is ours
+  u64         plan_end;
+
+  /// node topology (--mm-node-topology), news travel rank -> node leader -> other leaders -> their nodes
+
+  bool        topology;
+  int        *leader_of;        /// lowest rank on the node of each rank
+  int         node_size;
+  int         node_done_cnt;    /// leaders only, ranks of the node without work left
+  void      **node_owners[MM_NODE_SHARES_MAX]; /// fields pointing into node_wins
+  u32         node_shares_cnt;
+
+  #if defined (ENABLE_MPI)
+  MPI_Comm    node_comm;
+  MPI_Win     node_wins[MM_NODE_SHARES_MAX];
+  #endif
+
+  /// stop propagation, polled by the monitor thread
+
+  bool        done_sent;        /// our DONE went out to rank 0
+  int         done_cnt;         /// rank 0 only, ranks without work left
+  bool        stop_sent;        /// we broadcast a STOP ourselves
+  bool        crack_origin;     /// ... because we cracked the target
+  int         acks_cnt;         /// ranks that confirmed our crack STOP
+  hc_timer_t  crack_timer;      /// started by mycracked()
+  double      stop_msec;        /// crack to the last confirmation
+  bool        stop_recorded;    /// stop_msec holds the time already
+  int         notify_msg[4][2]; /// constant send buffers, { event, origin } per event
+  int         done_msg[2][2];   /// { MM_EVENT_FINISHED, ranks done } for one rank and for a whole node
+  int         stop_msg[2];      /// the STOP a leader passes on
+
+  #if defined (ENABLE_MPI)
+  MPI_Request *reqs;            /// outstanding MPI_Issend
+  u32          reqs_cnt;
+  u32          reqs_avail;
+  #endif
+
+  /// rank 0 builds the kernel cache for everybody (--mm-bcast-init)
+
+  char      **kernel_files;
+  u32         kernel_files_cnt;
+  u32         kernel_files_avail;
+
+  /// multi-target mode, every crack goes to every rank
+
+  bool        multi_target;
+  u32        *share_buf;        /// { salt_pos, hash_pos } pairs not sent yet
+  u32         share_cnt;
+  u32         share_avail;
+  void      **share_sent;       /// send buffers, kept until mm_notify_finish()
+  u32         share_sent_cnt;
+  u32         share_sent_avail;
+  char      **cracks;           /// "hash:plain" of every local crack
+  u32         cracks_cnt;
+  u32         cracks_avail;
+  u32         cracks_logged;
+
+  /// cluster checkpoint (--mm-cluster-restore), rank 0 keeps the finished ranges of all ranks
+
+  bool        ckpt;
+  bool        ckpt_write;       /// ... and rank 0 writes them next to the restore file, without it only --mm-degraded tracks
+  bool        ckpt_active;      /// the current epoch is tracked
+  bool        ckpt_resumed;     /// ... and only its unfinished ranges are run, from ckpt_queue
+  u32         ckpt_epoch;
+  u64         ckpt_total;
+  u64         ckpt_base;        /// epoch index of local word 0, straight mode slices start inside the dict
+  mm_range_t *ckpt_own;         /// ranges of the current epoch handed to us, done up to words_cur
+  u32         ckpt_own_cnt;
+  u32         ckpt_own_avail;
+  mm_range_t *ckpt_done;        /// finished ranges not reported yet
+  u32         ckpt_done_cnt;
+  u32         ckpt_done_avail;
+  mm_range_t *ckpt_restored;    /// finished ranges of the earlier session, the same on every rank
+  u32         ckpt_restored_cnt;
+  u32         ckpt_restored_avail;
+  mm_range_t *ckpt_set;         /// rank 0 only, the restored ranges plus everything reported since
+  u32         ckpt_set_cnt;
+  u32         ckpt_set_avail;
+  mm_range_t *ckpt_left;        /// unfinished ranges of a resumed epoch
+  u32         ckpt_left_cnt;
+  u32         ckpt_left_avail;
+  mm_range_t *ckpt_queue;       /// our part of ckpt_left, not started yet
+  u32         ckpt_queue_cnt;
+  u32         ckpt_queue_pos;
+  u32         ckpt_queue_avail;
+
+  /// shared reader (--mm-shared-reader), one thread per rank filters the dict into batches for all devices
+
+  bool              reader;
+  bool              reader_done;      /// the reader left, nothing comes after what is in the ring
+  bool              reader_error;     /// the reader failed, the words after what is in the ring were never read
+  bool              reader_quit;      /// the devices left, the reader must not wait for a free slot anymore
+  mm_batch_t       *reader_ring;
+  u32               reader_size;      /// batches in the ring
+  u32               reader_batch;     /// pw_t per batch, fits into the pws_buf of each of our devices
+  u32               reader_head;      /// oldest batch ready
+  u32               reader_cnt;       /// batches ready
+  u64               reader_off;       /// words_off of the last claim of the reader, see get_work()
+  u32               reader_stride;    /// --mm-pack-pws, u32 per packed candidate: pw_len and the words, 0 if not packed
+  hc_thread_t       reader_thread;
+  hc_thread_mutex_t mux_reader;
+
+  /// degraded mode (--mm-degraded), a failed rank drops out and the others take over what it left
+
+  bool        degraded;
+  bool        failed;           /// this rank hit an error and stopped its own attack only
+  u32         repairs;          /// passes run over the ranges left by failed ranks
+
+  /// dynamic work dispenser, one global counter per (mask, dict) epoch
+
+  bool        dynamic;
+  u32         epochs_cnt;
+  u32         epoch;
+  u64         epoch_total;      /// unamplified keyspace of the current epoch
+  bool        drained;          /// no chunks left in the current epoch
+  u64         chunk_min;        /// never hand out less than one full batch
+  u64         chunk_size;       /// next chunk size, scaled by measured speed
+  u64         chunk_words;      /// words of the chunk currently processed
+  u64         claimed_seen;     /// the epoch counter right behind our last claim
+  hc_timer_t  chunk_timer;
+  u64        *counters;         /// lives in rank 0's window if MPI is enabled
+
+  #if defined (ENABLE_MPI)
+  MPI_Win     win;
+  #endif
+
+} mm_ctx_t;
+
 typedef struct hashcat_ctx
 {
   bitmap_ctx_t          *bitmap_ctx;
@@ -1916,6 +2346,7 @@ typedef struct hashcat_ctx
   logfile_ctx_t         *logfile_ctx;
   loopback_ctx_t        *loopback_ctx;
   mask_ctx_t            *mask_ctx;
+  mm_ctx_t              *mm_ctx;
   opencl_ctx_t          *opencl_ctx;
   outcheck_ctx_t        *outcheck_ctx;
   outfile_ctx_t         *outfile_ctx;
@@ -1933,6 +2364,7 @@ typedef struct hashcat_ctx
   int                   cur_proc_id;  /// 0-index 
 
   mm_extend_fd_t       *fd_list;
+  u32                   fd_list_cnt;  /// entries of fd_list, one per dict
   int                   cracked[3];   /// 0 cracked, 1 finished, 2 err happened
   u8*                   mm_crack_buf; /// faciliate log out
   u8*                   mm_hostname;  /// faciliate mpi debug
@@ -9,10 +9,12 @@
 #include <time.h>
 #include <inttypes.h>
 #include "mm_impl.h"
+#include "mm_dict.h"
 
 u32 convert_from_hex (hashcat_ctx_t *hashcat_ctx, char *line_buf, const u32 line_len);
 
-void pw_add (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len);
+void pw_add     (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len);
+void pw_add_buf (pw_t *pws_buf, u32 *pws_cnt, const u8 *pw_buf, const int pw_len);
 
 void get_next_word_lm  (char *buf, u64 sz, u64 *len, u64 *off);
 void get_next_word_uc  (char *buf, u64 sz, u64 *len, u64 *off);
@@ -61,6 +61,8 @@ static int autotune (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
 
   if ((kernel_accel_min == kernel_accel_max) && (kernel_loops_min == kernel_loops_max))
   {
+    double exec_msec = 0;
+
     #if defined (DEBUG)
 
     // don't do any autotune in debug mode in this case
@@ -73,7 +75,8 @@ static int autotune (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
       try_run (hashcat_ctx, device_param, kernel_accel, kernel_loops);
       try_run (hashcat_ctx, device_param, kernel_accel, kernel_loops);
       try_run (hashcat_ctx, device_param, kernel_accel, kernel_loops);
-      try_run (hashcat_ctx, device_param, kernel_accel, kernel_loops);
+
+      exec_msec = try_run (hashcat_ctx, device_param, kernel_accel, kernel_loops);
     }
 
     #endif
@@ -85,6 +88,8 @@ static int autotune (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
 
     device_param->kernel_power = kernel_power;
 
+    device_param->autotune_speed = (exec_msec > 0) ? ((double) kernel_power * kernel_loops) / exec_msec : 0;
+
     return 0;
   }
 
@@ -235,6 +240,10 @@ static int autotune (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
     }
   }
 
+  // candidates per msec, the accel scaling below does not change that
+
+  const double autotune_speed = (exec_msec_pre_final > 0) ? ((double) device_param->device_processors * device_param->kernel_threads_by_user * kernel_accel * kernel_loops) / exec_msec_pre_final : 0;
+
   const u32 exec_left = target_msec / exec_msec_pre_final;
 
   const u32 accel_left = kernel_accel_max / kernel_accel;
@@ -303,6 +312,8 @@ static int autotune (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
 
   device_param->kernel_power = kernel_power;
 
+  device_param->autotune_speed = autotune_speed;
+
   #if defined (DEBUG)
 
   user_options_t *user_options = hashcat_ctx->user_options;
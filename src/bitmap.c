@@ -49,6 +49,55 @@ static u32 generate_bitmaps (const u32 digests_cnt, const u32 dgst_size, const u
   return collisions;
 }
 
+/// check () of inc_common.cl for one word of the digest, on random words. the words of a digest go to their own bitmaps and
+/// are independent, so the false positive rate of the whole check is the product of the four rates
+static u32 probe_bitmaps (const u32 *bitmap_s1, const u32 *bitmap_s2, const u32 bitmap_mask, const u32 bitmap_shift1, const u32 bitmap_shift2, u32 *s1_hits)
+{
+  u32 seed = 0x2545f491;
+
+  u32 hits = 0;
+
+  *s1_hits = 0;
+
+  for (u32 i = 0; i < BITMAP_PROBES; i++)
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed <<  5;
+
+    const u32 val = 1u << (seed & 0x1f);
+
+    if ((bitmap_s1[(seed >> bitmap_shift1) & bitmap_mask] & val) == 0) continue;
+
+    *s1_hits += 1;
+
+    if ((bitmap_s2[(seed >> bitmap_shift2) & bitmap_mask] & val) == 0) continue;
+
+    hits++;
+  }
+
+  return hits;
+}
+
+static double measure_bitmaps (const u32 bitmap_mask, const u32 bitmap_shift1, const u32 bitmap_shift2, u32 *bitmap_s1[4], u32 *bitmap_s2[4], double *fill)
+{
+  double fpr = 1.0;
+
+  *fill = 0.0;
+
+  for (int i = 0; i < 4; i++)
+  {
+    u32 s1_hits = 0;
+
+    const u32 hits = probe_bitmaps (bitmap_s1[i], bitmap_s2[i], bitmap_mask, bitmap_shift1, bitmap_shift2, &s1_hits);
+
+    fpr   *= (double) hits    / BITMAP_PROBES;
+    *fill += (double) s1_hits / BITMAP_PROBES / 4;
+  }
+
+  return fpr;
+}
+
 int bitmap_ctx_init (hashcat_ctx_t *hashcat_ctx)
 {
   bitmap_ctx_t   *bitmap_ctx   = hashcat_ctx->bitmap_ctx;
@@ -73,7 +122,8 @@ int bitmap_ctx_init (hashcat_ctx_t *hashcat_ctx)
    */
 
   const u32 bitmap_shift1 = 5;
-  const u32 bitmap_shift2 = 13;
+
+  u32 bitmap_shift2 = 13;
 
   const u32 bitmap_min = user_options->bitmap_min;
   const u32 bitmap_max = user_options->bitmap_max;
@@ -117,6 +167,75 @@ int bitmap_ctx_init (hashcat_ctx_t *hashcat_ctx)
   generate_bitmaps (hashes->digests_cnt, hashconfig->dgst_size, bitmap_shift1, (char *) hashes->digests_buf, hashconfig->dgst_pos0, hashconfig->dgst_pos1, hashconfig->dgst_pos2, hashconfig->dgst_pos3, bitmap_mask, bitmap_size, bitmap_s1_a, bitmap_s1_b, bitmap_s1_c, bitmap_s1_d, -1ul);
   generate_bitmaps (hashes->digests_cnt, hashconfig->dgst_size, bitmap_shift2, (char *) hashes->digests_buf, hashconfig->dgst_pos0, hashconfig->dgst_pos1, hashconfig->dgst_pos2, hashconfig->dgst_pos3, bitmap_mask, bitmap_size, bitmap_s2_a, bitmap_s2_b, bitmap_s2_c, bitmap_s2_d, -1ul);
 
+  /**
+   * measure what the kernels will see, the bitmaps only matter to the multi-hash kernels
+   */
+
+  u32 *bitmap_s1[4] = { bitmap_s1_a, bitmap_s1_b, bitmap_s1_c, bitmap_s1_d };
+  u32 *bitmap_s2[4] = { bitmap_s2_a, bitmap_s2_b, bitmap_s2_c, bitmap_s2_d };
+
+  double bitmap_fill = 0.0;
+  double bitmap_fpr  = 0.0;
+
+  if ((user_options->benchmark == false) && (hashes->digests_cnt > 1))
+  {
+    bitmap_fpr = measure_bitmaps (bitmap_mask, bitmap_shift1, bitmap_shift2, bitmap_s1, bitmap_s2, &bitmap_fill);
+
+    /**
+     * --mm-bitmap-fpr, grow the bitmaps until the measured rate is low enough. s2 may look at other bits of the digest
+     * than the default shift, once the bitmaps are that wide the default makes s2 look at the same bits as s1
+     */
+
+    double fpr_target = 1.0;
+
+    for (u32 i = 0; i < user_options->mm_bitmap_fpr; i++) fpr_target /= 10;
+
+    while ((user_options->mm_bitmap_fpr > 0) && (bitmap_fpr > fpr_target) && (bitmap_bits < bitmap_max))
+    {
+      bitmap_bits++;
+
+      bitmap_nums = 1u << bitmap_bits;
+
+      bitmap_mask = bitmap_nums - 1;
+
+      bitmap_size = bitmap_nums * sizeof (u32);
+
+      generate_bitmaps (hashes->digests_cnt, hashconfig->dgst_size, bitmap_shift1, (char *) hashes->digests_buf, hashconfig->dgst_pos0, hashconfig->dgst_pos1, hashconfig->dgst_pos2, hashconfig->dgst_pos3, bitmap_mask, bitmap_size, bitmap_s1_a, bitmap_s1_b, bitmap_s1_c, bitmap_s1_d, -1ul);
+
+      const u32 shifts[3] = { 13, 32 - bitmap_bits, bitmap_shift1 + bitmap_bits };
+
+      u32 shift_best = shifts[0];
+      u32 shift_last = shifts[0];
+
+      bitmap_fpr = 1.0;
+
+      for (int i = 0; i < 3; i++)
+      {
+        if (shifts[i] >= 32) continue;
+
+        generate_bitmaps (hashes->digests_cnt, hashconfig->dgst_size, shifts[i], (char *) hashes->digests_buf, hashconfig->dgst_pos0, hashconfig->dgst_pos1, hashconfig->dgst_pos2, hashconfig->dgst_pos3, bitmap_mask, bitmap_size, bitmap_s2_a, bitmap_s2_b, bitmap_s2_c, bitmap_s2_d, -1ul);
+
+        double fill = 0.0;
+
+        const double fpr = measure_bitmaps (bitmap_mask, bitmap_shift1, shifts[i], bitmap_s1, bitmap_s2, &fill);
+
+        shift_last = shifts[i];
+
+        if ((i > 0) && (fpr >= bitmap_fpr)) continue;
+
+        shift_best  = shifts[i];
+        bitmap_fpr  = fpr;
+        bitmap_fill = fill;
+      }
+
+      bitmap_shift2 = shift_best;
+
+      if (shift_best == shift_last) continue;
+
+      generate_bitmaps (hashes->digests_cnt, hashconfig->dgst_size, bitmap_shift2, (char *) hashes->digests_buf, hashconfig->dgst_pos0, hashconfig->dgst_pos1, hashconfig->dgst_pos2, hashconfig->dgst_pos3, bitmap_mask, bitmap_size, bitmap_s2_a, bitmap_s2_b, bitmap_s2_c, bitmap_s2_d, -1ul);
+    }
+  }
+
   bitmap_ctx->bitmap_bits   = bitmap_bits;
   bitmap_ctx->bitmap_nums   = bitmap_nums;
   bitmap_ctx->bitmap_size   = bitmap_size;
@@ -133,6 +252,9 @@ int bitmap_ctx_init (hashcat_ctx_t *hashcat_ctx)
   bitmap_ctx->bitmap_s2_c   = bitmap_s2_c;
   bitmap_ctx->bitmap_s2_d   = bitmap_s2_d;
 
+  bitmap_ctx->bitmap_fill   = bitmap_fill;
+  bitmap_ctx->bitmap_fpr    = bitmap_fpr;
+
   return 0;
 }
 
@@ -10,6 +10,8 @@
 #include "combinator.h"
 #include "shared.h"
 #include "wordlist.h"
+#include "mm_impl.h"
+#include "mm_dict.h"
 
 int combinator_ctx_init (hashcat_ctx_t *hashcat_ctx)
 {
@@ -62,77 +64,26 @@ int combinator_ctx_init (hashcat_ctx_t *hashcat_ctx)
       return -1;
     }
 
-    FILE *fp1 = NULL;
-    FILE *fp2 = NULL;
+    /// the dicts are fixed-width records, their size tells how many words they hold
+    mm_extend_fd_t mfd1;
+    mm_extend_fd_t mfd2;
 
-    if ((fp1 = fopen (dictfile1, "rb")) == NULL)
-    {
-      event_log_error (hashcat_ctx, "%s: %s", dictfile1, strerror (errno));
-
-      return -1;
-    }
-
-    if ((fp2 = fopen (dictfile2, "rb")) == NULL)
-    {
-      event_log_error (hashcat_ctx, "%s: %s", dictfile2, strerror (errno));
-
-      fclose (fp1);
-
-      return -1;
-    }
+    memset (&mfd1, 0, sizeof (mm_extend_fd_t));
+    memset (&mfd2, 0, sizeof (mm_extend_fd_t));
 
-    mm_extend_fd_t * mfp1 = create_mm_fd();
-    mm_extend_fd_t * mfp2 = create_mm_fd();
+    if (get_entry_cnt (hashcat_ctx, dictfile1, &mfd1) == -1) return -1;
+    if (get_entry_cnt (hashcat_ctx, dictfile2, &mfd2) == -1) return -1;
 
-    combinator_ctx->combs_cnt = 1;
+    const u64 words1_cnt = mfd1.words_cnt;
+    const u64 words2_cnt = mfd2.words_cnt;
 
-    u64 words1_cnt = 0;
-
-
-    const int rc1 = count_words (hashcat_ctx, mfp1, fp1, dictfile1, &words1_cnt);
-
-    if (rc1 == -1)
-    {
-      event_log_error (hashcat_ctx, "Integer overflow detected in keyspace of wordlist: %s", dictfile1);
-
-      fclose (fp1);
-      fclose (fp2);
-
-      destory_mm_fd(mfp1);
-      destory_mm_fd(mfp2);
-
-      return -1;
-    }
+    release_entry_cnt (&mfd1);
+    release_entry_cnt (&mfd2);
 
     if (words1_cnt == 0)
     {
       event_log_error (hashcat_ctx, "%s: empty file.", dictfile1);
 
-      fclose (fp1);
-      fclose (fp2);
-
-      destory_mm_fd(mfp1);
-      destory_mm_fd(mfp2);
-
-      return -1;
-    }
-
-    combinator_ctx->combs_cnt = 1;
-
-    u64 words2_cnt = 0;
-
-    const int rc2 = count_words (hashcat_ctx, mfp2, fp2, dictfile2, &words2_cnt);
-
-    if (rc2 == -1)
-    {
-      event_log_error (hashcat_ctx, "Integer overflow detected in keyspace of wordlist: %s", dictfile2);
-
-      fclose (fp1);
-      fclose (fp2);
-
-      destory_mm_fd(mfp1);
-      destory_mm_fd(mfp2);
-
       return -1;
     }
 
@@ -140,33 +91,23 @@ int combinator_ctx_init (hashcat_ctx_t *hashcat_ctx)
     {
       event_log_error (hashcat_ctx, "%s: empty file.", dictfile2);
 
-      fclose (fp1);
-      fclose (fp2);
-
-      destory_mm_fd(mfp1);
-      destory_mm_fd(mfp2);
-
       return -1;
     }
 
-    fclose (fp1);
-    fclose (fp2);
-
-    destory_mm_fd(mfp1);
-    destory_mm_fd(mfp2);
-
     combinator_ctx->dict1 = dictfile1;
     combinator_ctx->dict2 = dictfile2;
 
     if (words1_cnt >= words2_cnt)
     {
-      combinator_ctx->combs_mode = COMBINATOR_MODE_BASE_LEFT;
-      combinator_ctx->combs_cnt  = words2_cnt;
+      combinator_ctx->combs_mode  = COMBINATOR_MODE_BASE_LEFT;
+      combinator_ctx->combs_cnt   = words2_cnt;
+      combinator_ctx->combs_width = mfd2.word_base;
     }
     else
     {
-      combinator_ctx->combs_mode = COMBINATOR_MODE_BASE_RIGHT;
-      combinator_ctx->combs_cnt  = words1_cnt;
+      combinator_ctx->combs_mode  = COMBINATOR_MODE_BASE_RIGHT;
+      combinator_ctx->combs_cnt   = words1_cnt;
+      combinator_ctx->combs_width = mfd1.word_base;
 
       // we also have to switch wordlist related rules!
 
@@ -180,6 +121,14 @@ int combinator_ctx_init (hashcat_ctx_t *hashcat_ctx)
       user_options_extra->rule_len_l = user_options_extra->rule_len_r;
       user_options_extra->rule_len_r = tmpi;
     }
+
+    /// run_cracker() reads the amplifier records into scratch_buf
+    if (combinator_ctx->combs_width >= HCBUFSIZ_LARGE)
+    {
+      event_log_error (hashcat_ctx, "%s: Record width %" PRIu64 " is too large.", (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT) ? dictfile2 : dictfile1, combinator_ctx->combs_width);
+
+      return -1;
+    }
   }
   else if (user_options->attack_mode == ATTACK_MODE_BF)
   {
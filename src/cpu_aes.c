@@ -1360,3 +1360,186 @@ void AES128_decrypt_cbc (const u32 key[4], const u32 iv[4], const u32 in[16], u3
     _iv[3] = _in[3];
   }
 }
+
+// AES-256-CBC decryption of whole blocks, used by the hooks on the host. AES-NI when the CPU has it
+
+#if (defined (__x86_64__) || defined (__i386__)) && (defined (__GNUC__) || defined (__clang__))
+#define WITH_AES_NI
+#endif
+
+#if defined (WITH_AES_NI)
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+
+static int aes_ni_available (void)
+{
+  static int available = -1;
+
+  if (available == -1)
+  {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+
+    available = (__get_cpuid (1, &eax, &ebx, &ecx, &edx) == 1) && (ecx & bit_AES);
+  }
+
+  return available;
+}
+
+#define AES256_NI_ASSIST1(k0,k1,rcon)                         \
+{                                                             \
+  __m128i t = _mm_aeskeygenassist_si128 ((k1), (rcon));       \
+  t  = _mm_shuffle_epi32 (t, 0xff);                           \
+  __m128i s = _mm_slli_si128 (k0, 4);                         \
+  k0 = _mm_xor_si128 (k0, s);                                 \
+  s  = _mm_slli_si128 (s, 4);                                 \
+  k0 = _mm_xor_si128 (k0, s);                                 \
+  s  = _mm_slli_si128 (s, 4);                                 \
+  k0 = _mm_xor_si128 (k0, s);                                 \
+  k0 = _mm_xor_si128 (k0, t);                                 \
+}
+
+#define AES256_NI_ASSIST2(k0,k1)                              \
+{                                                             \
+  __m128i t = _mm_aeskeygenassist_si128 ((k0), 0);            \
+  t  = _mm_shuffle_epi32 (t, 0xaa);                           \
+  __m128i s = _mm_slli_si128 (k1, 4);                         \
+  k1 = _mm_xor_si128 (k1, s);                                 \
+  s  = _mm_slli_si128 (s, 4);                                 \
+  k1 = _mm_xor_si128 (k1, s);                                 \
+  s  = _mm_slli_si128 (s, 4);                                 \
+  k1 = _mm_xor_si128 (k1, s);                                 \
+  k1 = _mm_xor_si128 (k1, t);                                 \
+}
+
+__attribute__ ((target ("aes,sse2")))
+static void AES256_decrypt_cbc_ni (const u8 *key, const u32 iv[4], const u32 *in, u32 *out, const u32 blocks_cnt)
+{
+  __m128i ek[15];
+  __m128i dk[15];
+
+  __m128i k0 = _mm_loadu_si128 ((const __m128i *) (key +  0));
+  __m128i k1 = _mm_loadu_si128 ((const __m128i *) (key + 16));
+
+  ek[ 0] = k0;
+  ek[ 1] = k1;
+
+  AES256_NI_ASSIST1 (k0, k1, 0x01); ek[ 2] = k0; AES256_NI_ASSIST2 (k0, k1); ek[ 3] = k1;
+  AES256_NI_ASSIST1 (k0, k1, 0x02); ek[ 4] = k0; AES256_NI_ASSIST2 (k0, k1); ek[ 5] = k1;
+  AES256_NI_ASSIST1 (k0, k1, 0x04); ek[ 6] = k0; AES256_NI_ASSIST2 (k0, k1); ek[ 7] = k1;
+  AES256_NI_ASSIST1 (k0, k1, 0x08); ek[ 8] = k0; AES256_NI_ASSIST2 (k0, k1); ek[ 9] = k1;
+  AES256_NI_ASSIST1 (k0, k1, 0x10); ek[10] = k0; AES256_NI_ASSIST2 (k0, k1); ek[11] = k1;
+  AES256_NI_ASSIST1 (k0, k1, 0x20); ek[12] = k0; AES256_NI_ASSIST2 (k0, k1); ek[13] = k1;
+  AES256_NI_ASSIST1 (k0, k1, 0x40); ek[14] = k0;
+
+  dk[0] = ek[14];
+
+  for (int i = 1; i < 14; i++) dk[i] = _mm_aesimc_si128 (ek[14 - i]);
+
+  dk[14] = ek[0];
+
+  __m128i prev = _mm_loadu_si128 ((const __m128i *) iv);
+
+  u32 block = 0;
+
+  // the blocks of CBC decryption do not depend on each other, keep four of them in flight
+
+  for (; block + 4 <= blocks_cnt; block += 4)
+  {
+    const __m128i c0 = _mm_loadu_si128 ((const __m128i *) (in + (block + 0) * 4));
+    const __m128i c1 = _mm_loadu_si128 ((const __m128i *) (in + (block + 1) * 4));
+    const __m128i c2 = _mm_loadu_si128 ((const __m128i *) (in + (block + 2) * 4));
+    const __m128i c3 = _mm_loadu_si128 ((const __m128i *) (in + (block + 3) * 4));
+
+    __m128i p0 = _mm_xor_si128 (c0, dk[0]);
+    __m128i p1 = _mm_xor_si128 (c1, dk[0]);
+    __m128i p2 = _mm_xor_si128 (c2, dk[0]);
+    __m128i p3 = _mm_xor_si128 (c3, dk[0]);
+
+    for (int i = 1; i < 14; i++)
+    {
+      p0 = _mm_aesdec_si128 (p0, dk[i]);
+      p1 = _mm_aesdec_si128 (p1, dk[i]);
+      p2 = _mm_aesdec_si128 (p2, dk[i]);
+      p3 = _mm_aesdec_si128 (p3, dk[i]);
+    }
+
+    p0 = _mm_xor_si128 (_mm_aesdeclast_si128 (p0, dk[14]), prev);
+    p1 = _mm_xor_si128 (_mm_aesdeclast_si128 (p1, dk[14]), c0);
+    p2 = _mm_xor_si128 (_mm_aesdeclast_si128 (p2, dk[14]), c1);
+    p3 = _mm_xor_si128 (_mm_aesdeclast_si128 (p3, dk[14]), c2);
+
+    _mm_storeu_si128 ((__m128i *) (out + (block + 0) * 4), p0);
+    _mm_storeu_si128 ((__m128i *) (out + (block + 1) * 4), p1);
+    _mm_storeu_si128 ((__m128i *) (out + (block + 2) * 4), p2);
+    _mm_storeu_si128 ((__m128i *) (out + (block + 3) * 4), p3);
+
+    prev = c3;
+  }
+
+  for (; block < blocks_cnt; block++)
+  {
+    const __m128i c = _mm_loadu_si128 ((const __m128i *) (in + block * 4));
+
+    __m128i p = _mm_xor_si128 (c, dk[0]);
+
+    for (int i = 1; i < 14; i++) p = _mm_aesdec_si128 (p, dk[i]);
+
+    p = _mm_xor_si128 (_mm_aesdeclast_si128 (p, dk[14]), prev);
+
+    _mm_storeu_si128 ((__m128i *) (out + block * 4), p);
+
+    prev = c;
+  }
+}
+
+#endif // WITH_AES_NI
+
+void AES256_decrypt_cbc (const u8 *key, const u32 iv[4], const u32 *in, u32 *out, const u32 blocks_cnt)
+{
+  #if defined (WITH_AES_NI)
+  if (aes_ni_available () == 1)
+  {
+    AES256_decrypt_cbc_ni (key, iv, in, out, blocks_cnt);
+
+    return;
+  }
+  #endif
+
+  AES_KEY skey;
+
+  AES_set_decrypt_key (key, 256, &skey);
+
+  u32 _iv[4];
+
+  _iv[0] = iv[0];
+  _iv[1] = iv[1];
+  _iv[2] = iv[2];
+  _iv[3] = iv[3];
+
+  for (u32 i = 0; i < blocks_cnt * 4; i += 4)
+  {
+    u32 _in[4];
+    u32 _out[4];
+
+    _in[0] = in[i + 0];
+    _in[1] = in[i + 1];
+    _in[2] = in[i + 2];
+    _in[3] = in[i + 3];
+
+    AES_decrypt (&skey, (const u8 *) _in, (u8 *) _out);
+
+    out[i + 0] = _out[0] ^ _iv[0];
+    out[i + 1] = _out[1] ^ _iv[1];
+    out[i + 2] = _out[2] ^ _iv[2];
+    out[i + 3] = _out[3] ^ _iv[3];
+
+    _iv[0] = _in[0];
+    _iv[1] = _in[1];
+    _iv[2] = _in[2];
+    _iv[3] = _in[3];
+  }
+}
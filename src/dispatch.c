@@ -15,6 +15,8 @@
 #include "filehandling.h"
 #include "rp_cpu.h"
 #include "dispatch.h"
+#include "mm_impl.h"
+#include "mm_dict.h"
 
 static u64 get_lowest_words_done (const hashcat_ctx_t *hashcat_ctx)
 {
@@ -76,22 +78,35 @@ static u32 get_power (opencl_ctx_t *opencl_ctx, hc_device_param_t *device_param)
 
 static u32 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 max)
 {
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
   opencl_ctx_t   *opencl_ctx   = hashcat_ctx->opencl_ctx;
   status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
   user_options_t *user_options = hashcat_ctx->user_options;
 
   hc_thread_mutex_lock (status_ctx->mux_dispatcher);
 
+  if ((mm_ctx->dynamic == true) || (mm_ctx->ckpt_resumed == true))
+  {
+    if (status_ctx->words_off >= status_ctx->words_base) mm_work_refill (hashcat_ctx);
+  }
+
   const u64 words_off  = status_ctx->words_off;
   const u64 words_base = (user_options->limit == 0) ? status_ctx->words_base : MIN (user_options->limit, status_ctx->words_base);
 
-  device_param->words_off = words_off;
+  /// without a device it is the shared reader claiming a batch
+  if (device_param != NULL) device_param->words_off = words_off;
+  else                      mm_ctx->reader_off     = words_off;
 
   const u64 kernel_power_all = opencl_ctx->kernel_power_all;
 
   const u64 words_left = words_base - words_off;
 
-  if (words_left < kernel_power_all)
+  // with the dynamic dispenser or a resumed epoch only the last chunk of the epoch is a real tail
+
+  const bool last_chunk = ((mm_ctx->dynamic == false) && (mm_ctx->ckpt_resumed == false))
+                       || ((mm_ctx->drained == true) && (mm_ctx->ckpt_queue_pos == mm_ctx->ckpt_queue_cnt));
+
+  if ((words_left < kernel_power_all) && (last_chunk == true))
   {
     if (opencl_ctx->kernel_power_final == 0)
     {
@@ -99,7 +114,7 @@ static u32 get_work (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
     }
   }
 
-  const u32 kernel_power = get_power (opencl_ctx, device_param);
+  const u32 kernel_power = (device_param != NULL) ? get_power (opencl_ctx, device_param) : mm_ctx->reader_batch;
 
   u32 work = MIN (words_left, kernel_power);
 
@@ -311,18 +326,466 @@ void *thread_calc_stdin (void *p)
   return NULL;
 }
 
-static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+/// read the words [words_off, words_fin) of the dict and add the ones passing the filters to pws_buf.
+/// returns how many of them got rejected
+static u32 calc_words (hashcat_ctx_t *hashcat_ctx, hashcat_ctx_t *hashcat_ctx_tmp, const mm_map_t *map, FILE *fd, u64 *words_cur, const u64 words_off, const u64 words_fin, pw_t *pws_buf, u32 *pws_cnt)
 {
   user_options_t       *user_options       = hashcat_ctx->user_options;
   user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
   hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
+  status_ctx_t         *status_ctx         = hashcat_ctx->status_ctx;
+
+  const u32 attack_kern = user_options_extra->attack_kern;
+
+  u32 words_extra = 0;
+
+  char *line_buf;
+  u32   line_len;
+
+  char rule_buf_out[BLOCK_SIZE];
+
+  char hex_buf[BLOCK_SIZE];
+
+  // fixed-width records, jump straight to the next word we own
+
+  if (map->base != NULL)
+  {
+    mm_map_advise (map, words_off, words_fin);
+
+    *words_cur = words_off;
+  }
+  else if (*words_cur != words_off)
+  {
+    mm_seek_word (hashcat_ctx_tmp, hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd, words_off);
+
+    *words_cur = words_off;
+  }
+
+  for ( ; *words_cur < words_fin; (*words_cur)++)
+  {
+    if (map->base != NULL)
+    {
+      mm_map_word (map, *words_cur, &line_buf, &line_len);
+
+      /// convert_from_hex() works in place and the mapping is read-only
+      if (((line_len & 1) == 0) && (line_len < BLOCK_SIZE) && ((user_options->hex_wordlist == true) || (is_hexify ((const u8 *) line_buf, (const int) line_len) == true)))
+      {
+        memcpy (hex_buf, line_buf, line_len);
+
+        hex_buf[line_len] = 0;
+
+        line_buf = hex_buf;
+        line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
+      }
+    }
+    else
+    {
+      get_next_word (hashcat_ctx_tmp, hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd, &line_buf, &line_len);
+
+      /// the dict could not be read any further
+      if (status_ctx->run_thread_level1 == false) break;
+
+      line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
+
+      u32 line_buf_len = strlen(line_buf);
+      line_len = (line_len < line_buf_len) ? line_len: line_buf_len;
+    }
+
+    // post-process rule engine
+
+    if (run_rule_engine ((int) user_options_extra->rule_len_l, user_options->rule_buf_l))
+    {
+      memset (rule_buf_out, 0, sizeof (rule_buf_out));
+
+      int rule_len_out = -1;
+
+      if (line_len < BLOCK_SIZE)
+      {
+        rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
+      }
+
+      if (rule_len_out < 0) continue;
+
+      line_buf = rule_buf_out;
+      line_len = (u32) rule_len_out;
+    }
+
+    if (attack_kern == ATTACK_KERN_STRAIGHT)
+    {
+      if ((line_len < hashconfig->pw_min) || (line_len > hashconfig->pw_max))
+      {
+        words_extra++;
+
+        continue;
+      }
+    }
+    else if (attack_kern == ATTACK_KERN_COMBI)
+    {
+      // do not check if minimum restriction is satisfied (line_len >= hashconfig->pw_min) here
+      // since we still need to combine the plains
+
+      if (line_len > hashconfig->pw_max)
+      {
+        words_extra++;
+
+        continue;
+      }
+    }
+
+    pw_add_buf (pws_buf, pws_cnt, (u8 *) line_buf, (int) line_len);
+
+    if (status_ctx->run_thread_level1 == false) break;
+  }
+
+  return words_extra;
+}
+
+/// --mm-shared-reader: take as many batches of thread_calc_reader() as fit the device into pws_buf, packed with --mm-pack-pws.
+/// returns how many batches we got, 0 once the reader is done and its ring is empty. without wait it takes only what is ready
+static u32 calc_shared_fill (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pw_t *pws_buf, u32 *pws_cnt, u64 *words_off, u64 *words_fin, u32 *words_extra, const bool wait)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  u32 batches_cnt = 0;
+
+  *pws_cnt     = 0;
+  *words_extra = 0;
+
+  while ((*pws_cnt + mm_ctx->reader_batch) <= device_param->kernel_power)
+  {
+    hc_thread_mutex_lock (mm_ctx->mux_reader);
+
+    mm_batch_t *batch = NULL;
+
+    /// the attack stops, calc_shared() reports it
+    if (mm_ctx->reader_error == true)
+    {
+      hc_thread_mutex_unlock (mm_ctx->mux_reader);
+
+      break;
+    }
+
+    if (mm_ctx->reader_cnt > 0)
+    {
+      batch = mm_ctx->reader_ring + mm_ctx->reader_head;
+
+      batch->busy = true;
+
+      mm_ctx->reader_head = (mm_ctx->reader_head + 1) % mm_ctx->reader_size;
+      mm_ctx->reader_cnt--;
+    }
+
+    const bool done = mm_ctx->reader_done;
+
+    hc_thread_mutex_unlock (mm_ctx->mux_reader);
+
+    if (batch == NULL)
+    {
+      /// rather crack what we got than wait for more
+      if ((done == true) || (batches_cnt > 0)) break;
+
+      if (wait == false) break;
+
+      if (status_ctx->run_thread_level1 == false) break;
+
+      hc_sleep_msec (1);
+
+      continue;
+    }
+
+    if (batches_cnt == 0) *words_off = batch->words_off;
+
+    if (device_param->pws_stride)
+    {
+      /// --mm-pack-pws: pw_len and as many words as the longest record needs
+      const u32 stride = device_param->pws_stride;
+
+      u32 *packed = (u32 *) pws_buf + (*pws_cnt * stride);
+
+      for (u32 i = 0; i < batch->pws_cnt; i++, packed += stride)
+      {
+        packed[0] = batch->pws[i].pw_len;
+
+        memcpy (packed + 1, batch->pws[i].i, (stride - 1) * sizeof (u32));
+      }
+    }
+    else
+    {
+      memcpy (pws_buf + *pws_cnt, batch->pws, batch->pws_cnt * sizeof (pw_t));
+    }
+
+    *pws_cnt += batch->pws_cnt;
+
+    *words_extra += batch->words_extra;
+
+    *words_fin = batch->words_fin;
+
+    batches_cnt++;
+
+    hc_thread_mutex_lock (mm_ctx->mux_reader);
+
+    batch->busy = false;
+
+    hc_thread_mutex_unlock (mm_ctx->mux_reader);
+  }
+
+  return batches_cnt;
+}
+
+/// --mm-shared-reader: crack the batches of thread_calc_reader().
+/// with --mm-pipeline the next batch is uploaded while the current one is cracked, if the reader has it ready by then
+static int calc_shared (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+{
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+
+  const bool pipeline = (device_param->d_pws_buf_next != NULL);
+
+  device_param->pws_stride = (device_param->d_pws_packed != NULL) ? mm_ctx->reader_stride : 0;
+
+  u64 words_off   = 0;
+  u64 words_fin   = 0;
+  u32 words_extra = 0;
+
+  const u32 batches_cnt = calc_shared_fill (hashcat_ctx, device_param, device_param->pws_buf, &device_param->pws_cnt, &words_off, &words_fin, &words_extra, true);
+
+  if (batches_cnt == 0) return (mm_ctx->reader_error == true) ? -1 : 0;
+
+  int CL_rc;
+
+  if (device_param->pws_cnt)
+  {
+    CL_rc = run_copy (hashcat_ctx, device_param, device_param->pws_cnt);
+
+    if (CL_rc == -1) return -1;
+  }
+
+  while (status_ctx->run_thread_level1 == true)
+  {
+    u32 next_batches_cnt = 0;
+    u32 next_pws_cnt     = 0;
+    u64 next_words_off   = 0;
+    u64 next_words_fin   = 0;
+    u32 next_words_extra = 0;
+
+    if (pipeline == true)
+    {
+      /// waiting for the reader here would hold back the kernels of the current batch
+      next_batches_cnt = calc_shared_fill (hashcat_ctx, device_param, device_param->pws_buf_next, &next_pws_cnt, &next_words_off, &next_words_fin, &next_words_extra, false);
+
+      if (next_pws_cnt)
+      {
+        CL_rc = run_copy_next (hashcat_ctx, device_param, next_pws_cnt);
+
+        if (CL_rc == -1) return -1;
+      }
+    }
+
+    device_param->words_off = words_off;
+
+    if (words_extra > 0)
+    {
+      hc_thread_mutex_lock (status_ctx->mux_counter);
+
+      for (u32 salt_pos = 0; salt_pos < hashes->salts_cnt; salt_pos++)
+      {
+        status_ctx->words_progress_rejected[salt_pos] += words_extra * straight_ctx->kernel_rules_cnt;
+      }
+
+      hc_thread_mutex_unlock (status_ctx->mux_counter);
+    }
+
+    const u32 pws_cnt = device_param->pws_cnt;
+
+    if (pws_cnt)
+    {
+      CL_rc = run_cracker (hashcat_ctx, device_param, pws_cnt);
+
+      if (CL_rc == -1) return -1;
+
+      device_param->pws_cnt = 0;
+    }
+
+    if (status_ctx->run_thread_level2 == true)
+    {
+      device_param->words_done = words_fin;
+
+      status_ctx->words_cur = get_lowest_words_done (hashcat_ctx);
+    }
+
+    if (next_batches_cnt > 0)
+    {
+      CL_rc = run_copy_swap (hashcat_ctx, device_param, next_pws_cnt);
+
+      if (CL_rc == -1) return -1;
+
+      device_param->pws_cnt = next_pws_cnt;
+
+      words_off   = next_words_off;
+      words_fin   = next_words_fin;
+      words_extra = next_words_extra;
+    }
+    else
+    {
+      /// nothing was prefetched, the kernels are done with d_pws_buf
+      const u32 next_cnt = calc_shared_fill (hashcat_ctx, device_param, device_param->pws_buf, &device_param->pws_cnt, &words_off, &words_fin, &words_extra, true);
+
+      if (next_cnt == 0) break;
+
+      if (device_param->pws_cnt)
+      {
+        CL_rc = run_copy (hashcat_ctx, device_param, device_param->pws_cnt);
+
+        if (CL_rc == -1) return -1;
+      }
+    }
+  }
+
+  /// stopped with an upload in flight, it must not outlive pws_buf_next
+  if (device_param->pws_event != NULL)
+  {
+    CL_rc = run_copy_swap (hashcat_ctx, device_param, 0);
+
+    if (CL_rc == -1) return -1;
+  }
+
+  if (mm_ctx->reader_error == true) return -1;
+
+  return 0;
+}
+
+/// --mm-shared-reader: read and filter the dict of this rank once, for all devices
+static int calc_reader (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+
+  char *dictfile = straight_ctx->dict;
+
+  FILE *fd = mm_dict_open (hashcat_ctx, dictfile);
+
+  if (fd == NULL)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", dictfile, strerror (errno));
+
+    return -1;
+  }
+
+  fseek (fd, (long) mm_word_offset (hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd, 0), SEEK_SET);
+
+  mm_map_t map;
+
+  mm_map_open (dictfile, hashcat_ctx->fd_list + straight_ctx->dicts_pos, &map);
+
+  hashcat_ctx_t *hashcat_ctx_tmp = (hashcat_ctx_t *) hcmalloc (sizeof (hashcat_ctx_t));
+
+  memcpy (hashcat_ctx_tmp, hashcat_ctx, sizeof (hashcat_ctx_t)); // yes we actually want to copy these pointers
+
+  hashcat_ctx_tmp->wl_data = (wl_data_t *) hcmalloc (sizeof (wl_data_t));
+
+  const int rc_wl_data_init = wl_data_init (hashcat_ctx_tmp);
+
+  if (rc_wl_data_init == -1)
+  {
+    fclose (fd);
+
+    mm_map_close (&map);
+
+    hcfree (hashcat_ctx_tmp->wl_data);
+
+    hcfree (hashcat_ctx_tmp);
+
+    return -1;
+  }
+
+  u64 words_cur = 0;
+
+  while (status_ctx->run_thread_level1 == true)
+  {
+    /// the slot after the newest batch, a device may still copy out what it had
+    hc_thread_mutex_lock (mm_ctx->mux_reader);
+
+    mm_batch_t *batch = mm_ctx->reader_ring + ((mm_ctx->reader_head + mm_ctx->reader_cnt) % mm_ctx->reader_size);
+
+    const bool quit = mm_ctx->reader_quit;
+    const bool full = (mm_ctx->reader_cnt == mm_ctx->reader_size) || (batch->busy == true);
+
+    hc_thread_mutex_unlock (mm_ctx->mux_reader);
+
+    if (quit == true) break;
+
+    if (full == true)
+    {
+      hc_sleep_msec (1);
+
+      continue;
+    }
+
+    batch->pws_cnt     = 0;
+    batch->words_extra = 0;
+
+    u64 claimed = 0;
+
+    u32 words_extra = -1u;
+
+    while (words_extra)
+    {
+      const u32 work = get_work (hashcat_ctx, NULL, words_extra);
+
+      if (work == 0) break;
+
+      const u64 words_off = mm_ctx->reader_off;
+      const u64 words_fin = words_off + work;
+
+      if (claimed == 0) batch->words_off = words_off;
+
+      batch->words_fin = words_fin;
+
+      claimed += work;
+
+      words_extra = calc_words (hashcat_ctx, hashcat_ctx_tmp, &map, fd, &words_cur, words_off, words_fin, batch->pws, &batch->pws_cnt);
+
+      batch->words_extra += words_extra;
+
+      if (status_ctx->run_thread_level1 == false) break;
+    }
+
+    if (claimed == 0) break;
+
+    hc_thread_mutex_lock (mm_ctx->mux_reader);
+
+    mm_ctx->reader_cnt++;
+
+    hc_thread_mutex_unlock (mm_ctx->mux_reader);
+  }
+
+  fclose (fd);
+
+  mm_map_close (&map);
+
+  wl_data_destroy (hashcat_ctx_tmp);
+
+  hcfree (hashcat_ctx_tmp->wl_data);
+
+  hcfree (hashcat_ctx_tmp);
+
+  return 0;
+}
+
+static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
+{
+  user_options_t       *user_options       = hashcat_ctx->user_options;
   hashes_t             *hashes             = hashcat_ctx->hashes;
   straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
   combinator_ctx_t     *combinator_ctx     = hashcat_ctx->combinator_ctx;
   status_ctx_t         *status_ctx         = hashcat_ctx->status_ctx;
 
   const u32 attack_mode = user_options->attack_mode;
-  const u32 attack_kern = user_options_extra->attack_kern;
 
   if (attack_mode == ATTACK_MODE_BF)
   {
@@ -361,13 +824,19 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
       if (status_ctx->run_thread_level1 == false) break;
     }
   }
+  else if (hashcat_ctx->mm_ctx->reader == true)
+  {
+    /// --mm-shared-reader: the dict was read and filtered for us already
+    const int rc_shared = calc_shared (hashcat_ctx, device_param);
+
+    if (rc_shared == -1) return -1;
+  }
   else
   {
     char *dictfile = straight_ctx->dict;
 
     if (attack_mode == ATTACK_MODE_COMBI)
     {
-#if 0
       if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT)
       {
         dictfile = combinator_ctx->dict1;
@@ -383,7 +852,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
       {
         const char *dictfilec = combinator_ctx->dict2;
 
-        FILE *combs_fp = fopen (dictfilec, "rb");
+        FILE *combs_fp = mm_dict_open (hashcat_ctx, dictfilec);
 
         if (combs_fp == NULL)
         {
@@ -398,7 +867,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
       {
         const char *dictfilec = combinator_ctx->dict1;
 
-        FILE *combs_fp = fopen (dictfilec, "rb");
+        FILE *combs_fp = mm_dict_open (hashcat_ctx, dictfilec);
 
         if (combs_fp == NULL)
         {
@@ -409,10 +878,9 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
         device_param->combs_fp = combs_fp;
       }
-#endif
     }
 
-    FILE *fd = fopen (dictfile, "rb");
+    FILE *fd = mm_dict_open (hashcat_ctx, dictfile);
 
     if (fd == NULL)
     {
@@ -421,7 +889,12 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
       return -1;
     }
 
-    fseek (fd, hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_start * hashcat_ctx->fd_list[straight_ctx->dicts_pos].word_base, SEEK_SET);
+    fseek (fd, (long) mm_word_offset (hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd, 0), SEEK_SET);
+
+    /// fixed-width records are taken right out of the page cache, fd stays the fallback
+    mm_map_t map;
+
+    mm_map_open (dictfile, hashcat_ctx->fd_list + straight_ctx->dicts_pos, &map);
 
     hashcat_ctx_t *hashcat_ctx_tmp = (hashcat_ctx_t *) hcmalloc (sizeof (hashcat_ctx_t));
 
@@ -463,6 +936,8 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
       fclose (fd);
 
+      mm_map_close (&map);
+
       ///@TODO what if err happened
       hcfree (hashcat_ctx_tmp->wl_data);
 
@@ -493,67 +968,7 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
         words_off = device_param->words_off;
         words_fin = words_off + work;
 
-        char *line_buf;
-        u32   line_len;
-
-        char rule_buf_out[BLOCK_SIZE];
-
-        for ( ; words_cur < words_off; words_cur++) get_next_word (hashcat_ctx_tmp, hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd,  &line_buf, &line_len);
-
-        for ( ; words_cur < words_fin; words_cur++)
-        {
-          get_next_word (hashcat_ctx_tmp, hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd, &line_buf, &line_len);
-
-          line_len = convert_from_hex (hashcat_ctx, line_buf, line_len);
-
-          u32 line_buf_len = strlen(line_buf);
-          line_len = (line_len < line_buf_len) ? line_len: line_buf_len;
-
-          // post-process rule engine
-
-          if (run_rule_engine ((int) user_options_extra->rule_len_l, user_options->rule_buf_l))
-          {
-            memset (rule_buf_out, 0, sizeof (rule_buf_out));
-
-            int rule_len_out = -1;
-
-            if (line_len < BLOCK_SIZE)
-            {
-              rule_len_out = _old_apply_rule (user_options->rule_buf_l, (int) user_options_extra->rule_len_l, line_buf, (int) line_len, rule_buf_out);
-            }
-
-            if (rule_len_out < 0) continue;
-
-            line_buf = rule_buf_out;
-            line_len = (u32) rule_len_out;
-          }
-
-          if (attack_kern == ATTACK_KERN_STRAIGHT)
-          {
-            if ((line_len < hashconfig->pw_min) || (line_len > hashconfig->pw_max))
-            {
-              words_extra++;
-
-              continue;
-            }
-          }
-          else if (attack_kern == ATTACK_KERN_COMBI)
-          {
-            // do not check if minimum restriction is satisfied (line_len >= hashconfig->pw_min) here
-            // since we still need to combine the plains
-
-            if (line_len > hashconfig->pw_max)
-            {
-              words_extra++;
-
-              continue;
-            }
-          }
-
-          pw_add (device_param, (u8 *) line_buf, (int) line_len);
-
-          if (status_ctx->run_thread_level1 == false) break;
-        }
+        words_extra = calc_words (hashcat_ctx, hashcat_ctx_tmp, &map, fd, &words_cur, words_off, words_fin, device_param->pws_buf, &device_param->pws_cnt);
 
         words_extra_total += words_extra;
 
@@ -592,6 +1007,8 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
           fclose (fd);
 
+          mm_map_close (&map);
+
           hcfree (hashcat_ctx_tmp->wl_data);
 
           hcfree (hashcat_ctx_tmp);
@@ -607,6 +1024,8 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
           fclose (fd);
 
+          mm_map_close (&map);
+
           hcfree (hashcat_ctx_tmp->wl_data);
 
           hcfree (hashcat_ctx_tmp);
@@ -673,6 +1092,8 @@ static int calc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param)
 
     fclose (fd);
 
+    mm_map_close (&map);
+
     wl_data_destroy (hashcat_ctx_tmp);
 
     hcfree (hashcat_ctx_tmp->wl_data);
@@ -704,3 +1125,26 @@ void *thread_calc (void *p)
 
   return NULL;
 }
+
+void *thread_calc_reader (void *p)
+{
+  hashcat_ctx_t *hashcat_ctx = (hashcat_ctx_t *) p;
+
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  const int rc_reader = calc_reader (hashcat_ctx);
+
+  /// the devices crack what is left in the ring and leave. after a failure that would look like an exhausted dict,
+  /// so the attack stops as on a device error and the range is not marked finished in the cluster checkpoint
+  hc_thread_mutex_lock (mm_ctx->mux_reader);
+
+  if (rc_reader == -1) mm_ctx->reader_error = true;
+
+  mm_ctx->reader_done = true;
+
+  hc_thread_mutex_unlock (mm_ctx->mux_reader);
+
+  if (rc_reader == -1) myabort (hashcat_ctx);
+
+  return NULL;
+}
@@ -51,6 +51,7 @@
 #include "weak_hash.h"
 #include "wordlist.h"
 #include "mm_impl.h"
+#include "mm_ckpt.h"
 
 // inner2_loop iterates through wordlists, then calls kernel execution
 
@@ -59,9 +60,12 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
   hashes_t             *hashes              = hashcat_ctx->hashes;
   induct_ctx_t         *induct_ctx          = hashcat_ctx->induct_ctx;
   logfile_ctx_t        *logfile_ctx         = hashcat_ctx->logfile_ctx;
+  mask_ctx_t           *mask_ctx            = hashcat_ctx->mask_ctx;
+  mm_ctx_t             *mm_ctx              = hashcat_ctx->mm_ctx;
   opencl_ctx_t         *opencl_ctx          = hashcat_ctx->opencl_ctx;
   restore_ctx_t        *restore_ctx         = hashcat_ctx->restore_ctx;
   status_ctx_t         *status_ctx          = hashcat_ctx->status_ctx;
+  straight_ctx_t       *straight_ctx        = hashcat_ctx->straight_ctx;
   user_options_extra_t *user_options_extra  = hashcat_ctx->user_options_extra;
   user_options_t       *user_options        = hashcat_ctx->user_options;
 
@@ -134,7 +138,13 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   status_ctx->words_base = status_ctx->words_cnt / amplifier_cnt;
 
-  if ( user_options->attack_mode == ATTACK_MODE_BF )
+  mm_ctx->epoch_total = status_ctx->words_base;
+
+  if ((user_options->attack_mode == ATTACK_MODE_BF) && (mm_ctx->mask_plan != NULL))
+  {
+    mm_mask_slice (hashcat_ctx);
+  }
+  else if ((user_options->attack_mode == ATTACK_MODE_BF) && (mm_ctx->dynamic == false) && (mm_ctx->speed_split == false))
   {
     u64 tmp = status_ctx->words_base;
     status_ctx->words_off  = (hashcat_ctx->cur_proc_id * tmp ) / hashcat_ctx->total_proc_cnt;
@@ -147,6 +157,12 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   if (user_options->keyspace == true) return 0;
 
+  /**
+   * cluster checkpoint, skip what an earlier session finished
+   */
+
+  if (mm_ckpt_begin (hashcat_ctx) == 1) return 1;
+
   // restore stuff
 
   if (status_ctx->words_off > status_ctx->words_base)
@@ -203,6 +219,39 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   opencl_ctx_devices_update_power (hashcat_ctx);
 
+  /**
+   * the dynamic dispenser needs the final kernel_power_all for its chunk size
+   */
+
+  if (mm_ctx->dynamic == true)
+  {
+    mm_work_begin (hashcat_ctx, (mask_ctx->masks_pos * MAX (1, straight_ctx->dicts_cnt)) + straight_ctx->dicts_pos);
+  }
+
+  /**
+   * the speed weighted split needs the autotuned speed of every rank
+   */
+
+  if (mm_ctx->speed_split == true)
+  {
+    const int rc_speed_split = mm_speed_split (hashcat_ctx);
+
+    if (rc_speed_split != 0)
+    {
+      hcfree (c_threads);
+
+      hcfree (threads_param);
+
+      return rc_speed_split;
+    }
+  }
+
+  /**
+   * the cluster checkpoint tracks what we got, a restored job splits the unfinished ranges instead
+   */
+
+  mm_ckpt_split (hashcat_ctx);
+
   /**
    * Begin loopback recording
    */
@@ -234,6 +283,12 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   status_ctx->accessible = true;
 
+  /// --mm-shared-reader: one thread reads the dict, the devices take its batches
+  if (mm_reader_begin (hashcat_ctx) == true)
+  {
+    hc_thread_create (hashcat_ctx->mm_ctx->reader_thread, thread_calc_reader, hashcat_ctx);
+  }
+
   for (u32 device_id = 0; device_id < opencl_ctx->devices_cnt; device_id++)
   {
     thread_param_t *thread_param = threads_param + device_id;
@@ -253,6 +308,8 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
 
   hc_thread_wait (opencl_ctx->devices_cnt, c_threads);
 
+  mm_reader_end (hashcat_ctx);
+
   hcfree (c_threads);
 
   hcfree (threads_param);
@@ -272,6 +329,8 @@ static int inner2_loop (hashcat_ctx_t *hashcat_ctx)
     status_ctx->devices_status = STATUS_EXHAUSTED;
   }
 
+  mm_ckpt_end (hashcat_ctx);
+
   // update some timer
 
   time_t runtime_stop;
@@ -343,6 +402,7 @@ static int inner1_loop (hashcat_ctx_t *hashcat_ctx)
   restore_ctx_t  *restore_ctx   = hashcat_ctx->restore_ctx;
   status_ctx_t   *status_ctx    = hashcat_ctx->status_ctx;
   straight_ctx_t *straight_ctx  = hashcat_ctx->straight_ctx;
+  user_options_t *user_options  = hashcat_ctx->user_options;
 
   //status_ctx->run_main_level1   = true;
   //status_ctx->run_main_level2   = true;
@@ -370,21 +430,8 @@ static int inner1_loop (hashcat_ctx_t *hashcat_ctx)
 
   if (straight_ctx->dicts_cnt)
   {
-    /// allocat memory for hashcat_ct->fd_list
-    hashcat_ctx -> fd_list = hccalloc(straight_ctx->dicts_cnt, sizeof(mm_extend_fd_t) * straight_ctx->dicts_cnt);
-    if ( NULL == hashcat_ctx->fd_list )
-    {
-      return -1;
-    }
-
-    for (u32 dicts_pos = straight_ctx->dicts_pos; dicts_pos < straight_ctx->dicts_cnt; dicts_pos++)
-    {
-      if ( -1 == get_entry_cnt(straight_ctx->dicts[dicts_pos], hashcat_ctx->fd_list + dicts_pos))
-      {
-        hcfree(hashcat_ctx->fd_list);
-        return -1;
-      }
-    }
+    /// counts the rule split did not collect yet
+    if (mm_fd_list_count (hashcat_ctx, straight_ctx->dicts_pos) == -1) return -1;
 
     straight_divide_workload (hashcat_ctx);
 
@@ -404,6 +451,11 @@ static int inner1_loop (hashcat_ctx_t *hashcat_ctx)
   }
   else
   {
+    if (user_options->attack_mode == ATTACK_MODE_COMBI)
+    {
+      if (combi_divide_workload (hashcat_ctx) == -1) return -1;
+    }
+
     const int rc_inner2_loop = inner2_loop (hashcat_ctx);
 
     if (rc_inner2_loop == -1) myabort (hashcat_ctx);
@@ -414,6 +466,52 @@ static int inner1_loop (hashcat_ctx_t *hashcat_ctx)
   return 0;
 }
 
+// load hashes, stage 1 and 2
+
+static int hashes_load (hashcat_ctx_t *hashcat_ctx)
+{
+  hashes_t       *hashes        = hashcat_ctx->hashes;
+  user_options_t *user_options  = hashcat_ctx->user_options;
+
+  /**
+   * --mm-hash-cache, an unchanged hash file comes back as stage 2 left it
+   */
+
+  if (mm_hash_cache_load (hashcat_ctx) == 1) return 0;
+
+  /**
+   * load hashes, stage 1
+   */
+
+  const int rc_hashes_init_stage1 = hashes_init_stage1 (hashcat_ctx);
+
+  if (rc_hashes_init_stage1 == -1) return -1;
+
+  if ((user_options->keyspace == false) && (user_options->stdout_flag == false))
+  {
+    if (hashes->hashes_cnt == 0)
+    {
+      event_log_error (hashcat_ctx, "No hashes loaded.");
+
+      return -1;
+    }
+  }
+
+  /**
+   * load hashes, stage 2, remove duplicates, build base structure
+   */
+
+  hashes->hashes_cnt_orig = hashes->hashes_cnt;
+
+  const int rc_hashes_init_stage2 = hashes_init_stage2 (hashcat_ctx);
+
+  if (rc_hashes_init_stage2 == -1) return -1;
+
+  mm_hash_cache_save (hashcat_ctx);
+
+  return 0;
+}
+
 // outer_loop iterates through hash_modes (in benchmark mode)
 // also initializes stuff that depend on hash mode
 
@@ -445,32 +543,21 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
   if (rc_hashconfig == -1) return -1;
 
   /**
-   * load hashes, stage 1
+   * load hashes, stage 1 and 2, with --mm-bcast-init only rank 0 reads the hash file
    */
 
-  const int rc_hashes_init_stage1 = hashes_init_stage1 (hashcat_ctx);
+  const bool bcast_init = mm_bcast_init_enabled (hashcat_ctx);
 
-  if (rc_hashes_init_stage1 == -1) return -1;
+  int rc_hashes_load = 0;
 
-  if ((user_options->keyspace == false) && (user_options->stdout_flag == false))
+  if ((bcast_init == false) || (hashcat_ctx->cur_proc_id == 0))
   {
-    if (hashes->hashes_cnt == 0)
-    {
-      event_log_error (hashcat_ctx, "No hashes loaded.");
-
-      return -1;
-    }
+    rc_hashes_load = hashes_load (hashcat_ctx);
   }
 
-  /**
-   * load hashes, stage 2, remove duplicates, build base structure
-   */
-
-  hashes->hashes_cnt_orig = hashes->hashes_cnt;
-
-  const int rc_hashes_init_stage2 = hashes_init_stage2 (hashcat_ctx);
+  if (bcast_init == true) rc_hashes_load = mm_hashes_bcast (hashcat_ctx, rc_hashes_load);
 
-  if (rc_hashes_init_stage2 == -1) return -1;
+  if (rc_hashes_load == -1) return -1;
 
   /**
    * potfile removes
@@ -671,7 +758,15 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
 
   EVENT (EVENT_OPENCL_SESSION_PRE);
 
-  const int rc_session_begin = opencl_session_begin (hashcat_ctx);
+  /// with --mm-bcast-init rank 0 builds the kernels first, the others find its binaries in their cache
+
+  int rc_session_begin = 0;
+
+  if ((bcast_init == true) && (hashcat_ctx->cur_proc_id != 0)) rc_session_begin = mm_kernel_cache_bcast (hashcat_ctx, 0);
+
+  if (rc_session_begin == 0) rc_session_begin = opencl_session_begin (hashcat_ctx);
+
+  if ((bcast_init == true) && (hashcat_ctx->cur_proc_id == 0)) rc_session_begin = mm_kernel_cache_bcast (hashcat_ctx, rc_session_begin);
 
   if (rc_session_begin == -1) return -1;
 
@@ -742,6 +837,26 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
     return 0;
   }
 
+  /**
+   * dynamic work dispenser, collective over all ranks so keep it behind every early exit
+   */
+
+  const int rc_mm_work_init = mm_work_init (hashcat_ctx);
+
+  if (rc_mm_work_init == -1) return -1;
+
+  const int rc_mm_ckpt_init = mm_ckpt_init (hashcat_ctx);
+
+  if (rc_mm_ckpt_init == -1) return -1;
+
+  const int rc_mm_rules_split = mm_rules_split (hashcat_ctx);
+
+  if (rc_mm_rules_split == -1) return -1;
+
+  const int rc_mm_mask_plan = mm_mask_plan (hashcat_ctx);
+
+  if (rc_mm_mask_plan == -1) return -1;
+
   /**
    * status and monitor threads
    */
@@ -792,6 +907,8 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
     {
       mask_ctx->masks_pos = masks_pos;
 
+      if (mm_mask_owned (hashcat_ctx, masks_pos) == false) continue;
+
       const int rc_inner1_loop = inner1_loop (hashcat_ctx);
 
       if (rc_inner1_loop == -1) myabort (hashcat_ctx);
@@ -829,7 +946,9 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
 
   opencl_session_destroy (hashcat_ctx);
 
-  // clean up
+  // clean up, the node shared copies go first so that nobody hcfree()s them
+
+  mm_node_release (hashcat_ctx);
 
   bitmap_ctx_destroy      (hashcat_ctx);
   combinator_ctx_destroy  (hashcat_ctx);
@@ -837,6 +956,7 @@ static int outer_loop (hashcat_ctx_t *hashcat_ctx)
   hashconfig_destroy      (hashcat_ctx);
   hashes_destroy          (hashcat_ctx);
   mask_ctx_destroy        (hashcat_ctx);
+  mm_work_destroy         (hashcat_ctx);
   status_progress_destroy (hashcat_ctx);
   straight_ctx_destroy    (hashcat_ctx);
   wl_data_destroy         (hashcat_ctx);
@@ -870,6 +990,7 @@ int hashcat_init (hashcat_ctx_t *hashcat_ctx, void (*event) (const u32, struct h
   hashcat_ctx->logfile_ctx        = (logfile_ctx_t *)         hcmalloc (sizeof (logfile_ctx_t));
   hashcat_ctx->loopback_ctx       = (loopback_ctx_t *)        hcmalloc (sizeof (loopback_ctx_t));
   hashcat_ctx->mask_ctx           = (mask_ctx_t *)            hcmalloc (sizeof (mask_ctx_t));
+  hashcat_ctx->mm_ctx             = (mm_ctx_t *)              hcmalloc (sizeof (mm_ctx_t));
   hashcat_ctx->opencl_ctx         = (opencl_ctx_t *)          hcmalloc (sizeof (opencl_ctx_t));
   hashcat_ctx->outcheck_ctx       = (outcheck_ctx_t *)        hcmalloc (sizeof (outcheck_ctx_t));
   hashcat_ctx->outfile_ctx        = (outfile_ctx_t *)         hcmalloc (sizeof (outfile_ctx_t));
@@ -884,6 +1005,7 @@ int hashcat_init (hashcat_ctx_t *hashcat_ctx, void (*event) (const u32, struct h
   hashcat_ctx->wl_data            = (wl_data_t *)             hcmalloc (sizeof (wl_data_t));
 
   hashcat_ctx->fd_list            = NULL;
+  hashcat_ctx->fd_list_cnt        = 0;
   hashcat_ctx->cracked[0]         = 0;                        /// set to 1 if cracked locally
   hashcat_ctx->cracked[1]         = 0;                        /// set to 1 if inner quit
   hashcat_ctx->cracked[2]         = 0;                        /// set to 1 if err happened
@@ -921,6 +1043,21 @@ void hashcat_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (hashcat_ctx->logfile_ctx);
   hcfree (hashcat_ctx->loopback_ctx);
   hcfree (hashcat_ctx->mask_ctx);
+  hcfree (hashcat_ctx->mm_ctx->speeds);
+  hcfree (hashcat_ctx->mm_ctx->share_sent);
+  hcfree (hashcat_ctx->mm_ctx->cracks);
+  hcfree (hashcat_ctx->mm_ctx->kernel_files);
+  hcfree (hashcat_ctx->mm_ctx->leader_of);
+  hcfree (hashcat_ctx->mm_ctx->ckpt_own);
+  hcfree (hashcat_ctx->mm_ctx->ckpt_done);
+  hcfree (hashcat_ctx->mm_ctx->ckpt_restored);
+  hcfree (hashcat_ctx->mm_ctx->ckpt_set);
+  hcfree (hashcat_ctx->mm_ctx->ckpt_left);
+  hcfree (hashcat_ctx->mm_ctx->ckpt_queue);
+  #if defined (ENABLE_MPI)
+  hcfree (hashcat_ctx->mm_ctx->reqs);
+  #endif
+  hcfree (hashcat_ctx->mm_ctx);
   hcfree (hashcat_ctx->opencl_ctx);
   hcfree (hashcat_ctx->outcheck_ctx);
   hcfree (hashcat_ctx->outfile_ctx);
@@ -934,7 +1071,7 @@ void hashcat_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (hashcat_ctx->user_options);
   hcfree (hashcat_ctx->wl_data);
 
-  hcfree(hashcat_ctx->fd_list);
+  mm_fd_list_destroy (hashcat_ctx);
   hcfree(hashcat_ctx->mm_crack_buf);
   memset (hashcat_ctx, 0, sizeof (hashcat_ctx_t));
   hcfree(hashcat_ctx->mm_hostname);
@@ -1197,6 +1334,14 @@ int hashcat_session_execute (hashcat_ctx_t *hashcat_ctx)
 
     if (rc_final == -1) myabort (hashcat_ctx);
 
+    /// --mm-degraded: what failed ranks left runs again on the others
+    while (mm_degraded_repair (hashcat_ctx) == 1)
+    {
+      rc_final = outer_loop (hashcat_ctx);
+
+      if (rc_final == -1) myabort (hashcat_ctx);
+    }
+
     if (user_options->speed_only == true) user_options->quiet = false;
   }
 
@@ -1364,6 +1509,9 @@ int hashcat_get_status (hashcat_ctx_t *hashcat_ctx, hashcat_status_t *hashcat_st
   hashcat_status->cpt_avg_hour                = status_get_cpt_avg_hour               (hashcat_ctx);
   hashcat_status->cpt_avg_day                 = status_get_cpt_avg_day                (hashcat_ctx);
   hashcat_status->cpt                         = status_get_cpt                        (hashcat_ctx);
+  hashcat_status->bitmap_bits                 = status_get_bitmap_bits                (hashcat_ctx);
+  hashcat_status->bitmap_fill                 = status_get_bitmap_fill                (hashcat_ctx);
+  hashcat_status->bitmap_fpr                  = status_get_bitmap_fpr                 (hashcat_ctx);
 
   // multiple devices
 
@@ -26,6 +26,12 @@
 #include "timer.h"
 #include "locking.h"
 #include "mm_impl.h"
+#include "mm_notify.h"
+
+#include <fcntl.h>
+#if defined (_POSIX)
+#include <sys/mman.h>
+#endif
 
 int sort_by_digest_p0p1 (const void *v1, const void *v2, void *v3)
 {
@@ -288,9 +294,12 @@ void check_hash (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pl
 
   const int tmp_len = outfile_write (hashcat_ctx, (char *) out_buf, plain_ptr, plain_len, crackpos, NULL, 0, (char *) tmp_buf);
 
+  hcfree(hashcat_ctx->mm_crack_buf);
   hashcat_ctx->mm_crack_buf =  (u8*)hccalloc(strlen(tmp_buf) +1, sizeof(u8));
   strcpy(hashcat_ctx->mm_crack_buf, tmp_buf);
 
+  mm_share_crack (hashcat_ctx, salt_pos, plain->hash_pos, (char *) tmp_buf);
+
   outfile_write_close (hashcat_ctx);
 
   EVENT_DATA (EVENT_CRACKER_HASH_CRACKED, tmp_buf, tmp_len);
@@ -324,8 +333,6 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
   hashes_t     *hashes     = hashcat_ctx->hashes;
   status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
 
-  salt_t *salt_buf = &hashes->salts_buf[salt_pos];
-
   u32 num_cracked;
 
   cl_int CL_err;
@@ -341,7 +348,9 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
 
   if (num_cracked)
   {
-    plain_t *cracked = (plain_t *) hccalloc (num_cracked, sizeof (plain_t));
+    // --mm-pinned reads into pinned memory, the read is never more than size_plains
+
+    plain_t *cracked = (device_param->plain_bufs != NULL) ? device_param->plain_bufs : (plain_t *) hccalloc (num_cracked, sizeof (plain_t));
 
     CL_err = hc_clEnqueueReadBuffer (hashcat_ctx, device_param->command_queue, device_param->d_plain_bufs, CL_TRUE, 0, num_cracked * sizeof (plain_t), cracked, 0, NULL, NULL);
 
@@ -358,6 +367,10 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
 
     for (u32 i = 0; i < num_cracked; i++)
     {
+      // run_cracker() may collect the cracks of all salts at once
+
+      salt_t *salt_buf = &hashes->salts_buf[cracked[i].salt_pos];
+
       const u32 hash_pos = cracked[i].hash_pos;
 
       if (hashes->digests_shown[hash_pos] == 1) continue;
@@ -374,7 +387,7 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
 
         if (salt_buf->digests_done == salt_buf->digests_cnt)
         {
-          hashes->salts_shown[salt_pos] = 1;
+          hashes->salts_shown[cracked[i].salt_pos] = 1;
 
           hashes->salts_done++;
         }
@@ -387,7 +400,7 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
 
     hc_thread_mutex_unlock (status_ctx->mux_display);
 
-    hcfree (cracked);
+    if (cracked != device_param->plain_bufs) hcfree (cracked);
 
     if (cpt_cracked > 0)
     {
@@ -411,6 +424,8 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
       // otherwise host thinks again and again the hash was cracked
       // and returns invalid password each time
 
+      salt_t *salt_buf = &hashes->salts_buf[salt_pos];
+
       memset (hashes->digests_shown_tmp, 0, salt_buf->digests_cnt * sizeof (u32));
 
       CL_err = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_digests_shown, CL_TRUE, salt_buf->digests_offset * sizeof (u32), salt_buf->digests_cnt * sizeof (u32), &hashes->digests_shown_tmp[salt_buf->digests_offset], 0, NULL, NULL);
@@ -438,6 +453,475 @@ int check_cracked (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
   return 0;
 }
 
+/// --mm-parse-threads: a line of the mapped hashfile, without the trailing newlines as fgetl() does it
+static const char *hashes_next_line (const char *ptr, const char *end, u32 *line_len)
+{
+  const char *eol = (const char *) memchr (ptr, '\n', end - ptr);
+
+  if (eol == NULL) eol = end;
+
+  u32 len = (u32) (eol - ptr);
+
+  while ((len > 0) && (ptr[len - 1] == '\r')) len--;
+
+  *line_len = len;
+
+  return (eol < end) ? eol + 1 : end;
+}
+
+/// --mm-parse-threads, pass 1: the non-empty lines of our range get a hash_t each
+static void *thread_count_hashes (void *p)
+{
+  mm_parse_t *parse = (mm_parse_t *) p;
+
+  u32 lines_cnt    = 0;
+  u32 hashes_avail = 0;
+
+  const char *ptr = parse->beg;
+
+  while (ptr < parse->end)
+  {
+    u32 line_len;
+
+    ptr = hashes_next_line (ptr, parse->end, &line_len);
+
+    lines_cnt++;
+
+    if (line_len > 0) hashes_avail++;
+  }
+
+  parse->lines_cnt    = lines_cnt;
+  parse->hashes_avail = hashes_avail;
+
+  return NULL;
+}
+
+/// --mm-parse-threads, pass 2: the loop of hashes_init_stage1(), on our range and our hash_t only
+static void *thread_parse_hashes (void *p)
+{
+  mm_parse_t *parse = (mm_parse_t *) p;
+
+  hashcat_ctx_t *hashcat_ctx = parse->hashcat_ctx;
+
+  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  hash_t *hashes_buf = hashes->hashes_buf + parse->hashes_base;
+
+  char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
+
+  u32 line_num   = parse->line_base;
+  u32 hashes_cnt = 0;
+
+  const char *ptr = parse->beg;
+
+  while (ptr < parse->end)
+  {
+    const char *line = ptr;
+
+    u32 line_len;
+
+    ptr = hashes_next_line (ptr, parse->end, &line_len);
+
+    line_num++;
+
+    if (line_len == 0) continue;
+
+    if (hashes_cnt == parse->hashes_avail) break;
+
+    line_len = MIN (line_len, HCBUFSIZ_LARGE - 1);
+
+    memcpy (line_buf, line, line_len);
+
+    line_buf[line_len] = 0;
+
+    char *hash_buf = NULL;
+    int   hash_len = 0;
+
+    hlfmt_hash (hashcat_ctx, parse->hashlist_format, line_buf, (int) line_len, &hash_buf, &hash_len);
+
+    if ((hash_len < 1) || (hash_buf == NULL))
+    {
+      hc_thread_mutex_lock (*parse->mux_log);
+
+      event_log_warning (hashcat_ctx, "Failed to parse hashes using the '%s' format.", strhlfmt (parse->hashlist_format));
+
+      hc_thread_mutex_unlock (*parse->mux_log);
+
+      continue;
+    }
+
+    hash_t *hash = hashes_buf + hashes_cnt;
+
+    if (user_options->username == true)
+    {
+      char *user_buf = NULL;
+      int   user_len = 0;
+
+      hlfmt_user (hashcat_ctx, parse->hashlist_format, line_buf, (int) line_len, &user_buf, &user_len);
+
+      user_t *user_ptr = (user_t *) hcmalloc (sizeof (user_t));
+
+      user_ptr->user_name = hcstrdup ((user_buf != NULL) ? user_buf : "");
+      user_ptr->user_len  = user_len;
+
+      hash->hash_info->user = user_ptr;
+    }
+
+    if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
+    {
+      hash->hash_info->orighash = hcstrdup (hash_buf);
+    }
+
+    if (hashconfig->is_salted)
+    {
+      memset (hash->salt, 0, sizeof (salt_t));
+    }
+
+    if (hashconfig->esalt_size)
+    {
+      memset (hash->esalt, 0, hashconfig->esalt_size);
+    }
+
+    if (hashconfig->hook_salt_size)
+    {
+      memset (hash->hook_salt, 0, hashconfig->hook_salt_size);
+    }
+
+    const int parser_status = hashconfig->parse_func ((u8 *) hash_buf, hash_len, hash, hashconfig);
+
+    if (parser_status < PARSER_GLOBAL_ZERO)
+    {
+      hc_thread_mutex_lock (*parse->mux_log);
+
+      event_log_warning (hashcat_ctx, "Hashfile '%s' on line %u (%s): %s", hashes->hashfile, line_num, line_buf, strparser (parser_status));
+
+      hc_thread_mutex_unlock (*parse->mux_log);
+
+      continue;
+    }
+
+    hashes_cnt++;
+  }
+
+  parse->hashes_cnt = hashes_cnt;
+
+  hcfree (line_buf);
+
+  return NULL;
+}
+
+/// --mm-parse-threads: map the hashfile and parse it with one thread per byte range.
+/// the hash_t end up in file order, as the sequential loop leaves them
+static int hashes_parse_mt (hashcat_ctx_t *hashcat_ctx, const u32 hashlist_format, const u32 hashes_avail, u32 *hashes_cnt)
+{
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  const char *hashfile = hashes->hashfile;
+
+  const int fd = open (hashfile, O_RDONLY);
+
+  if (fd == -1)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+
+    return -1;
+  }
+
+  hc_stat_t st;
+
+  if (hc_fstat (fd, &st) == -1)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+
+    close (fd);
+
+    return -1;
+  }
+
+  *hashes_cnt = 0;
+
+  if (st.st_size == 0)
+  {
+    close (fd);
+
+    return 0;
+  }
+
+  const size_t size = (size_t) st.st_size;
+
+  #if defined (_WIN)
+
+  /// no mmap (), the threads parse a copy of the whole file instead
+  close (fd);
+
+  char *base = (char *) hcmalloc (size);
+
+  FILE *fp = fopen (hashfile, "rb");
+
+  const bool read_ok = (fp != NULL) && (fread (base, 1, size, fp) == size);
+
+  if (fp != NULL) fclose (fp);
+
+  if (read_ok == false)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+
+    hcfree (base);
+
+    return -1;
+  }
+
+  #else
+
+  char *base = (char *) mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close (fd);
+
+  if (base == MAP_FAILED)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", hashfile, strerror (errno));
+
+    return -1;
+  }
+
+  madvise (base, size, MADV_SEQUENTIAL);
+
+  #endif
+
+  const char *end = base + size;
+
+  const u32 threads_cnt = user_options->mm_parse_threads;
+
+  mm_parse_t  *parses  = (mm_parse_t *)  hccalloc (threads_cnt, sizeof (mm_parse_t));
+  hc_thread_t *threads = (hc_thread_t *) hccalloc (threads_cnt, sizeof (hc_thread_t));
+
+  hc_thread_mutex_t mux_log;
+
+  hc_thread_mutex_init (mux_log);
+
+  // byte ranges, each one starts right after a newline
+
+  const char *beg = base;
+
+  for (u32 i = 0; i < threads_cnt; i++)
+  {
+    const char *fin = (i == (threads_cnt - 1)) ? end : base + ((size / threads_cnt) * (i + 1));
+
+    if (fin < beg) fin = beg;
+
+    if (fin < end)
+    {
+      const char *eol = (const char *) memchr (fin, '\n', end - fin);
+
+      fin = (eol == NULL) ? end : eol + 1;
+    }
+
+    parses[i].hashcat_ctx     = hashcat_ctx;
+    parses[i].beg             = beg;
+    parses[i].end             = fin;
+    parses[i].hashlist_format = hashlist_format;
+    parses[i].mux_log         = &mux_log;
+
+    beg = fin;
+  }
+
+  for (u32 i = 0; i < threads_cnt; i++) hc_thread_create (threads[i], thread_count_hashes, parses + i);
+
+  hc_thread_wait (threads_cnt, threads);
+
+  u32 line_base   = 0;
+  u32 hashes_base = 0;
+
+  bool changed = false;
+
+  for (u32 i = 0; i < threads_cnt; i++)
+  {
+    parses[i].line_base   = line_base;
+    parses[i].hashes_base = hashes_base;
+
+    line_base += parses[i].lines_cnt;
+
+    // count_lines() saw another file
+
+    if ((hashes_avail - hashes_base) < parses[i].hashes_avail)
+    {
+      parses[i].hashes_avail = hashes_avail - hashes_base;
+
+      changed = true;
+    }
+
+    hashes_base += parses[i].hashes_avail;
+  }
+
+  if (changed == true) event_log_warning (hashcat_ctx, "Hashfile '%s': File changed during runtime. Skipping new data.", hashfile);
+
+  for (u32 i = 0; i < threads_cnt; i++) hc_thread_create (threads[i], thread_parse_hashes, parses + i);
+
+  hc_thread_wait (threads_cnt, threads);
+
+  // close the gaps of the lines which failed to parse, swap to keep the pointers of every hash_t
+
+  hash_t *hashes_buf = hashes->hashes_buf;
+
+  u32 hashes_pos = 0;
+
+  for (u32 i = 0; i < threads_cnt; i++)
+  {
+    for (u32 j = 0; j < parses[i].hashes_cnt; j++, hashes_pos++)
+    {
+      const u32 src = parses[i].hashes_base + j;
+
+      if (src == hashes_pos) continue;
+
+      hash_t tmp = hashes_buf[hashes_pos];
+
+      hashes_buf[hashes_pos] = hashes_buf[src];
+
+      hashes_buf[src] = tmp;
+    }
+  }
+
+  *hashes_cnt = hashes_pos;
+
+  hc_thread_mutex_delete (mux_log);
+
+  hcfree (threads);
+  hcfree (parses);
+
+  #if defined (_WIN)
+  hcfree (base);
+  #else
+  munmap (base, size);
+  #endif
+
+  hashlist_parse_t hashlist_parse;
+
+  hashlist_parse.hashes_cnt   = hashes_pos;
+  hashlist_parse.hashes_avail = hashes_avail;
+
+  EVENT_DATA (EVENT_HASHLIST_PARSE_HASH, &hashlist_parse, sizeof (hashlist_parse_t));
+
+  return 0;
+}
+
+static void *thread_sort_hashes (void *p)
+{
+  mm_sort_t *sort = (mm_sort_t *) p;
+
+  if (sort->out == NULL)
+  {
+    hc_qsort_r (sort->buf, sort->cnt, sizeof (hash_t), sort->compar, sort->arg);
+
+    return NULL;
+  }
+
+  hash_t *l = sort->buf;
+  hash_t *r = sort->buf + sort->cnt;
+
+  hash_t *l_end = r;
+  hash_t *r_end = r + sort->cnt2;
+
+  hash_t *out = sort->out;
+
+  while ((l < l_end) && (r < r_end))
+  {
+    if (sort->compar (r, l, sort->arg) < 0) *out++ = *r++;
+    else                                    *out++ = *l++;
+  }
+
+  while (l < l_end) *out++ = *l++;
+  while (r < r_end) *out++ = *r++;
+
+  return NULL;
+}
+
+/// --mm-parse-threads: sort one run per thread, then merge the runs pairwise, each pair in a thread of its own
+static void hashes_sort_mt (hashcat_ctx_t *hashcat_ctx, hash_t *hashes_buf, const u32 hashes_cnt, int (*compar) (const void *, const void *, void *))
+{
+  const u32 threads_cnt = hashcat_ctx->user_options->mm_parse_threads;
+
+  void *arg = (void *) hashcat_ctx->hashconfig;
+
+  mm_sort_t   *sorts   = (mm_sort_t *)   hccalloc (threads_cnt, sizeof (mm_sort_t));
+  hc_thread_t *threads = (hc_thread_t *) hccalloc (threads_cnt, sizeof (hc_thread_t));
+
+  u32 *runs = (u32 *) hccalloc (threads_cnt + 1, sizeof (u32));
+
+  for (u32 i = 0; i <= threads_cnt; i++) runs[i] = (u32) (((u64) hashes_cnt * i) / threads_cnt);
+
+  for (u32 i = 0; i < threads_cnt; i++)
+  {
+    sorts[i].buf    = hashes_buf + runs[i];
+    sorts[i].out    = NULL;
+    sorts[i].cnt    = runs[i + 1] - runs[i];
+    sorts[i].compar = compar;
+    sorts[i].arg    = arg;
+
+    hc_thread_create (threads[i], thread_sort_hashes, sorts + i);
+  }
+
+  hc_thread_wait (threads_cnt, threads);
+
+  hash_t *src = hashes_buf;
+  hash_t *dst = (hash_t *) hccalloc (hashes_cnt, sizeof (hash_t));
+
+  hash_t *tmp_buf = dst;
+
+  u32 runs_cnt = threads_cnt;
+
+  while (runs_cnt > 1)
+  {
+    const u32 pairs_cnt = runs_cnt / 2;
+
+    for (u32 i = 0; i < pairs_cnt; i++)
+    {
+      const u32 l = runs[2 * i];
+      const u32 m = runs[2 * i + 1];
+      const u32 r = runs[2 * i + 2];
+
+      sorts[i].buf    = src + l;
+      sorts[i].out    = dst + l;
+      sorts[i].cnt    = m - l;
+      sorts[i].cnt2   = r - m;
+      sorts[i].compar = compar;
+      sorts[i].arg    = arg;
+
+      hc_thread_create (threads[i], thread_sort_hashes, sorts + i);
+    }
+
+    // an odd run out waits for the next round
+
+    if (runs_cnt & 1)
+    {
+      const u32 l = runs[runs_cnt - 1];
+
+      memcpy (dst + l, src + l, (hashes_cnt - l) * sizeof (hash_t));
+    }
+
+    hc_thread_wait (pairs_cnt, threads);
+
+    u32 runs_new = 0;
+
+    for (u32 i = 0; i < runs_cnt; i += 2) runs[runs_new++] = runs[i];
+
+    runs[runs_new] = hashes_cnt;
+
+    runs_cnt = runs_new;
+
+    hash_t *swap = src; src = dst; dst = swap;
+  }
+
+  if (src != hashes_buf) memcpy (hashes_buf, src, hashes_cnt * sizeof (hash_t));
+
+  hcfree (tmp_buf);
+  hcfree (runs);
+  hcfree (threads);
+  hcfree (sorts);
+}
+
 int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
 {
   hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
@@ -899,6 +1383,12 @@ int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
         }
       }
     }
+    else if ((hashlist_mode == HL_MODE_FILE) && (user_options->mm_parse_threads > 1) && (hashconfig->hash_mode != 3000) && ((hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT) == 0))
+    {
+      const int rc_parse = hashes_parse_mt (hashcat_ctx, hashlist_format, hashes_avail, &hashes_cnt);
+
+      if (rc_parse == -1) return -1;
+    }
     else if (hashlist_mode == HL_MODE_FILE)
     {
       const char *hashfile = hashes->hashfile;
@@ -1110,7 +1600,11 @@ int hashes_init_stage1 (hashcat_ctx_t *hashcat_ctx)
   {
     EVENT (EVENT_HASHLIST_SORT_HASH_PRE);
 
-    if (hashconfig->is_salted)
+    if ((user_options->mm_parse_threads > 1) && (hashes_cnt >= (user_options->mm_parse_threads * 1024)))
+    {
+      hashes_sort_mt (hashcat_ctx, hashes_buf, hashes_cnt, (hashconfig->is_salted) ? sort_by_hash : sort_by_hash_no_salt);
+    }
+    else if (hashconfig->is_salted)
     {
       hc_qsort_r (hashes_buf, hashes_cnt, sizeof (hash_t), sort_by_hash, (void *) hashconfig);
     }
@@ -15262,7 +15262,9 @@ int ethereum_scrypt_parse_hash (u8 *input_buf, u32 input_len, hash_t *hash_buf,
  * hook functions
  */
 
-void seven_zip_hook_func (hc_device_param_t *device_param, hashes_t *hashes, const u32 salt_pos, const u32 pws_cnt)
+// pw_beg and pw_end let several threads share the candidates of one batch, each item only touches its own hook_item
+
+void seven_zip_hook_func (hc_device_param_t *device_param, hashes_t *hashes, const u32 salt_pos, const u32 pw_beg, const u32 pw_end)
 {
   seven_zip_hook_t *hook_items = (seven_zip_hook_t *) device_param->hooks_buf;
 
@@ -15273,7 +15275,7 @@ void seven_zip_hook_func (hc_device_param_t *device_param, hashes_t *hashes, con
   u32 *data_buf    = seven_zip->data_buf;
   u32  unpack_size = seven_zip->unpack_size;
 
-  for (u32 pw_pos = 0; pw_pos < pws_cnt; pw_pos++)
+  for (u32 pw_pos = pw_beg; pw_pos < pw_end; pw_pos++)
   {
     // this hook data needs to be updated (the "hook_success" variable):
 
@@ -15281,75 +15283,15 @@ void seven_zip_hook_func (hc_device_param_t *device_param, hashes_t *hashes, con
 
     const u8 *ukey = (const u8 *) hook_item->ukey;
 
-    // init AES
-
-    AES_KEY aes_key;
-
-    memset (&aes_key, 0, sizeof (aes_key));
-
-    AES_set_decrypt_key (ukey, 256, &aes_key);
-
     int aes_len = seven_zip->aes_len;
 
-    u32 data[4];
-    u32 out [4];
-    u32 iv  [4];
-
-    iv[0] = seven_zip->iv_buf[0];
-    iv[1] = seven_zip->iv_buf[1];
-    iv[2] = seven_zip->iv_buf[2];
-    iv[3] = seven_zip->iv_buf[3];
-
     u32 out_full[81882];
 
-    // if aes_len > 16 we need to loop
-
-    int i = 0;
-    int j = 0;
-
-    for (i = 0, j = 0; i < aes_len - 16; i += 16, j += 4)
-    {
-      data[0] = data_buf[j + 0];
-      data[1] = data_buf[j + 1];
-      data[2] = data_buf[j + 2];
-      data[3] = data_buf[j + 3];
-
-      AES_decrypt (&aes_key, (u8*) data, (u8*) out);
-
-      out[0] ^= iv[0];
-      out[1] ^= iv[1];
-      out[2] ^= iv[2];
-      out[3] ^= iv[3];
-
-      iv[0] = data[0];
-      iv[1] = data[1];
-      iv[2] = data[2];
-      iv[3] = data[3];
-
-      out_full[j + 0] = out[0];
-      out_full[j + 1] = out[1];
-      out_full[j + 2] = out[2];
-      out_full[j + 3] = out[3];
-    }
-
-    // we need to run it at least once:
-
-    data[0] = data_buf[j + 0];
-    data[1] = data_buf[j + 1];
-    data[2] = data_buf[j + 2];
-    data[3] = data_buf[j + 3];
-
-    AES_decrypt (&aes_key, (u8*) data, (u8*) out);
+    // AES-256-CBC over all of aes_len, but at least one block
 
-    out[0] ^= iv[0];
-    out[1] ^= iv[1];
-    out[2] ^= iv[2];
-    out[3] ^= iv[3];
+    const u32 blocks_cnt = (aes_len > 16) ? (u32) (aes_len + 15) / 16 : 1;
 
-    out_full[j + 0] = out[0];
-    out_full[j + 1] = out[1];
-    out_full[j + 2] = out[2];
-    out_full[j + 3] = out[3];
+    AES256_decrypt_cbc (ukey, seven_zip->iv_buf, data_buf, out_full, blocks_cnt);
 
     /*
      * check the CRC32 "hash"
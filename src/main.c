@@ -23,6 +23,7 @@
 #include "interface.h"
 #include "event.h"
 #include "mm_impl.h"
+#include "mm_ckpt.h"
 
 #if defined (__MINGW64__) || defined (__MINGW32__)
 int _dowildcard = -1;
@@ -996,7 +997,9 @@ int main (int argc, char **argv)
   hashcat_ctx_t *hashcat_ctx = (hashcat_ctx_t *) malloc (sizeof (hashcat_ctx_t));
 
 #ifdef ENABLE_MPI
-  int ierr = MPI_Init(&argc, &argv);
+  /// device threads talk to the work dispenser while the monitor thread polls
+  int mpi_thread_level = MPI_THREAD_SINGLE;
+  int ierr = MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpi_thread_level);
   ierr = MPI_Comm_rank(MPI_COMM_WORLD, &hashcat_ctx->cur_proc_id);
   ierr = MPI_Comm_size(MPI_COMM_WORLD, &hashcat_ctx->total_proc_cnt);
 #endif
@@ -1005,6 +1008,13 @@ int main (int argc, char **argv)
 
   if (rc_hashcat_init == -1) return -1;
 
+#ifdef ENABLE_MPI
+  hashcat_ctx->mm_ctx->thread_multiple = (mpi_thread_level >= MPI_THREAD_MULTIPLE);
+  ierr = MPI_Comm_dup(MPI_COMM_WORLD, &hashcat_ctx->mm_ctx->comm);
+  hashcat_ctx->mm_ctx->speed_comm = MPI_COMM_NULL;
+  hashcat_ctx->mm_ctx->speed_req  = MPI_REQUEST_NULL;
+#endif
+
   /// now get hostname of current proc
   gethostname(hashcat_ctx->mm_hostname, HOSTNAME_DISPLAY_LEN -1);
 
@@ -1082,6 +1092,9 @@ int main (int argc, char **argv)
   inited_all = hashcat_ctx->inited;
 #endif
 
+  /// --mm-degraded: run without the ranks that failed to init
+  inited_all = mm_degraded_init (hashcat_ctx, inited_all);
+
   int rc_final = -1;
 
   if (inited_all == hashcat_ctx-> total_proc_cnt)
@@ -1112,6 +1125,12 @@ int main (int argc, char **argv)
 
   goodbye_screen (hashcat_ctx, proc_start, proc_stop);
 
+#ifdef ENABLE_MPI
+  mm_speed_finish (hashcat_ctx);
+  if (hashcat_ctx->mm_ctx->topology == true) MPI_Comm_free(&hashcat_ctx->mm_ctx->node_comm);
+  if (hashcat_ctx->mm_ctx->comm != MPI_COMM_NULL) MPI_Comm_free(&hashcat_ctx->mm_ctx->comm);
+#endif
+
   hashcat_destroy (hashcat_ctx);
 
   free (hashcat_ctx);
@@ -0,0 +1,651 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "mm_impl.h"
+#include "mm_notify.h"
+#include "mm_ckpt.h"
+#include "memory.h"
+#include "shared.h"
+#include "thread.h"
+#include "event.h"
+#include "user_options.h"
+#include "hashcat.h"
+#include "potfile.h"
+#include "restore.h"
+
+static int mm_range_cmp (const void *p1, const void *p2)
+{
+  const mm_range_t *r1 = (const mm_range_t *) p1;
+  const mm_range_t *r2 = (const mm_range_t *) p2;
+
+  if (r1->epoch != r2->epoch) return (r1->epoch < r2->epoch) ? -1 : 1;
+  if (r1->start != r2->start) return (r1->start < r2->start) ? -1 : 1;
+
+  return 0;
+}
+
+static void mm_range_add (mm_range_t **ranges, u32 *cnt, u32 *avail, const mm_range_t *range)
+{
+  if (*cnt == *avail)
+  {
+    *ranges = (mm_range_t *) hcrealloc (*ranges, *avail * sizeof (mm_range_t), 64 * sizeof (mm_range_t));
+
+    *avail += 64;
+  }
+
+  (*ranges)[(*cnt)++] = *range;
+}
+
+/// add finished ranges to the set of rank 0. reporting a range twice does no harm, the set is sorted and merged again
+void mm_ckpt_merge (hashcat_ctx_t *hashcat_ctx, const mm_range_t *ranges, const u32 cnt)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  for (u32 i = 0; i < cnt; i++)
+  {
+    mm_range_add (&mm_ctx->ckpt_set, &mm_ctx->ckpt_set_cnt, &mm_ctx->ckpt_set_avail, ranges + i);
+  }
+
+  qsort (mm_ctx->ckpt_set, mm_ctx->ckpt_set_cnt, sizeof (mm_range_t), mm_range_cmp);
+
+  u32 out = 0;
+
+  for (u32 i = 0; i < mm_ctx->ckpt_set_cnt; i++)
+  {
+    const mm_range_t *range = mm_ctx->ckpt_set + i;
+
+    if (out > 0)
+    {
+      mm_range_t *last = mm_ctx->ckpt_set + out - 1;
+
+      if ((last->epoch == range->epoch) && (range->start <= last->end))
+      {
+        last->end = MAX (last->end, range->end);
+
+        continue;
+      }
+    }
+
+    mm_ctx->ckpt_set[out++] = *range;
+  }
+
+  mm_ctx->ckpt_set_cnt = out;
+}
+
+/// remember [start, end) of the current epoch as ours, in epoch wide word indices
+void mm_ckpt_own (hashcat_ctx_t *hashcat_ctx, const u64 start, const u64 end)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->ckpt_active == false) return;
+
+  if (start >= end) return;
+
+  const mm_range_t range = { mm_ctx->ckpt_epoch, mm_ctx->ckpt_total, start, end };
+
+  mm_range_add (&mm_ctx->ckpt_own, &mm_ctx->ckpt_own_cnt, &mm_ctx->ckpt_own_avail, &range);
+}
+
+/// copy what is finished of our ranges to dst, that is everything below words_cur or all of them if the epoch ran out.
+/// pieces are handed out in ascending order and no device works below words_cur anymore, so this is exact
+static void mm_ckpt_collect (hashcat_ctx_t *hashcat_ctx, mm_range_t **dst, u32 *cnt, u32 *avail, const bool all)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  if (mm_ctx->ckpt_active == false) return;
+
+  const u64 words_done = mm_ctx->ckpt_base + status_ctx->words_cur;
+
+  for (u32 i = 0; i < mm_ctx->ckpt_own_cnt; i++)
+  {
+    mm_range_t range = mm_ctx->ckpt_own[i];
+
+    if (all == false) range.end = MIN (range.end, words_done);
+
+    if (range.start >= range.end) continue;
+
+    mm_range_add (dst, cnt, avail, &range);
+  }
+}
+
+/// queue the real ranges behind [start, end) of the unfinished part of a resumed epoch
+void mm_ckpt_map (hashcat_ctx_t *hashcat_ctx, const u64 start, const u64 end)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->ckpt_queue_pos == mm_ctx->ckpt_queue_cnt)
+  {
+    mm_ctx->ckpt_queue_pos = 0;
+    mm_ctx->ckpt_queue_cnt = 0;
+  }
+
+  u64 pos = 0;
+
+  for (u32 i = 0; i < mm_ctx->ckpt_left_cnt; i++)
+  {
+    const mm_range_t *left = mm_ctx->ckpt_left + i;
+
+    const u64 len = left->end - left->start;
+
+    if ((start < pos + len) && (end > pos))
+    {
+      mm_range_t range = *left;
+
+      range.start = left->start + (MAX (start, pos) - pos);
+      range.end   = left->start + (MIN (end, pos + len) - pos);
+
+      mm_range_add (&mm_ctx->ckpt_queue, &mm_ctx->ckpt_queue_cnt, &mm_ctx->ckpt_queue_avail, &range);
+    }
+
+    pos += len;
+
+    if (pos >= end) break;
+  }
+}
+
+/// make the next queued range the current one
+u64 mm_ckpt_pop (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  if (mm_ctx->ckpt_queue_pos == mm_ctx->ckpt_queue_cnt) return 0;
+
+  const mm_range_t *range = mm_ctx->ckpt_queue + mm_ctx->ckpt_queue_pos++;
+
+  status_ctx->words_off  = range->start;
+  status_ctx->words_base = range->end;
+
+  mm_ckpt_own (hashcat_ctx, range->start, range->end);
+
+  return range->end - range->start;
+}
+
+/// collective, rank 0 reads what an earlier session of the job finished and hands it to every rank.
+/// --mm-degraded tracks the ranges as well, a failed rank may leave some of them to the others
+int mm_ckpt_init (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t             *mm_ctx             = hashcat_ctx->mm_ctx;
+  restore_ctx_t        *restore_ctx        = hashcat_ctx->restore_ctx;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+
+  mm_ctx->ckpt       = false;
+  mm_ctx->ckpt_write = false;
+  mm_ctx->degraded   = false;
+
+  const bool ckpt_write = (user_options->mm_cluster_restore == true) && (restore_ctx->enabled == true);
+
+  if ((ckpt_write == false) && (user_options->mm_degraded == false)) return 0;
+
+  if ((user_options->attack_mode != ATTACK_MODE_STRAIGHT) && (user_options->attack_mode != ATTACK_MODE_BF))
+  {
+    if (ckpt_write == true) event_log_warning (hashcat_ctx, "--mm-cluster-restore supports straight and mask attacks only, ignored.");
+
+    if (user_options->mm_degraded == true) event_log_warning (hashcat_ctx, "--mm-degraded supports straight and mask attacks only, an error stops all ranks.");
+
+    return 0;
+  }
+
+  if ((user_options->attack_mode == ATTACK_MODE_STRAIGHT) && (user_options_extra->wordlist_mode != WL_MODE_FILE)) return 0;
+
+  mm_ctx->ckpt       = true;
+  mm_ctx->ckpt_write = ckpt_write;
+  mm_ctx->degraded   = user_options->mm_degraded;
+
+  /// a repair pass got its ranges from mm_degraded_repair() already
+  if ((ckpt_write == true) && (restore_ctx->restored == true) && (mm_ctx->repairs == 0))
+  {
+    int hdr[2] = { 0, 0 }; /// { rc, ranges }
+
+    if (hashcat_ctx->cur_proc_id == 0)
+    {
+      hdr[0] = read_restore_ranges (hashcat_ctx);
+      hdr[1] = (int) mm_ctx->ckpt_restored_cnt;
+    }
+
+    #if defined (ENABLE_MPI)
+    MPI_Bcast (hdr, 2, MPI_INT, 0, mm_ctx->comm);
+
+    if (hdr[0] == -1) return -1;
+
+    if (hashcat_ctx->cur_proc_id != 0)
+    {
+      mm_ctx->ckpt_restored       = (mm_range_t *) hccalloc (MAX (1, hdr[1]), sizeof (mm_range_t));
+      mm_ctx->ckpt_restored_cnt   = hdr[1];
+      mm_ctx->ckpt_restored_avail = MAX (1, hdr[1]);
+    }
+
+    mm_bcast_bytes (hashcat_ctx, mm_ctx->ckpt_restored, (u64) hdr[1] * sizeof (mm_range_t));
+    #else
+    if (hdr[0] == -1) return -1;
+    #endif
+  }
+
+  /// they have to survive the next checkpoint, no matter if their epochs run again
+  if ((hashcat_ctx->cur_proc_id == 0) && (mm_ctx->ckpt_restored_cnt > 0)) mm_ckpt_merge (hashcat_ctx, mm_ctx->ckpt_restored, mm_ctx->ckpt_restored_cnt);
+
+  return 0;
+}
+
+/// start tracking the current epoch, called from inner2_loop as soon as its keyspace is known.
+/// returns 1 if an earlier session finished all of it
+int mm_ckpt_begin (hashcat_ctx_t *hashcat_ctx)
+{
+  induct_ctx_t   *induct_ctx   = hashcat_ctx->induct_ctx;
+  mask_ctx_t     *mask_ctx     = hashcat_ctx->mask_ctx;
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (mm_ctx->ckpt == false) return 0;
+
+  /// the monitor may be collecting the ranges of the last epoch right now
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  mm_ctx->ckpt_active    = false;
+  mm_ctx->ckpt_resumed   = false;
+  mm_ctx->ckpt_own_cnt   = 0;
+  mm_ctx->ckpt_left_cnt  = 0;
+  mm_ctx->ckpt_queue_cnt = 0;
+  mm_ctx->ckpt_queue_pos = 0;
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+
+  /// induction dicts come and go, they are no epoch of their own
+  if (induct_ctx->induction_dictionaries_cnt > 0) return 0;
+
+  const u32 epoch = (mask_ctx->masks_pos * MAX (1, straight_ctx->dicts_cnt)) + straight_ctx->dicts_pos;
+
+  const u64 total = (user_options->attack_mode == ATTACK_MODE_STRAIGHT) ? hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_cnt : mm_ctx->epoch_total;
+
+  /// what the earlier session did not finish of this epoch, the restored ranges are sorted and merged
+  bool seen = false;
+
+  u64 pos = 0;
+
+  for (u32 i = 0; i < mm_ctx->ckpt_restored_cnt; i++)
+  {
+    const mm_range_t *range = mm_ctx->ckpt_restored + i;
+
+    if (range->epoch != epoch) continue;
+
+    if (range->total != total)
+    {
+      if (hashcat_ctx->cur_proc_id == 0)
+      {
+        event_log_warning (hashcat_ctx, "Keyspace of epoch %u changed since the checkpoint, it starts over.", epoch);
+      }
+
+      mm_ctx->ckpt_left_cnt = 0;
+
+      pos = 0;
+
+      break;
+    }
+
+    if (range->start > pos)
+    {
+      const mm_range_t left = { epoch, total, pos, range->start };
+
+      mm_range_add (&mm_ctx->ckpt_left, &mm_ctx->ckpt_left_cnt, &mm_ctx->ckpt_left_avail, &left);
+    }
+
+    pos = MAX (pos, range->end);
+
+    seen = true;
+  }
+
+  if (pos < total)
+  {
+    const mm_range_t left = { epoch, total, pos, total };
+
+    mm_range_add (&mm_ctx->ckpt_left, &mm_ctx->ckpt_left_cnt, &mm_ctx->ckpt_left_avail, &left);
+  }
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  mm_ctx->ckpt_epoch  = epoch;
+  mm_ctx->ckpt_total  = total;
+  mm_ctx->ckpt_base   = 0;
+  mm_ctx->ckpt_active = true;
+
+  /// in a restored job every epoch is split over what is left of it, the old slices do not fit the new world size
+  mm_ctx->ckpt_resumed = (mm_ctx->ckpt_restored_cnt > 0);
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+
+  if ((seen == true) && (mm_ctx->ckpt_left_cnt == 0))
+  {
+    mm_ctx->ckpt_active  = false;
+    mm_ctx->ckpt_resumed = false;
+
+    return 1;
+  }
+
+  return 0;
+}
+
+/// take our share of the epoch, called from inner2_loop right before the cracker threads start.
+/// a resumed epoch is split over its unfinished ranges, with the current world size and speeds
+void mm_ckpt_split (hashcat_ctx_t *hashcat_ctx)
+{
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (mm_ctx->ckpt_active == false) return;
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  if (mm_ctx->ckpt_resumed == false)
+  {
+    /// the dispenser adds its chunks as they are claimed
+    if (mm_ctx->dynamic == false)
+    {
+      if (user_options->attack_mode == ATTACK_MODE_STRAIGHT)
+      {
+        const mm_extend_fd_t *mfd = hashcat_ctx->fd_list + straight_ctx->dicts_pos;
+
+        mm_ctx->ckpt_base = mfd->words_start;
+
+        mm_ckpt_own (hashcat_ctx, mfd->words_start, mfd->words_end + 1);
+      }
+      else
+      {
+        mm_ckpt_own (hashcat_ctx, status_ctx->words_off, status_ctx->words_base);
+      }
+    }
+
+    hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+
+    return;
+  }
+
+  const u64 amplifier_cnt = user_options_extra_amplifier (hashcat_ctx);
+
+  u64 left_total = 0;
+
+  for (u32 i = 0; i < mm_ctx->ckpt_left_cnt; i++)
+  {
+    left_total += mm_ctx->ckpt_left[i].end - mm_ctx->ckpt_left[i].start;
+  }
+
+  status_ctx->words_off     = 0;
+  status_ctx->words_cur     = 0;
+  status_ctx->words_base    = 0;
+  status_ctx->words_off_ori = 0;
+
+  for (u32 i = 0; i < hashes->salts_cnt; i++)
+  {
+    status_ctx->words_progress_restored[i] = 0;
+  }
+
+  if (mm_ctx->dynamic == true)
+  {
+    /// the dispenser counts through the unfinished words only, mm_work_refill() maps them back
+    mm_ctx->epoch_total = left_total;
+    mm_ctx->drained     = (mm_ctx->epoch >= mm_ctx->epochs_cnt) || (left_total == 0);
+
+    status_ctx->words_cnt = left_total * amplifier_cnt;
+  }
+  else
+  {
+    u64 start = 0;
+    u64 end   = 0;
+
+    mm_get_slice (hashcat_ctx, left_total, &start, &end);
+
+    mm_ckpt_map (hashcat_ctx, start, end);
+
+    mm_ckpt_pop (hashcat_ctx);
+
+    mm_ctx->drained = true;
+
+    status_ctx->words_cnt = (end - start) * amplifier_cnt;
+  }
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+}
+
+/// the epoch is over, keep what got finished of it for the next report
+void mm_ckpt_end (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  if (mm_ctx->ckpt_active == false) return;
+
+  const bool all = (status_ctx->devices_status == STATUS_EXHAUSTED);
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  mm_ckpt_collect (hashcat_ctx, &mm_ctx->ckpt_done, &mm_ctx->ckpt_done_cnt, &mm_ctx->ckpt_done_avail, all);
+
+  mm_ctx->ckpt_active  = false;
+  mm_ctx->ckpt_resumed = false;
+  mm_ctx->ckpt_own_cnt = 0;
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+}
+
+/// hand what we finished since the last report to rank 0, rank 0 merges its own right away.
+/// called by the monitor thread before cycle_restore()
+void mm_ckpt_report (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  if (mm_ctx->ckpt == false) return;
+
+  hc_thread_mutex_lock (status_ctx->mux_dispatcher);
+
+  mm_range_t *ranges = mm_ctx->ckpt_done;
+
+  u32 cnt   = mm_ctx->ckpt_done_cnt;
+  u32 avail = mm_ctx->ckpt_done_avail;
+
+  mm_ctx->ckpt_done       = NULL;
+  mm_ctx->ckpt_done_cnt   = 0;
+  mm_ctx->ckpt_done_avail = 0;
+
+  /// the running epoch goes out again every time, up to where it is now
+  mm_ckpt_collect (hashcat_ctx, &ranges, &cnt, &avail, false);
+
+  hc_thread_mutex_unlock (status_ctx->mux_dispatcher);
+
+  if (cnt == 0)
+  {
+    hcfree (ranges);
+
+    return;
+  }
+
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    mm_ckpt_merge (hashcat_ctx, ranges, cnt);
+
+    hcfree (ranges);
+
+    return;
+  }
+
+  #if defined (ENABLE_MPI)
+  mm_share_keep (hashcat_ctx, ranges);
+
+  mm_notify_isend (hashcat_ctx, ranges, (int) (cnt * sizeof (mm_range_t)), MPI_BYTE, 0, MM_TAG_CKPT);
+  #endif
+}
+
+/// the first epoch not finished as a whole, where a restored job starts
+void mm_ckpt_position (const hashcat_ctx_t *hashcat_ctx, u32 *masks_pos, u32 *dicts_pos)
+{
+  const mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  const straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+
+  u32 epoch = 0;
+
+  /// sorted and merged, a finished epoch is a single [0, total) range
+  for (u32 i = 0; i < mm_ctx->ckpt_set_cnt; i++)
+  {
+    const mm_range_t *range = mm_ctx->ckpt_set + i;
+
+    if (range->epoch != epoch) break;
+
+    if ((range->start > 0) || (range->end < range->total)) break;
+
+    epoch++;
+  }
+
+  /// all done, the last one starts and leaves again right away
+  if (epoch >= mm_ctx->epochs_cnt) epoch = mm_ctx->epochs_cnt - 1;
+
+  const u32 dicts_cnt = MAX (1, straight_ctx->dicts_cnt);
+
+  *masks_pos = epoch / dicts_cnt;
+  *dicts_pos = epoch % dicts_cnt;
+}
+
+#if defined (ENABLE_MPI)
+/// leave or stay in a smaller mm_ctx->comm, the ranks staying keep their order. collective over mm_ctx->comm
+static void mm_degraded_shrink (hashcat_ctx_t *hashcat_ctx, const bool leave)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  MPI_Comm comm = MPI_COMM_NULL;
+
+  MPI_Comm_split (mm_ctx->comm, (leave == true) ? MPI_UNDEFINED : 0, hashcat_ctx->cur_proc_id, &comm);
+
+  /// the node layout goes with the old numbering, mm_work_init() finds it again
+  if (mm_ctx->topology == true)
+  {
+    MPI_Comm_free (&mm_ctx->node_comm);
+
+    hcfree (mm_ctx->leader_of);
+
+    mm_ctx->leader_of = NULL;
+    mm_ctx->topology  = false;
+  }
+
+  MPI_Comm_free (&mm_ctx->comm);
+
+  mm_ctx->comm = comm;
+
+  if (leave == true) return;
+
+  MPI_Comm_rank (comm, &hashcat_ctx->cur_proc_id);
+  MPI_Comm_size (comm, &hashcat_ctx->total_proc_cnt);
+
+  potfile_shard_renumber (hashcat_ctx);
+}
+#endif
+
+/// --mm-degraded: the ranks whose session init failed sit the job out, the others run it without them.
+/// collective, returns how many ranks run the job we are in, 0 if we are out
+int mm_degraded_init (hashcat_ctx_t *hashcat_ctx, const int inited_all)
+{
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (user_options->mm_degraded == false) return inited_all;
+
+  if ((inited_all == 0) || (inited_all == hashcat_ctx->total_proc_cnt)) return inited_all;
+
+  const int  total_proc_cnt = hashcat_ctx->total_proc_cnt;
+  const bool leave          = (hashcat_ctx->inited == 0);
+
+  #if defined (ENABLE_MPI)
+  mm_degraded_shrink (hashcat_ctx, leave);
+  #endif
+
+  if (leave == true) return 0;
+
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    event_log_warning (hashcat_ctx, "%d of %d ranks failed to initialize, the other %d run without them.", total_proc_cnt - inited_all, total_proc_cnt, inited_all);
+  }
+
+  return inited_all;
+}
+
+/// --mm-degraded, after outer_loop(): if some ranks failed and all others ran out of work, the others attack
+/// once more what is left, split between them. collective, returns 1 if this rank has to run outer_loop() again
+int mm_degraded_repair (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  if (mm_ctx->degraded == false) return 0;
+
+  /// the next pass sets it again, unless it has nothing to do
+  mm_ctx->degraded = false;
+
+  const bool failed = (mm_ctx->failed == true) || (hashcat_ctx->cracked[2] == 1);
+
+  /// { failed ranks, healthy ranks which stopped for another reason than running out of work }
+  int cnts[2] = { 0, 0 };
+
+  cnts[0] = (failed == true) ? 1 : 0;
+  cnts[1] = ((failed == false) && (status_ctx->devices_status != STATUS_EXHAUSTED)) ? 1 : 0;
+
+  #if defined (ENABLE_MPI)
+  MPI_Allreduce (MPI_IN_PLACE, cnts, 2, MPI_INT, MPI_SUM, mm_ctx->comm);
+  #endif
+
+  if ((cnts[0] == 0) || (cnts[0] == hashcat_ctx->total_proc_cnt) || (cnts[1] > 0)) return 0;
+
+  #if defined (ENABLE_MPI)
+  /// rank 0 got the final report of every rank, the failed ones included
+  u32 cnt = (hashcat_ctx->cur_proc_id == 0) ? mm_ctx->ckpt_set_cnt : 0;
+
+  MPI_Bcast (&cnt, 1, MPI_UNSIGNED, 0, mm_ctx->comm);
+
+  hcfree (mm_ctx->ckpt_restored);
+
+  mm_ctx->ckpt_restored       = (mm_range_t *) hccalloc (MAX (1, cnt), sizeof (mm_range_t));
+  mm_ctx->ckpt_restored_cnt   = cnt;
+  mm_ctx->ckpt_restored_avail = MAX (1, cnt);
+
+  if (hashcat_ctx->cur_proc_id == 0) memcpy (mm_ctx->ckpt_restored, mm_ctx->ckpt_set, cnt * sizeof (mm_range_t));
+
+  mm_bcast_bytes (hashcat_ctx, mm_ctx->ckpt_restored, (u64) cnt * sizeof (mm_range_t));
+
+  /// whoever is rank 0 next merges them into its set in mm_ckpt_init()
+  hcfree (mm_ctx->ckpt_set);
+
+  mm_ctx->ckpt_set       = NULL;
+  mm_ctx->ckpt_set_cnt   = 0;
+  mm_ctx->ckpt_set_avail = 0;
+
+  mm_degraded_shrink (hashcat_ctx, failed);
+
+  if (failed == true) return 0;
+
+  hashcat_ctx->cracked[0] = 0;
+  hashcat_ctx->cracked[1] = 0;
+  hashcat_ctx->cracked[2] = 0;
+
+  mm_ctx->repairs++;
+
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    event_log_warning (hashcat_ctx, "%d rank(s) failed, the other %d take over what they left (pass %u).", cnts[0], hashcat_ctx->total_proc_cnt, mm_ctx->repairs);
+  }
+
+  return 1;
+  #else
+  return 0;
+  #endif
+}
@@ -0,0 +1,906 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+#include "common.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if defined (_POSIX)
+#include <sys/mman.h>
+#endif
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "mm_impl.h"
+#include "mm_dict.h"
+#include "memory.h"
+#include "shared.h"
+#include "locking.h"
+#include "thread.h"
+#include "event.h"
+#include "folder.h"
+#include "ext_lzma.h"
+
+/// absolute path of a file that exists, free () it. keys the on-disk caches of a file
+char *mm_realpath (const char *path)
+{
+  #if defined (_WIN)
+  return _fullpath (NULL, path, 0);
+  #else
+  return realpath (path, NULL);
+  #endif
+}
+
+long left_size (mm_extend_fd_t *mfd, FILE *fd)
+{
+  long cur_pos = ftell (fd);
+  if (mfd->word_base == 0)
+  {
+    return ((u64) cur_pos >= mfd->words_end_off) ? 0 : (long) (mfd->words_end_off - cur_pos);
+  }
+  if ((unsigned long)cur_pos > mfd->words_end * mfd->word_base)
+  {
+    return 0;
+  }
+  return (1 + mfd->words_end ) * mfd->word_base - cur_pos;
+}
+
+int mm_feof (mm_extend_fd_t *mfd, FILE* fd)
+{
+   if (mfd->word_base == 0)
+   {
+     return (left_size (mfd, fd) == 0) ? 1 : 0;
+   }
+   long cur_pos = ftell (fd) / mfd->word_base;
+   if ((unsigned long)cur_pos > mfd -> words_end)
+   {
+     return 1;
+   }
+   return 0;
+}
+
+/// byte offset of record idx of the mfd range. newline dicts start at the closest indexed line before it
+/// and count the lines from there, which reads at most MM_DICT_INDEX_STRIDE lines
+u64 mm_word_offset (const mm_extend_fd_t *mfd, FILE *fd, const u64 idx)
+{
+  const u64 line = mfd->words_start + idx;
+
+  if (mfd->word_base > 0) return line * mfd->word_base;
+
+  if (line >= mfd->words_cnt) return mfd->file_size;
+
+  u64 off  = mfd->line_offs[line / MM_DICT_INDEX_STRIDE];
+  u64 left = line % MM_DICT_INDEX_STRIDE;
+
+  char buf[0x10000];
+
+  /// pread () leaves the position of fd alone. the stream of a compressed dict has no descriptor, it is put back below,
+  /// as is every dict where pread () is missing
+  #if defined (_WIN)
+  const int  fno = -1;
+  #else
+  const int  fno = fileno (fd);
+  #endif
+
+  const long pos = (fno == -1) ? ftell (fd) : 0;
+
+  while (left > 0)
+  {
+    ssize_t nread = 0;
+
+    if (fno == -1)
+    {
+      if (fseek (fd, (long) off, SEEK_SET) == 0) nread = (ssize_t) fread (buf, 1, sizeof (buf), fd);
+    }
+    else
+    {
+      #if defined (_POSIX)
+      nread = pread (fno, buf, sizeof (buf), (off_t) off);
+      #endif
+    }
+
+    if (nread <= 0) break;
+
+    ssize_t i = 0;
+
+    while ((i < nread) && (left > 0))
+    {
+      if (buf[i++] == '\n') left--;
+    }
+
+    off += (u64) i;
+  }
+
+  if (fno == -1) fseek (fd, pos, SEEK_SET);
+
+  return off;
+}
+
+/// the index of a newline dict is only good for the very same file
+static bool mm_dict_index_key (hashcat_ctx_t *hashcat_ctx, const char *dict_file, const hc_stat_t *st, mm_dict_index_hdr_t *hdr, char **index_file)
+{
+  const folder_config_t *folder_config = hashcat_ctx->folder_config;
+
+  if ((folder_config == NULL) || (folder_config->profile_dir == NULL)) return false;
+
+  char *dictfile = mm_realpath (dict_file);
+
+  if (dictfile == NULL) return false;
+
+  const size_t dictfile_len = strlen (dictfile);
+
+  if (dictfile_len >= sizeof (hdr->dictfile))
+  {
+    free (dictfile);
+
+    return false;
+  }
+
+  memset (hdr, 0, sizeof (mm_dict_index_hdr_t));
+
+  hdr->magic      = MM_DICT_INDEX_MAGIC;
+  hdr->version    = MM_DICT_INDEX_VERSION;
+  hdr->stride     = MM_DICT_INDEX_STRIDE;
+  hdr->file_size  = (u64) st->st_size;
+  hdr->file_mtime = (u64) st->st_mtime;
+
+  memcpy (hdr->dictfile, dictfile, dictfile_len);
+
+  free (dictfile);
+
+  /// FNV-1a, like the hash cache
+  u64 key = 0xcbf29ce484222325;
+
+  for (size_t i = 0; i < dictfile_len; i++)
+  {
+    key ^= (u8) hdr->dictfile[i];
+    key *= 0x100000001b3;
+  }
+
+  hc_asprintf (index_file, "%s/hashcat.dictidx.%08x%08x", folder_config->profile_dir, (u32) (key >> 32), (u32) key);
+
+  return true;
+}
+
+/// slots of line_offs the lines of a dict need, the first one is line 0 at offset 0
+static u64 mm_dict_index_slots (const u64 lines_cnt)
+{
+  return (lines_cnt == 0) ? 1 : ((lines_cnt - 1) / MM_DICT_INDEX_STRIDE) + 1;
+}
+
+static bool mm_dict_index_load (const char *index_file, const mm_dict_index_hdr_t *key, mm_extend_fd_t *mfd)
+{
+  FILE *fp = fopen (index_file, "rb");
+
+  if (fp == NULL) return false;
+
+  mm_dict_index_hdr_t hdr;
+
+  if ((fread (&hdr, sizeof (hdr), 1, fp) != 1) || (memcmp (&hdr, key, offsetof (mm_dict_index_hdr_t, lines_cnt)) != 0) || (strcmp (hdr.dictfile, key->dictfile) != 0))
+  {
+    fclose (fp);
+
+    return false;
+  }
+
+  if (hdr.offs_cnt != mm_dict_index_slots (hdr.lines_cnt))
+  {
+    fclose (fp);
+
+    return false;
+  }
+
+  u64 *line_offs = (u64 *) hcmalloc (hdr.offs_cnt * sizeof (u64));
+
+  if (fread (line_offs, sizeof (u64), hdr.offs_cnt, fp) != hdr.offs_cnt)
+  {
+    hcfree (line_offs);
+
+    fclose (fp);
+
+    return false;
+  }
+
+  fclose (fp);
+
+  mfd->words_cnt = hdr.lines_cnt;
+  mfd->line_offs = line_offs;
+  mfd->offs_cnt  = hdr.offs_cnt;
+
+  return true;
+}
+
+/// written through a private temp file, ranks sharing the profile dir may build the same index at once
+static void mm_dict_index_save (const char *index_file, const mm_dict_index_hdr_t *key, const mm_extend_fd_t *mfd)
+{
+  mm_dict_index_hdr_t hdr = *key;
+
+  hdr.lines_cnt = mfd->words_cnt;
+  hdr.offs_cnt  = mfd->offs_cnt;
+
+  char *tmp_file = NULL;
+
+  hc_asprintf (&tmp_file, "%s.%d.tmp", index_file, (int) getpid ());
+
+  FILE *fp = fopen (tmp_file, "wb");
+
+  if (fp == NULL)
+  {
+    hcfree (tmp_file);
+
+    return;
+  }
+
+  const bool ok = (fwrite (&hdr, sizeof (hdr), 1, fp) == 1) && (fwrite (mfd->line_offs, sizeof (u64), hdr.offs_cnt, fp) == hdr.offs_cnt);
+
+  if ((fclose (fp) != 0) || (ok == false) || (rename (tmp_file, index_file) != 0))
+  {
+    unlink (tmp_file);
+  }
+
+  hcfree (tmp_file);
+}
+
+/// count the lines of a newline dict and note where every MM_DICT_INDEX_STRIDE-th one starts.
+/// a last line without a newline counts as well
+static int mm_dict_index_build (hashcat_ctx_t *hashcat_ctx, const char *dict_file, mm_extend_fd_t *mfd)
+{
+  FILE *fp = mm_dict_open (hashcat_ctx, dict_file);
+
+  if (fp == NULL) return -1;
+
+  u64  offs_avail = 1024;
+  u64 *line_offs  = (u64 *) hccalloc (offs_avail, sizeof (u64));
+
+  char *buf = (char *) hcmalloc (0x100000);
+
+  u64 lines_cnt = 0;
+  u64 pos       = 0;
+  u64 line_beg  = 0;
+
+  size_t nread;
+
+  while ((nread = fread (buf, 1, 0x100000, fp)) > 0)
+  {
+    for (size_t i = 0; i < nread; i++)
+    {
+      if (buf[i] != '\n') continue;
+
+      lines_cnt++;
+
+      line_beg = pos + i + 1;
+
+      if ((lines_cnt % MM_DICT_INDEX_STRIDE) != 0) continue;
+
+      const u64 slot = lines_cnt / MM_DICT_INDEX_STRIDE;
+
+      if (slot == offs_avail)
+      {
+        line_offs = (u64 *) hcrealloc (line_offs, offs_avail * sizeof (u64), offs_avail * sizeof (u64));
+
+        offs_avail *= 2;
+      }
+
+      line_offs[slot] = line_beg;
+    }
+
+    pos += nread;
+  }
+
+  if (line_beg < pos) lines_cnt++;
+
+  hcfree (buf);
+
+  const bool failed = (ferror (fp) != 0);
+
+  fclose (fp);
+
+  if (failed == true)
+  {
+    hcfree (line_offs);
+
+    errno = EIO;
+
+    return -1;
+  }
+
+  /// a last line without a newline got no slot of its own after the scan, it needs none either: the slots cover
+  /// the lines up to the last newline and the one right behind it
+  mfd->words_cnt = lines_cnt;
+  mfd->line_offs = line_offs;
+  mfd->offs_cnt  = mm_dict_index_slots (lines_cnt);
+
+  return 0;
+}
+
+/// check the header and the block index of a compressed dict, fp is right behind the magic
+static bool mm_wlz_load_hdr (FILE *fp, mm_wlz_hdr_t *hdr, u64 **block_offs)
+{
+  struct stat st;
+
+  if (fstat (fileno (fp), &st) == -1) return false;
+
+  rewind (fp);
+
+  if (fread (hdr, sizeof (mm_wlz_hdr_t), 1, fp) != 1) return false;
+
+  if (hdr->magic   != MM_WLZ_MAGIC)   return false;
+  if (hdr->version != MM_WLZ_VERSION) return false;
+
+  /// Lzma2Dec knows dictionary sizes up to 40
+  if (hdr->props > 40) return false;
+
+  if ((hdr->block_size == 0) || (hdr->block_size > MM_WLZ_BLOCK_MAX)) return false;
+
+  if ((hdr->word_base > 0) && ((hdr->block_size % hdr->word_base) != 0)) return false;
+
+  if (hdr->blocks_cnt != (hdr->raw_size / hdr->block_size) + (((hdr->raw_size % hdr->block_size) > 0) ? 1 : 0)) return false;
+
+  if ((hdr->index_off > (u64) st.st_size) || (hdr->blocks_cnt >= ((u64) st.st_size - hdr->index_off) / sizeof (u64))) return false;
+
+  u64 *offs = (u64 *) hcmalloc ((hdr->blocks_cnt + 1) * sizeof (u64));
+
+  bool ok = (fseek (fp, (long) hdr->index_off, SEEK_SET) == 0) && (fread (offs, sizeof (u64), hdr->blocks_cnt + 1, fp) == hdr->blocks_cnt + 1);
+
+  /// LZMA2 adds a few bytes per 64k chunk if the data does not compress at all
+  const u64 comp_max = hdr->block_size + (hdr->block_size / 16) + 4096;
+
+  ok = ok && (offs[0] >= sizeof (mm_wlz_hdr_t)) && (offs[hdr->blocks_cnt] <= hdr->index_off);
+
+  for (u64 block = 0; (ok == true) && (block < hdr->blocks_cnt); block++)
+  {
+    ok = (offs[block] <= offs[block + 1]) && ((offs[block + 1] - offs[block]) <= comp_max);
+  }
+
+  if ((ok == false) || (block_offs == NULL))
+  {
+    hcfree (offs);
+
+    return ok;
+  }
+
+  *block_offs = offs;
+
+  return true;
+}
+
+/// 1 if dict_file is a compressed dict and hdr got filled, 0 if it is a plain one or cannot be opened, -1 if it is broken
+static int mm_wlz_probe (const char *dict_file, mm_wlz_hdr_t *hdr)
+{
+  FILE *fp = fopen (dict_file, "rb");
+
+  if (fp == NULL) return 0;
+
+  u32 magic = 0;
+
+  if ((fread (&magic, sizeof (magic), 1, fp) != 1) || (magic != MM_WLZ_MAGIC))
+  {
+    fclose (fp);
+
+    return 0;
+  }
+
+  const bool ok = mm_wlz_load_hdr (fp, hdr, NULL);
+
+  fclose (fp);
+
+  return (ok == true) ? 1 : -1;
+}
+
+#if defined (MM_WLZ_STREAM)
+
+static void mm_wlz_free (mm_wlz_t *wlz)
+{
+  for (int i = 0; i < MM_WLZ_SLOTS; i++) hcfree (wlz->slots[i].buf);
+
+  hcfree (wlz->block_offs);
+  hcfree (wlz->dict_file);
+
+  fclose (wlz->fp);
+
+  hc_thread_cond_delete (wlz->cond_work);
+  hc_thread_cond_delete (wlz->cond_ready);
+
+  hc_thread_mutex_delete (wlz->mux);
+
+  hcfree (wlz);
+}
+
+/// decodes the first block of [cur, cur + MM_WLZ_SLOTS) that is not in the ring yet.
+/// a block lands in the ring only if the reader did not move away from it in the meantime
+static void *mm_wlz_decoder (void *p)
+{
+  mm_wlz_t *wlz = (mm_wlz_t *) p;
+
+  const mm_wlz_hdr_t *hdr = &wlz->hdr;
+
+  u64 comp_max = 0;
+
+  for (u64 block = 0; block < hdr->blocks_cnt; block++)
+  {
+    comp_max = MAX (comp_max, wlz->block_offs[block + 1] - wlz->block_offs[block]);
+  }
+
+  u8 *comp = (u8 *) hcmalloc (MAX (comp_max, 1));
+  u8 *raw  = (u8 *) hcmalloc (hdr->block_size);
+
+  const char props = (char) hdr->props;
+
+  while (true)
+  {
+    hc_thread_mutex_lock (wlz->mux);
+
+    if (wlz->quit == true)
+    {
+      hc_thread_mutex_unlock (wlz->mux);
+
+      break;
+    }
+
+    const u64 last = MIN (wlz->cur + MM_WLZ_SLOTS, hdr->blocks_cnt);
+
+    u64 block = wlz->cur;
+
+    while (block < last)
+    {
+      const mm_wlz_slot_t *slot = wlz->slots + (block % MM_WLZ_SLOTS);
+
+      if ((slot->ready == false) || (slot->block != block)) break;
+
+      block++;
+    }
+
+    const bool idle = (block >= last) || (wlz->error == true);
+
+    if (idle == true)
+    {
+      hc_thread_cond_wait (wlz->cond_work, wlz->mux);
+
+      hc_thread_mutex_unlock (wlz->mux);
+
+      continue;
+    }
+
+    hc_thread_mutex_unlock (wlz->mux);
+
+    const u64 comp_len = wlz->block_offs[block + 1] - wlz->block_offs[block];
+    const u64 raw_len  = MIN (hdr->block_size, hdr->raw_size - (block * hdr->block_size));
+
+    SizeT in_len  = (SizeT) comp_len;
+    SizeT out_len = (SizeT) raw_len;
+
+    bool ok = (fseek (wlz->fp, (long) wlz->block_offs[block], SEEK_SET) == 0) && (fread (comp, 1, comp_len, wlz->fp) == comp_len);
+
+    ok = ok && (hc_lzma2_decompress (comp, &in_len, raw, &out_len, &props) == SZ_OK) && (out_len == raw_len);
+
+    if (ok == false) event_log_error (wlz->hashcat_ctx, "%s: Block %" PRIu64 " of the compressed dict is broken.", wlz->dict_file, block);
+
+    hc_thread_mutex_lock (wlz->mux);
+
+    if (ok == false)
+    {
+      wlz->error = true;
+    }
+    else if ((block >= wlz->cur) && (block < wlz->cur + MM_WLZ_SLOTS))
+    {
+      mm_wlz_slot_t *slot = wlz->slots + (block % MM_WLZ_SLOTS);
+
+      u8 *tmp = slot->buf;
+
+      slot->buf   = raw;
+      slot->block = block;
+      slot->len   = raw_len;
+      slot->ready = true;
+
+      raw = tmp;
+    }
+
+    hc_thread_cond_broadcast (wlz->cond_ready);
+
+    hc_thread_mutex_unlock (wlz->mux);
+  }
+
+  hcfree (comp);
+  hcfree (raw);
+
+  return NULL;
+}
+
+/// copies out of the ring under the lock, the decoder only takes it to look for work and to hand over a block.
+/// a block that is not decoded yet is waited for, moving cur to it wakes the decoder
+static ssize_t mm_wlz_read (void *cookie, char *buf, size_t size)
+{
+  mm_wlz_t *wlz = (mm_wlz_t *) cookie;
+
+  const mm_wlz_hdr_t *hdr = &wlz->hdr;
+
+  size_t done  = 0;
+  bool   error = false;
+
+  while ((done < size) && (wlz->pos < hdr->raw_size) && (error == false))
+  {
+    const u64 block = wlz->pos / hdr->block_size;
+
+    hc_thread_mutex_lock (wlz->mux);
+
+    if (wlz->cur != block)
+    {
+      wlz->cur = block;
+
+      hc_thread_cond_signal (wlz->cond_work);
+    }
+
+    const mm_wlz_slot_t *slot = wlz->slots + (block % MM_WLZ_SLOTS);
+
+    const bool ready = (slot->ready == true) && (slot->block == block);
+
+    if (ready == true)
+    {
+      const u64    off = wlz->pos - (block * hdr->block_size);
+      const size_t len = (size_t) MIN ((u64) (size - done), slot->len - off);
+
+      memcpy (buf + done, slot->buf + off, len);
+
+      done     += len;
+      wlz->pos += len;
+    }
+    else if (wlz->error == false)
+    {
+      hc_thread_cond_wait (wlz->cond_ready, wlz->mux);
+    }
+
+    error = wlz->error;
+
+    hc_thread_mutex_unlock (wlz->mux);
+  }
+
+  if ((done == 0) && (error == true))
+  {
+    errno = EIO;
+
+    return -1;
+  }
+
+  return (ssize_t) done;
+}
+
+/// offsets are uncompressed ones, the decoder goes on at the block of the new position right away
+static int mm_wlz_seek (void *cookie, off64_t *offset, int whence)
+{
+  mm_wlz_t *wlz = (mm_wlz_t *) cookie;
+
+  off64_t base = 0;
+
+  if      (whence == SEEK_SET) base = 0;
+  else if (whence == SEEK_CUR) base = (off64_t) wlz->pos;
+  else if (whence == SEEK_END) base = (off64_t) wlz->hdr.raw_size;
+  else return -1;
+
+  const off64_t target = base + *offset;
+
+  if (target < 0) return -1;
+
+  wlz->pos = (u64) target;
+
+  *offset = target;
+
+  hc_thread_mutex_lock (wlz->mux);
+
+  wlz->cur = wlz->pos / wlz->hdr.block_size;
+
+  hc_thread_cond_signal (wlz->cond_work);
+
+  hc_thread_mutex_unlock (wlz->mux);
+
+  return 0;
+}
+
+static int mm_wlz_close (void *cookie)
+{
+  mm_wlz_t *wlz = (mm_wlz_t *) cookie;
+
+  hc_thread_mutex_lock (wlz->mux);
+
+  wlz->quit = true;
+
+  hc_thread_cond_signal (wlz->cond_work);
+
+  hc_thread_mutex_unlock (wlz->mux);
+
+  hc_thread_wait (1, &wlz->thread);
+
+  mm_wlz_free (wlz);
+
+  return 0;
+}
+
+#endif // MM_WLZ_STREAM
+
+/// open a dict for reading. a compressed dict comes back as a stream of its uncompressed bytes,
+/// fed by a decoder thread and seekable by block, so every rank decodes only the blocks of its range.
+/// a broken block makes the reads fail, the reader has to stop there
+FILE *mm_dict_open (MAYBE_UNUSED hashcat_ctx_t *hashcat_ctx, const char *dict_file)
+{
+  FILE *fp = fopen (dict_file, "rb");
+
+  if (fp == NULL) return NULL;
+
+  u32 magic = 0;
+
+  const bool packed = (fread (&magic, sizeof (magic), 1, fp) == 1) && (magic == MM_WLZ_MAGIC);
+
+  rewind (fp);
+
+  if (packed == false) return fp;
+
+  #if !defined (MM_WLZ_STREAM)
+
+  /// get_entry_cnt () turned the dict down already
+  fclose (fp);
+
+  errno = ENOSYS;
+
+  return NULL;
+
+  #else
+
+  mm_wlz_t *wlz = (mm_wlz_t *) hccalloc (1, sizeof (mm_wlz_t));
+
+  wlz->fp          = fp;
+  wlz->hashcat_ctx = hashcat_ctx;
+  wlz->dict_file   = hcstrdup (dict_file);
+
+  hc_thread_mutex_init (wlz->mux);
+
+  hc_thread_cond_init (wlz->cond_work);
+  hc_thread_cond_init (wlz->cond_ready);
+
+  if (mm_wlz_load_hdr (fp, &wlz->hdr, &wlz->block_offs) == false)
+  {
+    mm_wlz_free (wlz);
+
+    errno = EINVAL;
+
+    return NULL;
+  }
+
+  for (int i = 0; i < MM_WLZ_SLOTS; i++) wlz->slots[i].buf = (u8 *) hcmalloc (wlz->hdr.block_size);
+
+  cookie_io_functions_t io_funcs = { mm_wlz_read, NULL, mm_wlz_seek, mm_wlz_close };
+
+  FILE *fd = fopencookie (wlz, "r", io_funcs);
+
+  if (fd == NULL)
+  {
+    mm_wlz_free (wlz);
+
+    return NULL;
+  }
+
+  hc_thread_create (wlz->thread, mm_wlz_decoder, wlz);
+
+  return fd;
+
+  #endif // MM_WLZ_STREAM
+}
+
+/// parse words_cnt and word_base for dict_file and fill them into mfd.
+/// dict.N holds fixed-width records of N bytes, any other dict is read line by line through a sparse line index.
+/// a compressed dict brings its record width along, its sizes and offsets are those of the uncompressed data
+int get_entry_cnt(hashcat_ctx_t *hashcat_ctx, char *dict_file, mm_extend_fd_t * mfd)
+{
+  /// input check
+  if (NULL == dict_file || mfd == NULL)
+  {
+    event_log_error (hashcat_ctx, "get_entry_cnt: no dict given.");
+
+    return -1;
+  }
+
+  mm_wlz_hdr_t wlz_hdr;
+
+  const int packed = mm_wlz_probe (dict_file, &wlz_hdr);
+
+  if (packed == -1)
+  {
+    event_log_error (hashcat_ctx, "%s: Broken header or block index of a compressed dict.", dict_file);
+
+    return -1;
+  }
+
+  #if !defined (MM_WLZ_STREAM)
+  if (packed == 1)
+  {
+    event_log_error (hashcat_ctx, "%s: Compressed dicts are not supported on this platform.", dict_file);
+
+    return -1;
+  }
+  #endif
+
+  /// parse the filename to get the unit len
+  char *pch= strrchr (dict_file, '.');
+  int wbase = (packed == 1) ? (int) wlz_hdr.word_base : ((pch != NULL) ? atoi (pch + 1) : 0);
+
+  unsigned long num = 0;
+  unsigned long file_size = 0;
+  struct stat statbuff;
+  if (stat (dict_file, &statbuff) >= 0)
+  {
+    file_size = (packed == 1) ? wlz_hdr.raw_size : (u64) statbuff.st_size;
+    num = (wbase > 0) ? file_size / wbase : 0;
+  }
+  else
+  {
+    event_log_error (hashcat_ctx, "%s: %s", dict_file, strerror (errno));
+
+    return -1;
+  }
+
+  mfd->file_size = file_size;
+  mfd->line_offs = NULL;
+  mfd->offs_cnt  = 0;
+  mfd->packed    = (packed == 1);
+  mfd->dict_file = hcstrdup (dict_file);
+
+  if (wbase > 0)
+  {
+    mfd->words_cnt = num;
+    mfd->word_base = wbase;
+
+    return 1;
+  }
+
+  /// newline dict
+  mfd->word_base = 0;
+
+  mm_dict_index_hdr_t hdr;
+
+  char *index_file = NULL;
+
+  const bool keyed = mm_dict_index_key (hashcat_ctx, dict_file, &statbuff, &hdr, &index_file);
+
+  if ((keyed == true) && (mm_dict_index_load (index_file, &hdr, mfd) == true))
+  {
+    hcfree (index_file);
+
+    return 1;
+  }
+
+  /// no usable index in the profile dir, fall back to a full scan of the dict. a dict that cannot be scanned
+  /// cannot be read either, that is an error and not a reason to go on without an index
+  if (mm_dict_index_build (hashcat_ctx, dict_file, mfd) == -1)
+  {
+    event_log_error (hashcat_ctx, "%s: Could not build the line index: %s", dict_file, strerror (errno));
+
+    release_entry_cnt (mfd);
+
+    hcfree (index_file);
+
+    return -1;
+  }
+
+  if (keyed == true) mm_dict_index_save (index_file, &hdr, mfd);
+
+  hcfree (index_file);
+
+  return 1;
+}
+
+/// free what get_entry_cnt () allocated for mfd
+void release_entry_cnt (mm_extend_fd_t *mfd)
+{
+  hcfree (mfd->line_offs);
+  hcfree (mfd->dict_file);
+
+  mfd->line_offs = NULL;
+  mfd->dict_file = NULL;
+}
+
+/// position fd on record idx of the mfd range and drop whatever wl_data still buffers
+void mm_seek_word (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd, FILE *fd, const u64 idx)
+{
+  wl_data_t *wl_data = hashcat_ctx->wl_data;
+
+  fseek (fd, (long) mm_word_offset (mfd, fd, idx), SEEK_SET);
+
+  wl_data->pos = 0;
+  wl_data->cnt = 0;
+}
+
+/// map the whole dict read-only, the records are fixed width so word idx is found without reading the ones
+/// before it. returns -1 if the dict has to be read through mm_seek_word()/get_next_word() instead, always without mmap ()
+int mm_map_open (MAYBE_UNUSED const char *dictfile, const mm_extend_fd_t *mfd, mm_map_t *map)
+{
+  map->base      = NULL;
+  map->size      = 0;
+  map->start     = mfd->words_start;
+  map->word_base = mfd->word_base;
+
+  /// newline dicts have no fixed place for a word, compressed ones none in the file
+  if ((mfd->word_base == 0) || (mfd->packed == true)) return -1;
+
+  #if defined (_WIN)
+
+  return -1;
+
+  #else
+
+  const int fd = open (dictfile, O_RDONLY);
+
+  if (fd == -1) return -1;
+
+  struct stat st;
+
+  if ((fstat (fd, &st) == -1) || (st.st_size == 0))
+  {
+    close (fd);
+
+    return -1;
+  }
+
+  void *base = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  /// the mapping keeps the file open
+  close (fd);
+
+  if (base == MAP_FAILED) return -1;
+
+  /// each rank walks its range front to back, the kernel can read ahead and drop what is behind us
+  madvise (base, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+  map->base = (char *) base;
+  map->size = (u64) st.st_size;
+
+  return 0;
+
+  #endif
+}
+
+/// we just claimed [words_off, words_fin), start reading it in while the previous batch runs
+void mm_map_advise (const mm_map_t *map, const u64 words_off, const u64 words_fin)
+{
+  if (map->base == NULL) return;
+
+  #if defined (_WIN)
+  const u64 page = 4096;
+  #else
+  const u64 page = (u64) sysconf (_SC_PAGESIZE);
+  #endif
+
+  const u64 beg = (((map->start + words_off) * map->word_base) / page) * page;
+  const u64 end = MIN ((map->start + words_fin) * map->word_base, map->size);
+
+  if (beg >= end) return;
+
+  #if defined (_POSIX)
+  madvise (map->base + beg, (size_t) (end - beg), MADV_WILLNEED);
+  #endif
+}
+
+/// word idx without a copy, out_buf points into the read-only mapping. the records are zero padded
+void mm_map_word (const mm_map_t *map, const u64 idx, char **out_buf, u32 *out_len)
+{
+  char *ptr = map->base + ((map->start + idx) * map->word_base);
+
+  *out_buf = ptr;
+  *out_len = (u32) strnlen (ptr, (size_t) map->word_base);
+}
+
+void mm_map_close (mm_map_t *map)
+{
+  if (map->base == NULL) return;
+
+  #if defined (_POSIX)
+  munmap (map->base, (size_t) map->size);
+  #endif
+
+  map->base = NULL;
+  map->size = 0;
+}
\ No newline at end of file
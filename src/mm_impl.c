@@ -3,76 +3,72 @@
  * License.....: MIT
  */
 
+#include "common.h"
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#if defined (_POSIX)
+#include <sys/mman.h>
+#endif
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <inttypes.h>
 
 #include "mm_impl.h"
+#include "mm_dict.h"
+#include "mm_ckpt.h"
 #include "memory.h"
 #include "shared.h"
 #include "locking.h"
+#include "thread.h"
 #include "hashcat.h"
-
-long left_size (mm_extend_fd_t *mfd, FILE *fd)
+#include "event.h"
+#include "timer.h"
+#include "user_options.h"
+#include "potfile.h"
+#include "restore.h"
+#include "mpsp.h"
+#include "ext_lzma.h"
+
+/// left_size () and mm_feof () run for every segment the reader loads, look up where the range of a newline dict
+/// ends once when the range is set instead of walking the index each time
+static void mm_range_end (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd)
 {
-  long cur_pos = ftell (fd);
-  if ((unsigned long)cur_pos > mfd->words_end * mfd->word_base)
-  {
-    return 0;
-  }
-  return (1 + mfd->words_end ) * mfd->word_base - cur_pos;
-}
+  mfd->words_end_off = 0;
 
-int mm_feof (mm_extend_fd_t *mfd, FILE* fd)
-{
-   long cur_pos = ftell (fd) / mfd->word_base;
-   if ((unsigned long)cur_pos > mfd -> words_end)
-   {
-     return 1;
-   }
-   return 0;
-}
+  if (mfd->is_valid != 1) return;
 
-/// parse words_cnt and word_base for dict_file and fill them into mfd
-int get_entry_cnt(char *dict_file, mm_extend_fd_t * mfd)
-{
-  /// input check
-  if (NULL == dict_file || mfd == NULL)
+  if (mfd->word_base > 0)
   {
-    printf ("input check failed: get_entry_cnt\n");
-    return -1;
-  }
-
-  /// parse the filename to get the unit len
-  char *pch= strrchr (dict_file, '.');
-  int wbase = atoi (pch + 1);
+    mfd->words_end_off = (mfd->words_end + 1) * mfd->word_base;
 
-  /// if err happened
-  if (wbase <= 0)
-  {
-    printf ("wordbase parse failed, dict_file: %s\n", dict_file);
-    return -1;
+    return;
   }
 
-  unsigned long num = 0;
-  unsigned long file_size = 0;
-  struct stat statbuff;
-  if (stat (dict_file, &statbuff) >= 0)
+  /// the whole dict needs no lookup
+  if (mfd->words_end + 1 >= mfd->words_cnt)
   {
-    file_size = statbuff.st_size;
-    num = file_size / wbase;
+    mfd->words_end_off = mfd->file_size;
+
+    return;
   }
-  else
+
+  FILE *fp = mm_dict_open (hashcat_ctx, mfd->dict_file);
+
+  if (fp == NULL)
   {
-    printf ("status check failed, dict_file: %s\n", dict_file);
-    return -1;
+    mfd->words_end_off = mfd->file_size;
+
+    return;
   }
-  mfd->words_cnt = num;
-  mfd->word_base = wbase;
 
-  return 1;
+  mfd->words_end_off = mm_word_offset (mfd, fp, mfd->words_end - mfd->words_start + 1);
+
+  fclose (fp);
 }
 
 /// divide all dict words among different mpi processes
@@ -82,27 +78,55 @@ int straight_divide_workload (hashcat_ctx_t *hashcat_ctx)
   status_ctx_t   *status_ctx = hashcat_ctx->status_ctx;
   straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
 
+  /// a combinator attack has only its base side dict in fd_list
+  const u32 fd_cnt = (hashcat_ctx->user_options->attack_mode == ATTACK_MODE_COMBI) ? 1 : straight_ctx->dicts_cnt;
+
+  /// the dynamic dispenser hands out the records, every rank walks every dict.
+  /// the speed split does the same until the first autotune told us how fast everybody is,
+  /// a restored cluster checkpoint splits each dict on its own
+  if ((hashcat_ctx->mm_ctx->dynamic == true) || (hashcat_ctx->mm_ctx->speed_pending == true) || (hashcat_ctx->mm_ctx->ckpt_restored_cnt > 0))
+  {
+    for (uint pos = 0; pos < fd_cnt; pos++)
+    {
+      hashcat_ctx->fd_list[pos].words_start = 0;
+      hashcat_ctx->fd_list[pos].words_end = (hashcat_ctx->fd_list[pos].words_cnt > 0) ? hashcat_ctx->fd_list[pos].words_cnt - 1 : 0;
+      hashcat_ctx->fd_list[pos].is_valid = (hashcat_ctx->fd_list[pos].words_cnt > 0) ? 1 : -1;
+
+      mm_range_end (hashcat_ctx, hashcat_ctx->fd_list + pos);
+    }
+
+    return 1;
+  }
+
   unsigned long total_cnts = 0;
-  for (uint pos = 0; pos < straight_ctx->dicts_cnt; pos++)
+  for (uint pos = 0; pos < fd_cnt; pos++)
   {
     total_cnts += hashcat_ctx->fd_list[pos].words_cnt;
   }
 
-  unsigned long cnt_per_process = total_cnts / hashcat_ctx->total_proc_cnt;
-  unsigned long start_mark = hashcat_ctx->cur_proc_id * cnt_per_process;
-  unsigned long end_mark = (hashcat_ctx->cur_proc_id + 1) * cnt_per_process;
+  u64 start_mark = 0;
+  u64 end_mark = 0;
   unsigned long tmp_mark = 0;
 
+  mm_get_slice (hashcat_ctx, total_cnts, &start_mark, &end_mark);
+
   /// initialize
-  for (uint pos = 0; pos < straight_ctx->dicts_cnt; pos++)
+  for (uint pos = 0; pos < fd_cnt; pos++)
   {
     hashcat_ctx->fd_list[pos].words_start = 0;
     hashcat_ctx->fd_list[pos].words_end = 0;
+    hashcat_ctx->fd_list[pos].words_end_off = 0;
     hashcat_ctx->fd_list[pos].is_valid = -1;
   }
 
+  /// a slow rank may end up with nothing at all
+  if (start_mark >= end_mark)
+  {
+    return 1;
+  }
+
   /// [start, end], feof
-  for (uint pos = 0; pos < straight_ctx->dicts_cnt; pos++)
+  for (uint pos = 0; pos < fd_cnt; pos++)
   {
     if (tmp_mark <= start_mark &&
         tmp_mark + hashcat_ctx->fd_list[pos].words_cnt > start_mark)
@@ -118,10 +142,15 @@ int straight_divide_workload (hashcat_ctx_t *hashcat_ctx)
       {
         hashcat_ctx->fd_list[pos].words_end = hashcat_ctx->fd_list[pos].words_cnt - 1;
         status_ctx->words_cnt += hashcat_ctx->fd_list[pos].words_end - hashcat_ctx->fd_list[pos].words_start + 1;
-        for (uint tmp = pos + 1; tmp < straight_ctx->dicts_cnt; tmp++)
+        for (uint tmp = pos + 1; tmp < fd_cnt; tmp++)
         {
-          hashcat_ctx->fd_list[tmp].is_valid = 1;
           tmp_mark += hashcat_ctx->fd_list[tmp - 1].words_cnt;
+          /// our part ended exactly on the previous dict boundary
+          if (tmp_mark >= end_mark)
+          {
+            break;
+          }
+          hashcat_ctx->fd_list[tmp].is_valid = 1;
           if (tmp_mark + hashcat_ctx->fd_list[tmp].words_cnt > end_mark)
           {
             hashcat_ctx->fd_list[tmp].words_end = end_mark - tmp_mark - 1;
@@ -140,198 +169,2035 @@ int straight_divide_workload (hashcat_ctx_t *hashcat_ctx)
     tmp_mark += hashcat_ctx->fd_list[pos].words_cnt;
   }
 
-  /// fix the last part
-  if (hashcat_ctx->cur_proc_id + 1 == hashcat_ctx->total_proc_cnt)
+  /// no need to fix the last part, mm_get_slice() lets the last rank end on total_cnts
+
+  for (uint pos = 0; pos < fd_cnt; pos++)
   {
-    status_ctx->words_cnt += hashcat_ctx->fd_list[straight_ctx->dicts_cnt - 1].words_cnt - hashcat_ctx->fd_list[straight_ctx->dicts_cnt - 1].words_end - 1;
-    hashcat_ctx->fd_list[straight_ctx->dicts_cnt - 1].words_end = hashcat_ctx->fd_list[straight_ctx->dicts_cnt - 1].words_cnt - 1;
+    mm_range_end (hashcat_ctx, hashcat_ctx->fd_list + pos);
   }
 
   return 1;
 }
 
-mm_extend_fd_t * create_mm_fd()
+/// count the words of the straight dicts from dicts_first on. a dict is counted once per session, the rule split
+/// and every inner1_loop () of a hybrid attack share the counts
+int mm_fd_list_count (hashcat_ctx_t *hashcat_ctx, const u32 dicts_first)
 {
-  mm_extend_fd_t *mfd = hccalloc(1,sizeof(mm_extend_fd_t));
-  return mfd;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+
+  if (hashcat_ctx->fd_list_cnt != straight_ctx->dicts_cnt) mm_fd_list_destroy (hashcat_ctx);
+
+  if (hashcat_ctx->fd_list == NULL)
+  {
+    hashcat_ctx->fd_list = (mm_extend_fd_t *) hccalloc (straight_ctx->dicts_cnt, sizeof (mm_extend_fd_t));
+
+    hashcat_ctx->fd_list_cnt = straight_ctx->dicts_cnt;
+  }
+
+  for (u32 pos = dicts_first; pos < straight_ctx->dicts_cnt; pos++)
+  {
+    mm_extend_fd_t *mfd = hashcat_ctx->fd_list + pos;
+
+    if (mfd->counted == true) continue;
+
+    if (get_entry_cnt (hashcat_ctx, straight_ctx->dicts[pos], mfd) == -1)
+    {
+      mm_fd_list_destroy (hashcat_ctx);
+
+      return -1;
+    }
+
+    mfd->counted = true;
+  }
+
+  return 0;
 }
 
-void destory_mm_fd(mm_extend_fd_t * mfd)
+/// free hashcat_ctx->fd_list together with the line indexes of its entries
+void mm_fd_list_destroy (hashcat_ctx_t *hashcat_ctx)
 {
-  hcfree(mfd);
+  if (hashcat_ctx->fd_list == NULL) return;
+
+  for (u32 pos = 0; pos < hashcat_ctx->fd_list_cnt; pos++)
+  {
+    release_entry_cnt (hashcat_ctx->fd_list + pos);
+  }
+
+  hcfree (hashcat_ctx->fd_list);
+
+  hashcat_ctx->fd_list     = NULL;
+  hashcat_ctx->fd_list_cnt = 0;
 }
 
-void update_log(hashcat_ctx_t * hashcat_ctx, bool last)
+/// combinator attack: the base side dict is divided among the ranks like a straight dict,
+/// the other side stays the amplifier of every rank
+int combi_divide_workload (hashcat_ctx_t *hashcat_ctx)
 {
-  logfile_ctx_t   *logfile_ctx   = hashcat_ctx->logfile_ctx;
-  user_options_t  *user_options  = hashcat_ctx->user_options;
+  combinator_ctx_t *combinator_ctx = hashcat_ctx->combinator_ctx;
+  straight_ctx_t   *straight_ctx   = hashcat_ctx->straight_ctx;
 
-  time_t nowtime = time (NULL);
-  struct tm *nowt = localtime (&nowtime);
+  char *dict = (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT) ? combinator_ctx->dict1 : combinator_ctx->dict2;
 
-  hc_asprintf (&logfile_ctx->logfile,  "%s/%d-%04d-%02d-%02d-%02d-%02d-%02d",
-            user_options->mm_log_dir, hashcat_ctx->cur_proc_id, nowt->tm_year + 1900, nowt->tm_mon + 1,
-            nowt->tm_mday, nowt->tm_hour, nowt->tm_min, nowt->tm_sec);
+  if (hashcat_ctx->fd_list == NULL)
+  {
+    hashcat_ctx->fd_list = (mm_extend_fd_t *) hccalloc (1, sizeof (mm_extend_fd_t));
 
-  hashcat_status_t *hashcat_status = (hashcat_status_t *) hcmalloc (sizeof (hashcat_status_t));
+    hashcat_ctx->fd_list_cnt = 1;
 
-  const int rc_status = hashcat_get_status (hashcat_ctx, hashcat_status);
+    if (get_entry_cnt (hashcat_ctx, dict, hashcat_ctx->fd_list) == -1)
+    {
+      mm_fd_list_destroy (hashcat_ctx);
 
-  if (rc_status == -1)
+      return -1;
+    }
+  }
+
+  straight_ctx->dict      = dict;
+  straight_ctx->dicts_pos = 0;
+
+  return straight_divide_workload (hashcat_ctx);
+}
+
+/// hybrid attack, called once the mask of the current dict is known.
+/// if the mask has more words than all the dicts together, every rank walks the whole dict with its share of the mask,
+/// otherwise the dict records stay divided as straight_divide_workload() left them.
+/// returns 1 if this rank has nothing to do for the current dict
+int mm_hybrid_split (hashcat_ctx_t *hashcat_ctx)
+{
+  combinator_ctx_t *combinator_ctx = hashcat_ctx->combinator_ctx;
+  straight_ctx_t   *straight_ctx   = hashcat_ctx->straight_ctx;
+
+  mm_extend_fd_t *mfd = hashcat_ctx->fd_list + straight_ctx->dicts_pos;
+
+  combinator_ctx->combs_off = 0;
+
+  u64 words_all = 0;
+
+  for (u32 pos = 0; pos < straight_ctx->dicts_cnt; pos++)
   {
-    hcfree (hashcat_status);
-    return;
+    words_all += hashcat_ctx->fd_list[pos].words_cnt;
   }
 
-  mm_logfile_append(hashcat_ctx, "{\"started\":\"%s ( %s s )\", \"estimated\":\"%s ( %s s )\", \"progress\":\" %lu/%lu (%.02f\%)\",\"speed\":\" %s H/s\",\"hashtype\":\" %s \"",
-                                     hashcat_status->time_started_absolute,
-                                     hashcat_status->time_started_relative,
-                                     hashcat_status->time_estimated_absolute,
-                                     hashcat_status->time_estimated_relative,
-                                     hashcat_status->progress_cur_relative_skip,
-                                     hashcat_status->progress_end_relative_skip,
-                                     hashcat_status->progress_finished_percent,
-                                     hashcat_status->speed_sec_all,
-                                     hashcat_status->hash_type);
+  if ((hashcat_ctx->total_proc_cnt > 1) && (combinator_ctx->combs_cnt > words_all))
+  {
+    u64 start = 0;
+    u64 end   = 0;
 
-  if (hashcat_ctx->cracked[0] == 1)
+    mm_get_slice (hashcat_ctx, combinator_ctx->combs_cnt, &start, &end);
+
+    combinator_ctx->combs_off = start;
+    combinator_ctx->combs_cnt = end - start;
+
+    mfd->words_start = 0;
+    mfd->words_end   = (mfd->words_cnt > 0) ? mfd->words_cnt - 1 : 0;
+    mfd->is_valid    = ((mfd->words_cnt > 0) && (end > start)) ? 1 : -1;
+
+    mm_range_end (hashcat_ctx, mfd);
+  }
+
+  return (mfd->is_valid == -1) ? 1 : 0;
+}
+
+/// [start, end) share of total for this rank, proportional to the exchanged speeds if we have them
+void mm_get_slice (hashcat_ctx_t *hashcat_ctx, const u64 total, u64 *start, u64 *end)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  /// with the rules split too, all ranks of a word group get the same words
+  const int groups = (int) MAX (1, mm_ctx->rule_groups);
+
+  const int id  = hashcat_ctx->cur_proc_id    / groups;
+  const int cnt = hashcat_ctx->total_proc_cnt / groups;
+
+  double speed_all = 0;
+  double speed_pre = 0;
+
+  if (mm_ctx->speeds != NULL)
   {
-    /// cracked by me
-    if ( NULL == hashcat_ctx->mm_crack_buf)
-    {
-      /// something must be wrong
-      mm_logfile_append(hashcat_ctx, ",\"status:\":\"wrong\"}\n");
-    }
-    else
+    for (int i = 0; i < cnt; i++)
     {
-      /// crack by me
-      char * mm_p = strchr(hashcat_ctx->mm_crack_buf, ':');
-      *mm_p =0;
-      mm_logfile_append(hashcat_ctx, ",\"status:\":\"cracked\",\"result\":\"%s\"} \n", mm_p + 1);
-      *mm_p =':';
-      hashcat_ctx->crack_log_done = true;
+      if (i < id) speed_pre += mm_ctx->speeds[i];
+
+      speed_all += mm_ctx->speeds[i];
     }
   }
-  else if(last)
+
+  if (speed_all > 0)
   {
-    mm_logfile_append(hashcat_ctx, ",\"status:\":\"finished\"}\n");
+    /// every rank evaluates the same expression for the shared boundary, so the slices do not overlap
+    const double speed_own = mm_ctx->speeds[id];
+
+    *start = (id == 0)       ? 0     : MIN (total, (u64) ((long double) total * speed_pre / speed_all));
+    *end   = (id + 1 == cnt) ? total : MIN (total, (u64) ((long double) total * (speed_pre + speed_own) / speed_all));
   }
   else
   {
-    mm_logfile_append(hashcat_ctx, ",\"status:\":\"running\"}\n");
+    *start = (id * total) / cnt;
+    *end   = ((id + 1) * total) / cnt;
   }
 
-  hcfree (hashcat_status);
+  if (*end < *start) *end = *start;
 }
 
-void create_err_log(hashcat_ctx_t * hashcat_ctx, const char * host, const char * err_msg)
+/// join the speed exchange with our own speed, at most once per rank
+static int mm_speed_post (hashcat_ctx_t *hashcat_ctx, double speed)
 {
-  logfile_ctx_t   *logfile_ctx   = hashcat_ctx->logfile_ctx;
-  user_options_t  *user_options  = hashcat_ctx->user_options;
-
-  time_t nowtime = time (NULL);
-  struct tm *nowt = localtime (&nowtime);
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
 
-  hc_asprintf (&logfile_ctx->logfile,  "%s/%d-%04d-%02d-%02d-%02d-%02d-%02d",
-            user_options->mm_log_dir, hashcat_ctx->cur_proc_id, nowt->tm_year + 1900, nowt->tm_mon + 1,
-            nowt->tm_mday, nowt->tm_hour, nowt->tm_min, nowt->tm_sec);
+  if (mm_ctx->speed_posted == true) return 0;
 
-  bool too_early = false;
+  mm_ctx->speed_posted = true;
 
-  hashcat_status_t *hashcat_status = (hashcat_status_t *) hcmalloc (sizeof (hashcat_status_t));
+  if (mm_ctx->speeds == NULL)
+  {
+    mm_ctx->speeds = (double *) hccalloc (hashcat_ctx->total_proc_cnt, sizeof (double));
+  }
 
-  const int rc_status = hashcat_get_status (hashcat_ctx, hashcat_status);
+  #if defined (ENABLE_MPI)
+  /// the send buffer has to stay valid until the request completes
+  mm_ctx->speed_own = speed;
 
-  if (rc_status == -1)
+  if (MPI_Iallgather (&mm_ctx->speed_own, 1, MPI_DOUBLE, mm_ctx->speeds, 1, MPI_DOUBLE, mm_ctx->speed_comm, &mm_ctx->speed_req) != MPI_SUCCESS)
   {
-    hcfree (hashcat_status);
-    too_early = true;
-  }
+    event_log_error (hashcat_ctx, "MPI_Iallgather failed for the speed exchange.");
 
-  u64 progress_cur =  too_early? 0: hashcat_status->progress_cur_relative_skip;
-  u64 progress_end =  too_early? 0: hashcat_status->progress_end_relative_skip;
-  double progress_fininshed = too_early? 0 :hashcat_status->progress_finished_percent;
+    return -1;
+  }
+  #else
+  mm_ctx->speeds[0] = speed;
+  #endif
 
-  mm_logfile_append(hashcat_ctx, "{\"started\":\"%s ( %s s )\",\"progress\":\" %lu/%lu (%.02f\%)\", \"status:\":\"error\", \"reason\":\"(%s) %s\"}\n", 
-                    get_time_started_absolute(hashcat_ctx), get_time_started_relative(hashcat_ctx), 
-                    progress_cur, progress_end, progress_fininshed,
-                    host, err_msg);
+  return 0;
 }
 
-void mm_logfile_append (hashcat_ctx_t *hashcat_ctx, const char *fmt, ...)
+/// sum up the autotuned speed of our devices and share it with all ranks, once per run. the exchange is
+/// non-blocking on its own communicator, we give up waiting as soon as the run stops. returns 1 in that case
+int mm_speed_exchange (hashcat_ctx_t *hashcat_ctx)
 {
-  logfile_ctx_t *logfile_ctx = hashcat_ctx->logfile_ctx;
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  opencl_ctx_t *opencl_ctx = hashcat_ctx->opencl_ctx;
 
-  //if (logfile_ctx->enabled == false) return;
+  double speed = 0;
 
-  FILE *fp = fopen (logfile_ctx->logfile, "ab");
+  for (u32 device_id = 0; device_id < opencl_ctx->devices_cnt; device_id++)
+  {
+    hc_device_param_t *device_param = &opencl_ctx->devices_param[device_id];
 
-  if (fp == NULL)
+    if (device_param->skipped == true) continue;
+
+    speed += device_param->autotune_speed;
+  }
+
+  if (mm_speed_post (hashcat_ctx, speed) == -1) return -1;
+
+  #if defined (ENABLE_MPI)
+  const status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  int done = 0;
+
+  while (done == 0)
   {
-    //event_log_error (hashcat_ctx, "%s: %s", logfile_ctx->logfile, strerror (errno));
+    MPI_Test (&mm_ctx->speed_req, &done, MPI_STATUS_IGNORE);
 
-    return;
+    if (done == 1) break;
+
+    /// a rank that cracked everything or failed joins only from mm_speed_finish ()
+    if (status_ctx->run_thread_level1 == false) return 1;
+
+    hc_sleep_msec (1);
   }
+  #endif
 
-  lock_file (fp);
+  mm_ctx->speed_pending = false;
 
-  va_list ap;
+  return 0;
+}
 
-  va_start (ap, fmt);
+/// end of the session, join the exchange if we never got to it, so the ranks still waiting in it can go on
+void mm_speed_finish (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
 
-  vfprintf (fp, fmt, ap);
+  #if defined (ENABLE_MPI)
+  if (mm_ctx->speed_comm == MPI_COMM_NULL) return;
 
-  va_end (ap);
+  mm_speed_post (hashcat_ctx, 0);
 
-  //fwrite (EOL, strlen (EOL), 1, fp);
+  MPI_Wait (&mm_ctx->speed_req, MPI_STATUS_IGNORE);
 
-  fflush (fp);
+  MPI_Comm_free (&mm_ctx->speed_comm);
+  #endif
 
-  fclose (fp);
+  mm_ctx->speed_pending = false;
 }
 
-char * get_time_started_absolute (const hashcat_ctx_t *hashcat_ctx)
+/// re-slice the current epoch by speed, called from inner2_loop right after autotune.
+/// returns 1 if the current dict ended up with another rank
+int mm_speed_split (hashcat_ctx_t *hashcat_ctx)
 {
-  const time_t time_start = hashcat_ctx->runtime_start;
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
 
-  char buf[32] = { 0 };
+  const u64 amplifier_cnt = user_options_extra_amplifier (hashcat_ctx);
 
-  char *start = ctime_r (&time_start, buf);
+  if (user_options->attack_mode == ATTACK_MODE_BF)
+  {
+    /// every rank runs every mask, the speeds of the first one are used for all of them
+    if (mm_ctx->speed_pending == true)
+    {
+      const int rc_exchange = mm_speed_exchange (hashcat_ctx);
 
-  const size_t start_len = strlen (start);
+      if (rc_exchange != 0) return rc_exchange;
+    }
 
-  if (start[start_len - 1] == '\n') start[start_len - 1] = 0;
-  if (start[start_len - 2] == '\r') start[start_len - 2] = 0;
+    u64 words_off  = 0;
+    u64 words_base = 0;
 
-  return strdup (start);
+    mm_get_slice (hashcat_ctx, status_ctx->words_base, &words_off, &words_base);
+
+    status_ctx->words_off     = words_off;
+    status_ctx->words_cur     = words_off;
+    status_ctx->words_base    = words_base;
+    status_ctx->words_off_ori = words_off;
+    status_ctx->words_cnt     = (words_base - words_off) * amplifier_cnt;
+
+    for (u32 i = 0; i < hashes->salts_cnt; i++)
+    {
+      status_ctx->words_progress_restored[i] = words_off * amplifier_cnt;
+    }
+
+    return 0;
+  }
+
+  /// straight mode, dicts are divided once, ranks skip different dicts afterwards
+  if (mm_ctx->speed_pending == false) return 0;
+
+  const int rc_exchange = mm_speed_exchange (hashcat_ctx);
+
+  if (rc_exchange != 0) return rc_exchange;
+
+  straight_divide_workload (hashcat_ctx);
+
+  mm_extend_fd_t *mfd = hashcat_ctx->fd_list + straight_ctx->dicts_pos;
+
+  if (mfd->is_valid == -1) return 1;
+
+  status_ctx->words_base = mfd->words_end - mfd->words_start + 1;
+  status_ctx->words_cnt  = status_ctx->words_base * amplifier_cnt;
+
+  return 0;
 }
 
-char * get_time_started_relative (const hashcat_ctx_t *hashcat_ctx)
+/// straight mode with rules: if the share of the dicts every rank gets would not even fill one batch of the devices,
+/// split the rules as well. the ranks form rule_groups x (total_proc_cnt / rule_groups) tiles of rules x words.
+/// kernel_rules_buf stays whole (it may be shared on the node), we only run [kernel_rules_off, + kernel_rules_cnt).
+/// collective over all ranks, call after opencl_session_begin () and mm_ckpt_init ()
+int mm_rules_split (hashcat_ctx_t *hashcat_ctx)
 {
-  time_t time_now;
-  time (&time_now);
+  mm_ctx_t             *mm_ctx             = hashcat_ctx->mm_ctx;
+  opencl_ctx_t         *opencl_ctx         = hashcat_ctx->opencl_ctx;
+  restore_ctx_t        *restore_ctx        = hashcat_ctx->restore_ctx;
+  straight_ctx_t       *straight_ctx       = hashcat_ctx->straight_ctx;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
 
-  const time_t time_start = hashcat_ctx->runtime_start;
+  mm_ctx->rule_groups = 1;
 
-  #if defined (_WIN)
-  __time64_t sec_run = time_now - time_start;
-  #else
-  time_t sec_run = time_now - time_start;
-  #endif
+  straight_ctx->kernel_rules_off = 0;
 
-  struct tm *tmp;
+  if (hashcat_ctx->total_proc_cnt == 1) return 0;
 
-  #if defined (_WIN)
-  tmp = _gmtime64 (&sec_run);
-  #else
-  struct tm tm;
+  if (user_options->attack_mode != ATTACK_MODE_STRAIGHT) return 0;
+  if (user_options_extra->wordlist_mode != WL_MODE_FILE) return 0;
+  if (user_options->keyspace    == true) return 0;
+  if (user_options->stdout_flag == true) return 0;
+  if (straight_ctx->kernel_rules_cnt < 2) return 0;
 
-  tmp = gmtime_r (&sec_run, &tm);
-  #endif
+  /// the dispenser, the speed split and the cluster checkpoint count words only
+  if ((mm_ctx->dynamic == true) || (mm_ctx->speed_split == true) || (mm_ctx->ckpt == true)) return 0;
 
-  char *display_run = (char *) malloc (HCBUFSIZ_TINY);
+  /// the dicts a restored session still has to walk, inner1_loop () starts there as well and reuses the counts.
+  /// a dict that cannot be counted leaves words_all at 0, inner1_loop () reports it
+  const u32 dicts_first = (restore_ctx->rd != NULL) ? restore_ctx->rd->dicts_pos : straight_ctx->dicts_pos;
 
-  snprintf(display_run, HCBUFSIZ_TINY-1, " %lu ", sec_run);
+  u64 words_all = 0;
 
-  return display_run;
+  if (mm_fd_list_count (hashcat_ctx, dicts_first) == 0)
+  {
+    for (u32 pos = dicts_first; pos < straight_ctx->dicts_cnt; pos++)
+    {
+      words_all += hashcat_ctx->fd_list[pos].words_cnt;
+    }
+  }
+
+  /// words of one batch on all our devices, the rank with the largest batch decides
+  u64 batch = 0;
+
+  for (u32 device_id = 0; device_id < opencl_ctx->devices_cnt; device_id++)
+  {
+    hc_device_param_t *device_param = &opencl_ctx->devices_param[device_id];
+
+    if (device_param->skipped == true) continue;
+
+    batch += (u64) device_param->hardware_power * device_param->kernel_accel_max;
+  }
+
+  #if defined (ENABLE_MPI)
+  u64 batch_max = 0;
+
+  if (MPI_Allreduce (&batch, &batch_max, 1, MPI_UINT64_T, MPI_MAX, mm_ctx->comm) != MPI_SUCCESS)
+  {
+    event_log_error (hashcat_ctx, "MPI_Allreduce failed for the rule split.");
+
+    return -1;
+  }
+
+  batch = batch_max;
+  #endif
+
+  /// as many word groups as still get a full batch each, the rest of the ranks goes to the rules
+  const u32 cnt = (u32) hashcat_ctx->total_proc_cnt;
+
+  u32 word_groups = cnt;
+
+  for (u32 groups = cnt; groups > 0; groups--)
+  {
+    if ((cnt % groups) != 0) continue;
+
+    if ((cnt / groups) > straight_ctx->kernel_rules_cnt) break;
+
+    word_groups = groups;
+
+    if ((words_all / groups) >= batch) break;
+  }
+
+  if (word_groups == cnt) return 0;
+
+  mm_ctx->rule_groups = cnt / word_groups;
+
+  const u64 group = (u64) hashcat_ctx->cur_proc_id % mm_ctx->rule_groups;
+
+  const u32 rules_off = (u32) ((group       * straight_ctx->kernel_rules_cnt) / mm_ctx->rule_groups);
+  const u32 rules_end = (u32) (((group + 1) * straight_ctx->kernel_rules_cnt) / mm_ctx->rule_groups);
+
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    event_log_info (hashcat_ctx, "Splitting %u rules into %u groups, the dicts into %u.", straight_ctx->kernel_rules_cnt, mm_ctx->rule_groups, word_groups);
+  }
+
+  straight_ctx->kernel_rules_off = rules_off;
+  straight_ctx->kernel_rules_cnt = rules_end - rules_off;
+
+  return 0;
+}
+
+/// -a 3 with a mask file or --increment: instead of splitting every mask among all ranks, lay the keyspaces of all masks
+/// end to end and give every rank one contiguous range of that. a rank sets up and autotunes only the masks it owns.
+/// every rank computes the same plan on its own, call after mm_work_init () and mm_ckpt_init ()
+int mm_mask_plan (hashcat_ctx_t *hashcat_ctx)
+{
+  mask_ctx_t     *mask_ctx     = hashcat_ctx->mask_ctx;
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  hcfree (mm_ctx->mask_plan);
+
+  mm_ctx->mask_plan  = NULL;
+  mm_ctx->plan_start = 0;
+  mm_ctx->plan_end   = 0;
+
+  if (hashcat_ctx->total_proc_cnt == 1) return 0;
+
+  if (user_options->attack_mode != ATTACK_MODE_BF) return 0;
+  if (user_options->benchmark   == true) return 0;
+  if (user_options->keyspace    == true) return 0;
+  if (user_options->stdout_flag == true) return 0;
+  if (mask_ctx->masks_cnt < 2) return 0;
+
+  /// the dispenser, the speed split and the cluster checkpoint work per mask
+  if ((mm_ctx->dynamic == true) || (mm_ctx->speed_split == true) || (mm_ctx->ckpt == true)) return 0;
+
+  u64 *offs = (u64 *) hccalloc (mask_ctx->masks_cnt + 1, sizeof (u64));
+
+  const u32 masks_pos = mask_ctx->masks_pos;
+
+  for (u32 pos = 0; pos < mask_ctx->masks_cnt; pos++)
+  {
+    u64 cnt = 0;
+
+    if (mask_ctx_keyspace (hashcat_ctx, pos, &cnt) == -1)
+    {
+      hcfree (offs);
+
+      return -1;
+    }
+
+    if (overflow_check_u64_add (offs[pos], cnt) == false)
+    {
+      event_log_error (hashcat_ctx, "Integer overflow detected in the keyspace of all masks.");
+
+      hcfree (offs);
+
+      return -1;
+    }
+
+    offs[pos + 1] = offs[pos] + cnt;
+  }
+
+  mask_ctx->masks_pos = masks_pos;
+  mask_ctx->mask      = mask_ctx->masks[masks_pos];
+
+  mm_get_slice (hashcat_ctx, offs[mask_ctx->masks_cnt], &mm_ctx->plan_start, &mm_ctx->plan_end);
+
+  mm_ctx->mask_plan = offs;
+
+  return 0;
+}
+
+/// false if the plan gave no part of mask masks_pos to us
+bool mm_mask_owned (hashcat_ctx_t *hashcat_ctx, const u32 masks_pos)
+{
+  const mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->mask_plan == NULL) return true;
+
+  const u64 mask_beg = mm_ctx->mask_plan[masks_pos];
+  const u64 mask_end = mm_ctx->mask_plan[masks_pos + 1];
+
+  return (MAX (mask_beg, mm_ctx->plan_start) < MIN (mask_end, mm_ctx->plan_end));
+}
+
+/// our part of the current mask in words_base units. the boundaries are the same expression on both neighbours,
+/// so nothing is run twice or left out even if a boundary falls inside the amplifier of a word
+void mm_mask_slice (hashcat_ctx_t *hashcat_ctx)
+{
+  mask_ctx_t   *mask_ctx   = hashcat_ctx->mask_ctx;
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  const u64 amplifier_cnt = user_options_extra_amplifier (hashcat_ctx);
+
+  const u64 mask_beg = mm_ctx->mask_plan[mask_ctx->masks_pos];
+  const u64 mask_end = mm_ctx->mask_plan[mask_ctx->masks_pos + 1];
+
+  const u64 total = mask_end - mask_beg;
+
+  const u64 beg = MIN (MAX (mm_ctx->plan_start, mask_beg), mask_end) - mask_beg;
+  const u64 end = MIN (MAX (mm_ctx->plan_end,   mask_beg), mask_end) - mask_beg;
+
+  const u64 words_all = status_ctx->words_base;
+
+  u64 words_off = 0;
+  u64 words_fin = 0;
+
+  if (total > 0)
+  {
+    words_off = (beg == total) ? words_all : (u64) ((long double) words_all * beg / total);
+    words_fin = (end == total) ? words_all : (u64) ((long double) words_all * end / total);
+  }
+
+  status_ctx->words_off     = words_off;
+  status_ctx->words_cur     = words_off;
+  status_ctx->words_base    = words_fin;
+  status_ctx->words_off_ori = words_off;
+  status_ctx->words_cnt     = (words_fin - words_off) * amplifier_cnt;
+}
+
+mm_extend_fd_t * create_mm_fd()
+{
+  mm_extend_fd_t *mfd = hccalloc(1,sizeof(mm_extend_fd_t));
+  return mfd;
+}
+
+void destory_mm_fd(mm_extend_fd_t * mfd)
+{
+  hcfree(mfd);
+}
+
+void update_log(hashcat_ctx_t * hashcat_ctx, bool last)
+{
+  logfile_ctx_t   *logfile_ctx   = hashcat_ctx->logfile_ctx;
+  user_options_t  *user_options  = hashcat_ctx->user_options;
+
+  time_t nowtime = time (NULL);
+  struct tm *nowt = localtime (&nowtime);
+
+  hc_asprintf (&logfile_ctx->logfile,  "%s/%d-%04d-%02d-%02d-%02d-%02d-%02d",
+            user_options->mm_log_dir, hashcat_ctx->cur_proc_id, nowt->tm_year + 1900, nowt->tm_mon + 1,
+            nowt->tm_mday, nowt->tm_hour, nowt->tm_min, nowt->tm_sec);
+
+  hashcat_status_t *hashcat_status = (hashcat_status_t *) hcmalloc (sizeof (hashcat_status_t));
+
+  const int rc_status = hashcat_get_status (hashcat_ctx, hashcat_status);
+
+  if (rc_status == -1)
+  {
+    hcfree (hashcat_status);
+    return;
+  }
+
+  mm_logfile_append(hashcat_ctx, "{\"started\":\"%s ( %s s )\", \"estimated\":\"%s ( %s s )\", \"progress\":\" %lu/%lu (%.02f\%)\",\"speed\":\" %s H/s\",\"hashtype\":\" %s \"",
+                                     hashcat_status->time_started_absolute,
+                                     hashcat_status->time_started_relative,
+                                     hashcat_status->time_estimated_absolute,
+                                     hashcat_status->time_estimated_relative,
+                                     hashcat_status->progress_cur_relative_skip,
+                                     hashcat_status->progress_end_relative_skip,
+                                     hashcat_status->progress_finished_percent,
+                                     hashcat_status->speed_sec_all,
+                                     hashcat_status->hash_type);
+
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  /// all digests this rank knows as cracked, and the ones it cracked itself since the last log
+  if (mm_ctx->multi_target == true)
+  {
+    mm_logfile_append(hashcat_ctx, ",\"recovered\":\"%d/%d\",\"results\":[", hashcat_status->digests_done, hashcat_status->digests_cnt);
+
+    for (u32 i = mm_ctx->cracks_logged; i < mm_ctx->cracks_cnt; i++)
+    {
+      mm_logfile_append(hashcat_ctx, "%s\"%s\"", (i == mm_ctx->cracks_logged) ? "" : ",", mm_ctx->cracks[i]);
+    }
+
+    mm_logfile_append(hashcat_ctx, "]");
+
+    mm_ctx->cracks_logged = mm_ctx->cracks_cnt;
+  }
+
+  if (hashcat_ctx->cracked[0] == 1)
+  {
+    if ( NULL == hashcat_ctx->mm_crack_buf)
+    {
+      /// nothing cracked here, the other ranks cracked all there was
+      mm_logfile_append(hashcat_ctx, ",\"status:\":\"cracked\",\"cracked_by\":\"remote\"}\n");
+      hashcat_ctx->crack_log_done = true;
+    }
+    else
+    {
+      /// crack by me
+      char * mm_p = strchr(hashcat_ctx->mm_crack_buf, ':');
+      *mm_p =0;
+      mm_logfile_append(hashcat_ctx, ",\"status:\":\"cracked\",\"result\":\"%s\"} \n", mm_p + 1);
+      *mm_p =':';
+      hashcat_ctx->crack_log_done = true;
+    }
+  }
+  else if(last)
+  {
+    mm_logfile_append(hashcat_ctx, ",\"status:\":\"finished\"}\n");
+  }
+  else
+  {
+    mm_logfile_append(hashcat_ctx, ",\"status:\":\"running\"}\n");
+  }
+
+  hcfree (hashcat_status);
+}
+
+void create_err_log(hashcat_ctx_t * hashcat_ctx, const char * host, const char * err_msg)
+{
+  logfile_ctx_t   *logfile_ctx   = hashcat_ctx->logfile_ctx;
+  user_options_t  *user_options  = hashcat_ctx->user_options;
+
+  time_t nowtime = time (NULL);
+  struct tm *nowt = localtime (&nowtime);
+
+  hc_asprintf (&logfile_ctx->logfile,  "%s/%d-%04d-%02d-%02d-%02d-%02d-%02d",
+            user_options->mm_log_dir, hashcat_ctx->cur_proc_id, nowt->tm_year + 1900, nowt->tm_mon + 1,
+            nowt->tm_mday, nowt->tm_hour, nowt->tm_min, nowt->tm_sec);
+
+  bool too_early = false;
+
+  hashcat_status_t *hashcat_status = (hashcat_status_t *) hcmalloc (sizeof (hashcat_status_t));
+
+  const int rc_status = hashcat_get_status (hashcat_ctx, hashcat_status);
+
+  if (rc_status == -1)
+  {
+    hcfree (hashcat_status);
+    too_early = true;
+  }
+
+  u64 progress_cur =  too_early? 0: hashcat_status->progress_cur_relative_skip;
+  u64 progress_end =  too_early? 0: hashcat_status->progress_end_relative_skip;
+  double progress_fininshed = too_early? 0 :hashcat_status->progress_finished_percent;
+
+  mm_logfile_append(hashcat_ctx, "{\"started\":\"%s ( %s s )\",\"progress\":\" %lu/%lu (%.02f\%)\", \"status:\":\"error\", \"reason\":\"(%s) %s\"}\n", 
+                    get_time_started_absolute(hashcat_ctx), get_time_started_relative(hashcat_ctx), 
+                    progress_cur, progress_end, progress_fininshed,
+                    host, err_msg);
+}
+
+void mm_logfile_append (hashcat_ctx_t *hashcat_ctx, const char *fmt, ...)
+{
+  logfile_ctx_t *logfile_ctx = hashcat_ctx->logfile_ctx;
+
+  //if (logfile_ctx->enabled == false) return;
+
+  FILE *fp = fopen (logfile_ctx->logfile, "ab");
+
+  if (fp == NULL)
+  {
+    //event_log_error (hashcat_ctx, "%s: %s", logfile_ctx->logfile, strerror (errno));
+
+    return;
+  }
+
+  lock_file (fp);
+
+  va_list ap;
+
+  va_start (ap, fmt);
+
+  vfprintf (fp, fmt, ap);
+
+  va_end (ap);
+
+  //fwrite (EOL, strlen (EOL), 1, fp);
+
+  fflush (fp);
+
+  fclose (fp);
+}
+
+char * get_time_started_absolute (const hashcat_ctx_t *hashcat_ctx)
+{
+  const time_t time_start = hashcat_ctx->runtime_start;
+
+  char buf[32] = { 0 };
+
+  char *start = ctime_r (&time_start, buf);
+
+  const size_t start_len = strlen (start);
+
+  if (start[start_len - 1] == '\n') start[start_len - 1] = 0;
+  if (start[start_len - 2] == '\r') start[start_len - 2] = 0;
+
+  return strdup (start);
+}
+
+char * get_time_started_relative (const hashcat_ctx_t *hashcat_ctx)
+{
+  time_t time_now;
+  time (&time_now);
+
+  const time_t time_start = hashcat_ctx->runtime_start;
+
+  #if defined (_WIN)
+  __time64_t sec_run = time_now - time_start;
+  #else
+  time_t sec_run = time_now - time_start;
+  #endif
+
+  struct tm *tmp;
+
+  #if defined (_WIN)
+  tmp = _gmtime64 (&sec_run);
+  #else
+  struct tm tm;
+
+  tmp = gmtime_r (&sec_run, &tm);
+  #endif
+
+  char *display_run = (char *) malloc (HCBUFSIZ_TINY);
+
+  snprintf(display_run, HCBUFSIZ_TINY-1, " %lu ", sec_run);
+
+  return display_run;
+}
+
+/// find the ranks sharing a host with us, once per run. collective over all ranks
+static int mm_topology_init (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->topology == true) return 0;
+
+  #if defined (ENABLE_MPI)
+  if (MPI_Comm_split_type (mm_ctx->comm, MPI_COMM_TYPE_SHARED, hashcat_ctx->cur_proc_id, MPI_INFO_NULL, &mm_ctx->node_comm) != MPI_SUCCESS)
+  {
+    event_log_error (hashcat_ctx, "MPI_Comm_split_type failed for the node topology.");
+
+    return -1;
+  }
+
+  MPI_Comm_size (mm_ctx->node_comm, &mm_ctx->node_size);
+
+  int leader = hashcat_ctx->cur_proc_id;
+
+  MPI_Allreduce (&hashcat_ctx->cur_proc_id, &leader, 1, MPI_INT, MPI_MIN, mm_ctx->node_comm);
+
+  mm_ctx->leader_of = (int *) hccalloc (hashcat_ctx->total_proc_cnt, sizeof (int));
+
+  MPI_Allgather (&leader, 1, MPI_INT, mm_ctx->leader_of, 1, MPI_INT, mm_ctx->comm);
+  #else
+  mm_ctx->node_size = 1;
+
+  mm_ctx->leader_of = (int *) hccalloc (1, sizeof (int));
+  #endif
+
+  mm_ctx->topology = true;
+
+  return 0;
+}
+
+/// without --mm-node-topology every rank is a node of its own
+int mm_leader_of (const hashcat_ctx_t *hashcat_ctx, const int rank)
+{
+  const mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  return (mm_ctx->topology == true) ? mm_ctx->leader_of[rank] : rank;
+}
+
+/// point the hash_t at the packed buffers the way hashes_init_stage2 () does
+static void mm_hashes_link (hashcat_ctx_t *hashcat_ctx)
+{
+  hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+  hashes_t     *hashes     = hashcat_ctx->hashes;
+
+  for (u32 salts_pos = 0; salts_pos < hashes->salts_cnt; salts_pos++)
+  {
+    salt_t *salt_buf = &hashes->salts_buf[salts_pos];
+
+    for (u32 digests_pos = 0; digests_pos < salt_buf->digests_cnt; digests_pos++)
+    {
+      const u32 hashes_pos = salt_buf->digests_offset + digests_pos;
+
+      hash_t *hash = &hashes->hashes_buf[hashes_pos];
+
+      hash->digest = ((char *) hashes->digests_buf) + ((u64) hashes_pos * hashconfig->dgst_size);
+      hash->salt   = salt_buf;
+
+      if (hashconfig->esalt_size)     hash->esalt     = ((char *) hashes->esalts_buf)     + ((u64) hashes_pos * hashconfig->esalt_size);
+      if (hashconfig->hook_salt_size) hash->hook_salt = ((char *) hashes->hook_salts_buf) + ((u64) salts_pos  * hashconfig->hook_salt_size);
+    }
+  }
+}
+
+#if defined (ENABLE_MPI)
+/// FNV-1a, continues h over buf
+static u64 mm_buf_hash_more (u64 h, const void *buf, const u64 size)
+{
+  const u8 *ptr = (const u8 *) buf;
+
+  for (u64 i = 0; i < size; i++)
+  {
+    h ^= ptr[i];
+    h *= 0x100000001b3;
+  }
+
+  return h;
+}
+
+/// FNV-1a, tells apart node buffers of the same size
+static u64 mm_buf_hash (const void *buf, const u64 size)
+{
+  return mm_buf_hash_more (0xcbf29ce484222325, buf, size);
+}
+
+/// fingerprint of the loaded hash list: the digests and what makes up each salt.
+/// the cracked counts are left out, they change while we run
+static u64 mm_hashes_hash (hashcat_ctx_t *hashcat_ctx)
+{
+  hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+  hashes_t     *hashes     = hashcat_ctx->hashes;
+
+  u64 h = mm_buf_hash (hashes->digests_buf, (u64) hashes->digests_cnt * hashconfig->dgst_size);
+
+  for (u32 salt_pos = 0; salt_pos < hashes->salts_cnt; salt_pos++)
+  {
+    const salt_t *salt = hashes->salts_buf + salt_pos;
+
+    h = mm_buf_hash_more (h, salt->salt_buf,        sizeof (salt->salt_buf));
+    h = mm_buf_hash_more (h, &salt->salt_len,       sizeof (salt->salt_len));
+    h = mm_buf_hash_more (h, &salt->salt_iter,      sizeof (salt->salt_iter));
+    h = mm_buf_hash_more (h, &salt->digests_cnt,    sizeof (salt->digests_cnt));
+    h = mm_buf_hash_more (h, &salt->digests_offset, sizeof (salt->digests_offset));
+  }
+
+  return h;
+}
+
+/// replace the read-only host buffer *owner by one copy in memory shared by all ranks of the node. nothing changes
+/// if the ranks of the node do not hold the very same bytes. collective over the node
+static void mm_node_share (hashcat_ctx_t *hashcat_ctx, void **owner, const u64 size)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->node_shares_cnt == MM_NODE_SHARES_MAX) return;
+
+  const bool have = (*owner != NULL) && (size > 0);
+
+  u64 mine[3] = { have, size, (have == true) ? mm_buf_hash (*owner, size) : 0 };
+
+  u64 mins[3] = { 0 };
+  u64 maxs[3] = { 0 };
+
+  MPI_Allreduce (mine, mins, 3, MPI_UINT64_T, MPI_MIN, mm_ctx->node_comm);
+  MPI_Allreduce (mine, maxs, 3, MPI_UINT64_T, MPI_MAX, mm_ctx->node_comm);
+
+  if ((mins[0] == 0) || (mins[1] != maxs[1]) || (mins[2] != maxs[2])) return;
+
+  const bool leader = (mm_leader_of (hashcat_ctx, hashcat_ctx->cur_proc_id) == hashcat_ctx->cur_proc_id);
+
+  MPI_Win win;
+
+  void *base = NULL;
+
+  if (MPI_Win_allocate_shared ((leader == true) ? (MPI_Aint) size : 0, 1, MPI_INFO_NULL, mm_ctx->node_comm, &base, &win) != MPI_SUCCESS) return;
+
+  if (leader == false)
+  {
+    MPI_Aint win_size  = 0;
+    int      disp_unit = 0;
+
+    MPI_Win_shared_query (win, MPI_PROC_NULL, &win_size, &disp_unit, &base);
+  }
+
+  MPI_Win_lock_all (MPI_MODE_NOCHECK, win);
+
+  if (leader == true) memcpy (base, *owner, size);
+
+  MPI_Win_sync (win);
+
+  MPI_Barrier (mm_ctx->node_comm);
+
+  MPI_Win_sync (win);
+
+  hcfree (*owner);
+
+  *owner = base;
+
+  mm_ctx->node_owners[mm_ctx->node_shares_cnt] = owner;
+  mm_ctx->node_wins[mm_ctx->node_shares_cnt]   = win;
+
+  mm_ctx->node_shares_cnt++;
+}
+
+/// the hash list, the bitmaps and the rules are only read once the attack runs, one copy per node is enough
+static void mm_node_share_all (hashcat_ctx_t *hashcat_ctx)
+{
+  bitmap_ctx_t   *bitmap_ctx   = hashcat_ctx->bitmap_ctx;
+  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+
+  void *digests_buf = hashes->digests_buf;
+
+  mm_node_share (hashcat_ctx, (void **) &hashes->digests_buf, (u64) hashes->digests_cnt * hashconfig->dgst_size);
+
+  /// the private copy is gone, every hash_t has to point into the shared one
+  if (hashes->digests_buf != digests_buf) mm_hashes_link (hashcat_ctx);
+
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s1_a, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s1_b, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s1_c, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s1_d, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s2_a, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s2_b, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s2_c, bitmap_ctx->bitmap_size);
+  mm_node_share (hashcat_ctx, (void **) &bitmap_ctx->bitmap_s2_d, bitmap_ctx->bitmap_size);
+
+  mm_node_share (hashcat_ctx, (void **) &straight_ctx->kernel_rules_buf, (u64) straight_ctx->kernel_rules_cnt * sizeof (kernel_rule_t));
+}
+#endif
+
+/// hand the shared node copies back before the destroy functions hcfree () them. collective over the node
+void mm_node_release (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  for (u32 i = 0; i < mm_ctx->node_shares_cnt; i++)
+  {
+    *mm_ctx->node_owners[i] = NULL;
+
+    #if defined (ENABLE_MPI)
+    MPI_Win_unlock_all (mm_ctx->node_wins[i]);
+
+    MPI_Win_free (&mm_ctx->node_wins[i]);
+    #endif
+  }
+
+  mm_ctx->node_shares_cnt = 0;
+}
+
+/// pick the load balancing mode and check if cracks can be shared. for the dynamic work dispenser set up the shared chunk counters,
+/// one per (mask, dict) epoch. collective over all ranks, the counters live in a window exposed by rank 0
+int mm_work_init (hashcat_ctx_t *hashcat_ctx)
+{
+  mask_ctx_t     *mask_ctx     = hashcat_ctx->mask_ctx;
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  straight_ctx_t *straight_ctx = hashcat_ctx->straight_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  mm_ctx->dynamic       = false;
+  mm_ctx->counters      = NULL;
+  mm_ctx->speed_split   = false;
+  mm_ctx->speed_pending = false;
+  mm_ctx->multi_target  = false;
+  mm_ctx->epochs_cnt    = MAX (1, mask_ctx->masks_cnt) * MAX (1, straight_ctx->dicts_cnt);
+
+  if (user_options->mm_node_topology == true)
+  {
+    if (mm_topology_init (hashcat_ctx) == -1) return -1;
+
+    #if defined (ENABLE_MPI)
+    mm_node_share_all (hashcat_ctx);
+    #endif
+  }
+
+  if (user_options->mm_multi_target == true)
+  {
+    #if defined (ENABLE_MPI)
+    /// cracks are shared by position, which only works if every rank loaded the very same hash list.
+    /// same counts are not enough, two lists of the same size may hold other hashes
+    hashes_t *hashes = hashcat_ctx->hashes;
+
+    u64 keys[3] = { hashes->digests_cnt, hashes->salts_cnt, mm_hashes_hash (hashcat_ctx) };
+
+    u64 keys_min[3] = { 0 };
+    u64 keys_max[3] = { 0 };
+
+    MPI_Allreduce (keys, keys_min, 3, MPI_UINT64_T, MPI_MIN, mm_ctx->comm);
+    MPI_Allreduce (keys, keys_max, 3, MPI_UINT64_T, MPI_MAX, mm_ctx->comm);
+
+    if ((keys_min[0] != keys_max[0]) || (keys_min[1] != keys_max[1]) || (keys_min[2] != keys_max[2]))
+    {
+      event_log_warning (hashcat_ctx, "Hash lists differ between ranks (different potfiles?), cracks will not be shared.");
+    }
+    else
+    {
+      mm_ctx->multi_target = true;
+    }
+    #else
+    mm_ctx->multi_target = true;
+    #endif
+  }
+
+  /// --mm-degraded shrinks comm while the speed exchange runs on a duplicate of the full one
+  const bool speed_split = (user_options->mm_speed_split == true) && (user_options->mm_degraded == false);
+
+  if ((user_options->mm_speed_split == true) && (speed_split == false) && (user_options->mm_dynamic == false))
+  {
+    event_log_warning (hashcat_ctx, "--mm-speed-split does not work with --mm-degraded, falling back to static partitioning.");
+  }
+
+  if ((user_options->mm_dynamic == false) && (speed_split == false)) return 0;
+
+  if (user_options->keyspace == true) return 0;
+
+  if ((user_options->attack_mode != ATTACK_MODE_STRAIGHT) && (user_options->attack_mode != ATTACK_MODE_BF)) return 0;
+
+  #if defined (ENABLE_MPI)
+  /// device threads claim chunks while the monitor thread runs its collectives
+  if (mm_ctx->thread_multiple == false)
+  {
+    event_log_warning (hashcat_ctx, "MPI_THREAD_MULTIPLE not provided by the MPI library, falling back to static partitioning.");
+
+    return 0;
+  }
+  #endif
+
+  /// the dispenser balances by itself, no need to weight anything
+  if (user_options->mm_dynamic == false)
+  {
+    mm_ctx->speed_split   = true;
+    mm_ctx->speed_pending = true;
+
+    #if defined (ENABLE_MPI)
+    if (mm_ctx->speed_comm == MPI_COMM_NULL) MPI_Comm_dup (mm_ctx->comm, &mm_ctx->speed_comm);
+    #endif
+
+    return 0;
+  }
+
+  #if defined (ENABLE_MPI)
+  const MPI_Aint win_size = (hashcat_ctx->cur_proc_id == 0) ? (MPI_Aint) (mm_ctx->epochs_cnt * sizeof (u64)) : 0;
+
+  if (MPI_Win_allocate (win_size, sizeof (u64), MPI_INFO_NULL, mm_ctx->comm, &mm_ctx->counters, &mm_ctx->win) != MPI_SUCCESS)
+  {
+    event_log_error (hashcat_ctx, "MPI_Win_allocate failed for the work dispenser.");
+
+    return -1;
+  }
+
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    MPI_Win_lock (MPI_LOCK_EXCLUSIVE, 0, 0, mm_ctx->win);
+
+    memset (mm_ctx->counters, 0, mm_ctx->epochs_cnt * sizeof (u64));
+
+    MPI_Win_unlock (0, mm_ctx->win);
+  }
+
+  /// nobody claims a chunk before rank 0 cleared the counters
+  MPI_Barrier (mm_ctx->comm);
+  #else
+  mm_ctx->counters = (u64 *) hccalloc (mm_ctx->epochs_cnt, sizeof (u64));
+  #endif
+
+  mm_ctx->dynamic = true;
+
+  return 0;
+}
+
+/// collective as well, every rank has to leave the attack before the window goes away
+void mm_work_destroy (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  hcfree (mm_ctx->mask_plan);
+
+  mm_ctx->mask_plan = NULL;
+
+  if (mm_ctx->dynamic == false) return;
+
+  #if defined (ENABLE_MPI)
+  MPI_Win_free (&mm_ctx->win);
+  #else
+  hcfree (mm_ctx->counters);
+  #endif
+
+  mm_ctx->counters = NULL;
+  mm_ctx->dynamic  = false;
+}
+
+
+/// start handing out chunks of the current epoch, must run after autotune so that kernel_power_all is known
+void mm_work_begin (hashcat_ctx_t *hashcat_ctx, const u32 epoch)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  opencl_ctx_t *opencl_ctx = hashcat_ctx->opencl_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  mm_ctx->epoch       = epoch;
+  mm_ctx->epoch_total = status_ctx->words_base;
+  mm_ctx->drained     = (epoch >= mm_ctx->epochs_cnt) || (mm_ctx->epoch_total == 0);
+  mm_ctx->chunk_min   = MAX (1, opencl_ctx->kernel_power_all);
+  mm_ctx->chunk_size  = mm_ctx->chunk_min;
+  mm_ctx->chunk_words  = 0;
+  mm_ctx->claimed_seen = 0;
+
+  /// nothing is owned until the first chunk is claimed
+  status_ctx->words_off     = 0;
+  status_ctx->words_cur     = 0;
+  status_ctx->words_base    = 0;
+  status_ctx->words_off_ori = 0;
+}
+
+/// claim the next chunk of the current epoch into [words_off, words_base).
+/// called by get_work() under mux_dispatcher, returns the number of words claimed
+u64 mm_work_refill (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t       *mm_ctx       = hashcat_ctx->mm_ctx;
+  status_ctx_t   *status_ctx   = hashcat_ctx->status_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  /// a claim in a resumed epoch may have left more than one range
+  if (mm_ctx->ckpt_queue_pos < mm_ctx->ckpt_queue_cnt) return mm_ckpt_pop (hashcat_ctx);
+
+  if (mm_ctx->drained == true) return 0;
+
+  /// size the chunk so that it keeps this rank busy for about mm_chunk_time seconds
+  if (mm_ctx->chunk_words > 0)
+  {
+    const double msec = hc_timer_get (mm_ctx->chunk_timer);
+
+    if (msec > 0)
+    {
+      const double speed = (double) mm_ctx->chunk_words / msec;
+
+      mm_ctx->chunk_size = (u64) (speed * user_options->mm_chunk_time * 1000);
+    }
+  }
+
+  const u64 total = mm_ctx->epoch_total;
+
+  /// shrink the chunks towards the end of the epoch so that all ranks finish together. the counter as our last
+  /// claim left it is recent enough for that, reading it again would cost a second round trip to rank 0
+  const u64 left = (mm_ctx->claimed_seen < total) ? total - mm_ctx->claimed_seen : 0;
+
+  u64 size  = MIN (mm_ctx->chunk_size, left / (2 * (u64) hashcat_ctx->total_proc_cnt));
+  u64 start = 0;
+
+  size = MAX (size, mm_ctx->chunk_min);
+
+  /// one atomic add, a claim past total is clamped below
+  #if defined (ENABLE_MPI)
+  MPI_Win_lock (MPI_LOCK_SHARED, 0, 0, mm_ctx->win);
+
+  MPI_Fetch_and_op (&size, &start, MPI_UINT64_T, 0, mm_ctx->epoch, MPI_SUM, mm_ctx->win);
+
+  MPI_Win_unlock (0, mm_ctx->win);
+  #else
+  start = mm_ctx->counters[mm_ctx->epoch];
+
+  mm_ctx->counters[mm_ctx->epoch] += size;
+  #endif
+
+  mm_ctx->claimed_seen = start + size;
+
+  if (start >= total)
+  {
+    mm_ctx->drained     = true;
+    mm_ctx->chunk_words = 0;
+
+    return 0;
+  }
+
+  const u64 end = MIN (start + size, total);
+
+  if (end == total) mm_ctx->drained = true;
+
+  mm_ctx->chunk_words = end - start;
+
+  hc_timer_set (&mm_ctx->chunk_timer);
+
+  /// a resumed epoch counts through its unfinished ranges only
+  if (mm_ctx->ckpt_resumed == true)
+  {
+    mm_ckpt_map (hashcat_ctx, start, end);
+
+    return mm_ckpt_pop (hashcat_ctx);
+  }
+
+  status_ctx->words_off  = start;
+  status_ctx->words_base = end;
+
+  mm_ckpt_own (hashcat_ctx, start, end);
+
+  return mm_ctx->chunk_words;
+}
+
+
+/// --mm-shared-reader, called from inner2_loop right before the cracker threads start.
+/// returns true if thread_calc_reader() reads the dict of this epoch for all our devices
+bool mm_reader_begin (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t             *mm_ctx             = hashcat_ctx->mm_ctx;
+  opencl_ctx_t         *opencl_ctx         = hashcat_ctx->opencl_ctx;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+
+  mm_ctx->reader = false;
+
+  /// --mm-pipeline and --mm-pack-pws need the reader to have the next batch ready
+  if ((user_options->mm_shared_reader == false) && (user_options->mm_pipeline == false) && (user_options->mm_pack_pws == false)) return false;
+
+  if (user_options->attack_mode != ATTACK_MODE_STRAIGHT) return false;
+
+  if (user_options_extra->wordlist_mode != WL_MODE_FILE) return false;
+
+  /// the devices leave after their first batch, the reader would fill the ring for nobody
+  if (user_options->speed_only == true) return false;
+
+  u32 devices_cnt = 0;
+  u32 batch       = -1u;
+
+  for (u32 device_id = 0; device_id < opencl_ctx->devices_cnt; device_id++)
+  {
+    hc_device_param_t *device_param = &opencl_ctx->devices_param[device_id];
+
+    if (device_param->skipped == true) continue;
+
+    devices_cnt++;
+
+    batch = MIN (batch, device_param->kernel_power);
+  }
+
+  if (devices_cnt == 0) return false;
+
+  /// two batches per device, one is cracked while the next one gets filled
+  mm_ctx->reader_size  = 2 * devices_cnt;
+  mm_ctx->reader_batch = MAX (1, batch);
+  mm_ctx->reader_ring  = (mm_batch_t *) hccalloc (mm_ctx->reader_size, sizeof (mm_batch_t));
+
+  for (u32 i = 0; i < mm_ctx->reader_size; i++)
+  {
+    mm_ctx->reader_ring[i].pws = (pw_t *) hcmalloc (mm_ctx->reader_batch * sizeof (pw_t));
+  }
+
+  /// --mm-pack-pws: a fixed-width dict bounds the length of what the reader passes on, unless -j makes it longer
+  const mm_extend_fd_t *mfd = hashcat_ctx->fd_list + hashcat_ctx->straight_ctx->dicts_pos;
+
+  mm_ctx->reader_stride = 0;
+
+  if ((user_options->mm_pack_pws == true) && (user_options_extra->rule_len_l == 0) && (mfd->is_valid == 1) && (mfd->word_base > 0))
+  {
+    const u32 pw_len_max = MIN ((u32) mfd->word_base, (u32) sizeof (((pw_t *) NULL)->i));
+
+    mm_ctx->reader_stride = 1 + ((pw_len_max + 3) / 4);
+  }
+
+  mm_ctx->reader_head = 0;
+  mm_ctx->reader_cnt  = 0;
+  mm_ctx->reader_off  = 0;
+  mm_ctx->reader_done  = false;
+  mm_ctx->reader_error = false;
+  mm_ctx->reader_quit  = false;
+
+  hc_thread_mutex_init (mm_ctx->mux_reader);
+
+  mm_ctx->reader = true;
+
+  return true;
+}
+
+/// called once the cracker threads are gone, the reader may still wait for a free slot
+void mm_reader_end (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->reader == false) return;
+
+  hc_thread_mutex_lock (mm_ctx->mux_reader);
+
+  mm_ctx->reader_quit = true;
+
+  hc_thread_mutex_unlock (mm_ctx->mux_reader);
+
+  hc_thread_wait (1, &mm_ctx->reader_thread);
+
+  /// autotune and the other attacks fill pws_buf with pw_t again
+  for (u32 device_id = 0; device_id < hashcat_ctx->opencl_ctx->devices_cnt; device_id++)
+  {
+    hashcat_ctx->opencl_ctx->devices_param[device_id].pws_stride = 0;
+  }
+
+  for (u32 i = 0; i < mm_ctx->reader_size; i++) hcfree (mm_ctx->reader_ring[i].pws);
+
+  hcfree (mm_ctx->reader_ring);
+
+  hc_thread_mutex_delete (mm_ctx->mux_reader);
+
+  mm_ctx->reader_ring = NULL;
+  mm_ctx->reader_size = 0;
+  mm_ctx->reader      = false;
+}
+
+
+#if defined (ENABLE_MPI)
+/// MPI counts are int, large hash lists and plain buffers need more than one round
+void mm_bcast_bytes (hashcat_ctx_t *hashcat_ctx, void *buf, const u64 len)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  const u64 step = 1u << 30;
+
+  for (u64 off = 0; off < len; off += step)
+  {
+    MPI_Bcast ((char *) buf + off, (int) MIN (step, len - off), MPI_BYTE, 0, mm_ctx->comm);
+  }
+}
+
+#endif
+
+/// rank 0 merges the shards an earlier session left over and parses the potfile, the other ranks get the cracked
+/// hashes and their plains from it instead of all reading the same file. collective over all ranks
+int mm_potfile_remove_parse (hashcat_ctx_t *hashcat_ctx)
+{
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    if (potfile_shard_prepare (hashcat_ctx) == -1)
+    {
+      event_log_warning (hashcat_ctx, "Could not merge the potfile shards of the last session.");
+    }
+
+    potfile_remove_parse_file (hashcat_ctx);
+  }
+
+  #if defined (ENABLE_MPI)
+  hashes_t *hashes = hashcat_ctx->hashes;
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  hash_t *hashes_buf = hashes->hashes_buf;
+  u32     hashes_cnt = hashes->hashes_cnt;
+
+  /// { hashes_cnt, plain bytes }, a plain length of -1 means not cracked
+  u64 hdr[2] = { hashes_cnt, 0 };
+
+  int  *pw_lens = NULL;
+  char *pw_bufs = NULL;
+
+  if (hashcat_ctx->cur_proc_id == 0)
+  {
+    pw_lens = (int *) hccalloc (hashes_cnt, sizeof (int));
+
+    for (u32 hashes_idx = 0; hashes_idx < hashes_cnt; hashes_idx++)
+    {
+      pw_lens[hashes_idx] = (hashes_buf[hashes_idx].cracked == 1) ? hashes_buf[hashes_idx].pw_len : -1;
+
+      if (pw_lens[hashes_idx] > 0) hdr[1] += pw_lens[hashes_idx];
+    }
+
+    pw_bufs = (char *) hcmalloc (hdr[1] + 1);
+
+    u64 pw_off = 0;
+
+    for (u32 hashes_idx = 0; hashes_idx < hashes_cnt; hashes_idx++)
+    {
+      if (pw_lens[hashes_idx] <= 0) continue;
+
+      memcpy (pw_bufs + pw_off, hashes_buf[hashes_idx].pw_buf, pw_lens[hashes_idx]);
+
+      pw_off += pw_lens[hashes_idx];
+    }
+  }
+
+  MPI_Bcast (hdr, 2, MPI_UINT64_T, 0, mm_ctx->comm);
+
+  if (hashcat_ctx->cur_proc_id != 0)
+  {
+    pw_lens = (int *) hccalloc (hdr[0], sizeof (int));
+    pw_bufs = (char *) hcmalloc (hdr[1] + 1);
+  }
+
+  mm_bcast_bytes (hashcat_ctx, pw_lens, hdr[0] * sizeof (int));
+  mm_bcast_bytes (hashcat_ctx, pw_bufs, hdr[1]);
+
+  if (hashcat_ctx->cur_proc_id != 0)
+  {
+    if (hdr[0] == hashes_cnt)
+    {
+      u64 pw_off = 0;
+
+      for (u32 hashes_idx = 0; hashes_idx < hashes_cnt; hashes_idx++)
+      {
+        if (pw_lens[hashes_idx] == -1) continue;
+
+        if (hashes_buf[hashes_idx].cracked == 0)
+        {
+          potfile_update_hash (hashcat_ctx, &hashes_buf[hashes_idx], pw_bufs + pw_off, pw_lens[hashes_idx]);
+        }
+
+        pw_off += pw_lens[hashes_idx];
+      }
+    }
+    else
+    {
+      /// hash positions mean nothing on a different list
+      event_log_warning (hashcat_ctx, "Hash list differs from rank 0, reading the potfile locally.");
+
+      potfile_remove_parse_file (hashcat_ctx);
+    }
+  }
+
+  hcfree (pw_lens);
+  hcfree (pw_bufs);
+  #endif
+
+  return 0;
+}
+
+/// --mm-bcast-init only pays off with more than one rank and a real hash list to load
+bool mm_bcast_init_enabled (const hashcat_ctx_t *hashcat_ctx)
+{
+  const user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (user_options->mm_bcast_init == false) return false;
+
+  if (hashcat_ctx->total_proc_cnt < 2) return false;
+
+  if (user_options->benchmark   == true) return false;
+  if (user_options->keyspace    == true) return false;
+  if (user_options->stdout_flag == true) return false;
+  if (user_options->opencl_info == true) return false;
+
+  return true;
+}
+
+/// allocate what hashes_init_stage2 () would have left behind, for hash lists we did not parse ourselves
+static void mm_hashes_alloc (hashcat_ctx_t *hashcat_ctx, const u32 hashes_cnt, const u32 salts_cnt)
+{
+  hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+  hashes_t     *hashes     = hashcat_ctx->hashes;
+
+  hashes->hashes_buf        = (hash_t *) hccalloc (hashes_cnt, sizeof (hash_t));
+  hashes->digests_buf       = hccalloc (hashes_cnt, hashconfig->dgst_size);
+  hashes->digests_shown     = (u32 *) hccalloc (hashes_cnt, sizeof (u32));
+  hashes->digests_shown_tmp = (u32 *) hccalloc (hashes_cnt, sizeof (u32));
+  hashes->salts_buf         = (salt_t *) hccalloc ((hashconfig->is_salted) ? hashes_cnt : 1, sizeof (salt_t));
+  hashes->salts_shown       = (u32 *) hccalloc (hashes_cnt, sizeof (u32));
+
+  if (hashconfig->esalt_size)     hashes->esalts_buf     = hccalloc (hashes_cnt, hashconfig->esalt_size);
+  if (hashconfig->hook_salt_size) hashes->hook_salts_buf = hccalloc (hashes_cnt, hashconfig->hook_salt_size);
+
+  hashes->digests_cnt  = hashes_cnt;
+  hashes->digests_done = 0;
+  hashes->salts_cnt    = salts_cnt;
+  hashes->salts_done   = 0;
+}
+
+#if defined (ENABLE_MPI)
+static void mm_pack (u8 **buf, u64 *len, u64 *avail, const void *src, const u64 src_len)
+{
+  if ((*len + src_len) > *avail)
+  {
+    const u64 add_len = MAX (src_len, (u64) HCBUFSIZ_LARGE);
+
+    *buf = (u8 *) hcrealloc (*buf, *avail, add_len);
+
+    *avail += add_len;
+  }
+
+  memcpy (*buf + *len, src, src_len);
+
+  *len += src_len;
+}
+
+static const u8 *mm_unpack (const u8 *buf, void *dst, const u64 dst_len)
+{
+  memcpy (dst, buf, dst_len);
+
+  return buf + dst_len;
+}
+#endif
+
+/// hand the result of hashes_init_stage1 () and hashes_init_stage2 () on rank 0 to the other ranks, which did not read
+/// the hash file. rc is what rank 0 got from the stages. collective over all ranks
+int mm_hashes_bcast (MAYBE_UNUSED hashcat_ctx_t *hashcat_ctx, const int rc)
+{
+  #if defined (ENABLE_MPI)
+  hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  hashes_t             *hashes             = hashcat_ctx->hashes;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+
+  const bool root = (hashcat_ctx->cur_proc_id == 0);
+
+  /// { rc, hashlist_mode, hashlist_format, hashes_cnt, hashes_cnt_orig, salts_cnt, hash_info bytes }
+  u64 hdr[7] = { 0 };
+
+  u8  *info_buf   = NULL;
+  u64  info_len   = 0;
+  u64  info_avail = 0;
+
+  const bool with_info = (user_options->username == true) || (hashconfig->opts_type & OPTS_TYPE_HASH_COPY) || (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT);
+
+  if (root == true)
+  {
+    hdr[0] = (rc == -1) ? 1 : 0;
+
+    if (rc != -1)
+    {
+      hdr[1] = hashes->hashlist_mode;
+      hdr[2] = hashes->hashlist_format;
+      hdr[3] = hashes->hashes_cnt;
+      hdr[4] = hashes->hashes_cnt_orig;
+      hdr[5] = hashes->salts_cnt;
+
+      /// the only parts of a hash_t which do not live in the packed buffers
+      for (u32 hashes_pos = 0; (with_info == true) && (hashes_pos < hashes->hashes_cnt); hashes_pos++)
+      {
+        const hashinfo_t *hash_info = hashes->hash_info[hashes_pos];
+
+        if (user_options->username == true)
+        {
+          mm_pack (&info_buf, &info_len, &info_avail, &hash_info->user->user_len, sizeof (u32));
+          mm_pack (&info_buf, &info_len, &info_avail,  hash_info->user->user_name, hash_info->user->user_len);
+        }
+
+        if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
+        {
+          const u32 orighash_len = (u32) strlen (hash_info->orighash);
+
+          mm_pack (&info_buf, &info_len, &info_avail, &orighash_len, sizeof (u32));
+          mm_pack (&info_buf, &info_len, &info_avail,  hash_info->orighash, orighash_len);
+        }
+
+        if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
+        {
+          mm_pack (&info_buf, &info_len, &info_avail, hash_info->split, sizeof (split_t));
+        }
+      }
+
+      hdr[6] = info_len;
+    }
+  }
+
+  mm_bcast_bytes (hashcat_ctx, hdr, sizeof (hdr));
+
+  if (hdr[0] == 1) return -1;
+
+  const u32 hashes_cnt = (u32) hdr[3];
+  const u32 salts_cnt  = (u32) hdr[5];
+
+  if (root == false)
+  {
+    hashes->hashfile        = user_options_extra->hc_hash;
+    hashes->hashlist_mode   = (u32) hdr[1];
+    hashes->hashlist_format = (u32) hdr[2];
+    hashes->hashes_cnt      = hashes_cnt;
+    hashes->hashes_cnt_orig = (u32) hdr[4];
+
+    mm_hashes_alloc (hashcat_ctx, hashes_cnt, salts_cnt);
+
+    info_buf = (u8 *) hcmalloc (hdr[6] + 1);
+  }
+
+  mm_bcast_bytes (hashcat_ctx, hashes->digests_buf, (u64) hashes_cnt * hashconfig->dgst_size);
+  mm_bcast_bytes (hashcat_ctx, hashes->salts_buf,   (u64) salts_cnt  * sizeof (salt_t));
+
+  if (hashconfig->esalt_size)     mm_bcast_bytes (hashcat_ctx, hashes->esalts_buf,     (u64) hashes_cnt * hashconfig->esalt_size);
+  if (hashconfig->hook_salt_size) mm_bcast_bytes (hashcat_ctx, hashes->hook_salts_buf, (u64) salts_cnt  * hashconfig->hook_salt_size);
+
+  mm_bcast_bytes (hashcat_ctx, info_buf, hdr[6]);
+
+  if (root == false)
+  {
+    mm_hashes_link (hashcat_ctx);
+
+    hash_t *hashes_buf = hashes->hashes_buf;
+
+    if (with_info == true) hashes->hash_info = (hashinfo_t **) hccalloc (hashes_cnt, sizeof (hashinfo_t *));
+
+    const u8 *info_ptr = info_buf;
+
+    for (u32 hashes_pos = 0; (with_info == true) && (hashes_pos < hashes_cnt); hashes_pos++)
+    {
+      hashinfo_t *hash_info = (hashinfo_t *) hcmalloc (sizeof (hashinfo_t));
+
+      if (user_options->username == true)
+      {
+        hash_info->user = (user_t *) hcmalloc (sizeof (user_t));
+
+        info_ptr = mm_unpack (info_ptr, &hash_info->user->user_len, sizeof (u32));
+
+        hash_info->user->user_name = (char *) hcmalloc (hash_info->user->user_len + 1);
+
+        info_ptr = mm_unpack (info_ptr, hash_info->user->user_name, hash_info->user->user_len);
+      }
+
+      if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)
+      {
+        u32 orighash_len = 0;
+
+        info_ptr = mm_unpack (info_ptr, &orighash_len, sizeof (u32));
+
+        hash_info->orighash = (char *) hcmalloc (MAX (256, orighash_len + 1));
+
+        info_ptr = mm_unpack (info_ptr, hash_info->orighash, orighash_len);
+      }
+
+      if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)
+      {
+        hash_info->split = (split_t *) hcmalloc (sizeof (split_t));
+
+        info_ptr = mm_unpack (info_ptr, hash_info->split, sizeof (split_t));
+      }
+
+      hashes->hash_info[hashes_pos] = hash_info;
+
+      hashes_buf[hashes_pos].hash_info = hash_info;
+    }
+  }
+
+  hcfree (info_buf);
+
+  return 0;
+  #else
+  return rc;
+  #endif
+}
+
+/// --mm-hash-cache keeps pointers nowhere, so the lists with a hash_info per hash have to be parsed every time
+static bool mm_hash_cache_enabled (const hashcat_ctx_t *hashcat_ctx)
+{
+  const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  const user_options_t *user_options = hashcat_ctx->user_options;
+
+  if (user_options->mm_hash_cache == false) return false;
+
+  if (user_options->benchmark   == true) return false;
+  if (user_options->keyspace    == true) return false;
+  if (user_options->stdout_flag == true) return false;
+  if (user_options->opencl_info == true) return false;
+  if (user_options->username    == true) return false;
+
+  if (hashconfig->opts_type & OPTS_TYPE_BINARY_HASHFILE) return false;
+  if (hashconfig->opts_type & OPTS_TYPE_HASH_COPY)       return false;
+  if (hashconfig->opts_type & OPTS_TYPE_HASH_SPLIT)      return false;
+
+  return true;
+}
+
+/// the header of the hash file as it is now, false if it is no regular file we could cache.
+/// the cache file is named after the resolved path and the hash-type, so one profile dir holds the caches of many lists
+static bool mm_hash_cache_key (hashcat_ctx_t *hashcat_ctx, mm_hash_cache_hdr_t *hdr, char **cache_file)
+{
+  const folder_config_t      *folder_config      = hashcat_ctx->folder_config;
+  const hashconfig_t         *hashconfig         = hashcat_ctx->hashconfig;
+  const potfile_ctx_t        *potfile_ctx        = hashcat_ctx->potfile_ctx;
+  const user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+
+  hc_stat_t st;
+
+  if (hc_stat (user_options_extra->hc_hash, &st) == -1) return false;
+
+  if (S_ISREG (st.st_mode) == 0) return false;
+
+  char *hashfile = mm_realpath (user_options_extra->hc_hash);
+
+  if (hashfile == NULL) return false;
+
+  const size_t hashfile_len = strlen (hashfile);
+
+  if (hashfile_len >= sizeof (hdr->hashfile))
+  {
+    free (hashfile);
+
+    return false;
+  }
+
+  memset (hdr, 0, sizeof (mm_hash_cache_hdr_t));
+
+  hdr->magic           = MM_HASH_CACHE_MAGIC;
+  hdr->version         = MM_HASH_CACHE_VERSION;
+  hdr->hash_mode       = hashconfig->hash_mode;
+  hdr->keep_all_hashes = (potfile_ctx->keep_all_hashes == true) ? 1 : 0;
+  hdr->opts_type       = hashconfig->opts_type;
+  hdr->file_size       = (u64) st.st_size;
+  hdr->file_mtime      = (u64) st.st_mtime;
+  hdr->dgst_size       = hashconfig->dgst_size;
+  hdr->salt_size       = sizeof (salt_t);
+  hdr->esalt_size      = hashconfig->esalt_size;
+  hdr->hook_salt_size  = hashconfig->hook_salt_size;
+
+  memcpy (hdr->hashfile, hashfile, hashfile_len);
+
+  free (hashfile);
+
+  /// FNV-1a, only used to pick the file name, the header holds the full key
+  u64 key = 0xcbf29ce484222325;
+
+  for (size_t i = 0; i < hashfile_len; i++)
+  {
+    key ^= (u8) hdr->hashfile[i];
+    key *= 0x100000001b3;
+  }
+
+  key ^= hdr->hash_mode;
+  key *= 0x100000001b3;
+
+  hc_asprintf (cache_file, "%s/hashcat.hashcache.%08x%08x", folder_config->profile_dir, (u32) (key >> 32), (u32) key);
+
+  return true;
+}
+
+/// the digests, salts, esalts and hook salts follow the header back to back, in the order hashes_init_stage2 () left them
+static u64 mm_hash_cache_section (const mm_hash_cache_hdr_t *hdr, const int section)
+{
+  switch (section)
+  {
+    case 0: return (u64) hdr->hashes_cnt * hdr->dgst_size;
+    case 1: return (u64) hdr->salts_cnt  * hdr->salt_size;
+    case 2: return (u64) hdr->hashes_cnt * hdr->esalt_size;
+    case 3: return (u64) hdr->salts_cnt  * hdr->hook_salt_size;
+  }
+
+  return 0;
+}
+
+/// --mm-hash-cache: 1 if the hash list was taken from the cache and hashes_init_stage1 () and hashes_init_stage2 () can be
+/// skipped, 0 if they have to run. a stale or broken cache file only means we parse again
+int mm_hash_cache_load (hashcat_ctx_t *hashcat_ctx)
+{
+  hashes_t             *hashes             = hashcat_ctx->hashes;
+  user_options_t       *user_options       = hashcat_ctx->user_options;
+  user_options_extra_t *user_options_extra = hashcat_ctx->user_options_extra;
+
+  if (mm_hash_cache_enabled (hashcat_ctx) == false) return 0;
+
+  mm_hash_cache_hdr_t want;
+
+  char *cache_file = NULL;
+
+  if (mm_hash_cache_key (hashcat_ctx, &want, &cache_file) == false) return 0;
+
+  FILE *fp = fopen (cache_file, "rb");
+
+  hcfree (cache_file);
+
+  if (fp == NULL) return 0;
+
+  mm_hash_cache_hdr_t hdr;
+
+  if (fread (&hdr, sizeof (mm_hash_cache_hdr_t), 1, fp) != 1)
+  {
+    fclose (fp);
+
+    return 0;
+  }
+
+  /// the counts are the payload, everything in front of them is the key
+  const size_t key_len = offsetof (mm_hash_cache_hdr_t, hashlist_format);
+
+  if ((memcmp (&hdr, &want, key_len) != 0) || (strcmp (hdr.hashfile, want.hashfile) != 0) || (hdr.hashes_cnt == 0) || (hdr.salts_cnt == 0))
+  {
+    fclose (fp);
+
+    return 0;
+  }
+
+  /// hashes_init_stage1 () refuses this, let it say so
+  if ((user_options->remove == true) && (hdr.hashlist_format != HLFMT_HASHCAT))
+  {
+    fclose (fp);
+
+    return 0;
+  }
+
+  mm_hashes_alloc (hashcat_ctx, hdr.hashes_cnt, hdr.salts_cnt);
+
+  void *sections[4] = { hashes->digests_buf, hashes->salts_buf, hashes->esalts_buf, hashes->hook_salts_buf };
+
+  bool valid = true;
+
+  for (int section = 0; section < 4; section++)
+  {
+    const u64 len = mm_hash_cache_section (&hdr, section);
+
+    if (len == 0) continue;
+
+    if (fread (sections[section], 1, len, fp) != len) valid = false;
+  }
+
+  fclose (fp);
+
+  /// the salts give the layout of everything else, do not follow a digests_offset out of the buffers
+  u64 digests_sum = 0;
+
+  for (u32 salts_pos = 0; (valid == true) && (salts_pos < hdr.salts_cnt); salts_pos++)
+  {
+    const salt_t *salt_buf = &hashes->salts_buf[salts_pos];
+
+    if (((u64) salt_buf->digests_offset + salt_buf->digests_cnt) > hdr.hashes_cnt) valid = false;
+
+    digests_sum += salt_buf->digests_cnt;
+  }
+
+  if ((valid == false) || (digests_sum != hdr.hashes_cnt))
+  {
+    hcfree (hashes->hashes_buf);
+    hcfree (hashes->digests_buf);
+    hcfree (hashes->digests_shown);
+    hcfree (hashes->digests_shown_tmp);
+    hcfree (hashes->salts_buf);
+    hcfree (hashes->salts_shown);
+    hcfree (hashes->esalts_buf);
+    hcfree (hashes->hook_salts_buf);
+
+    hashes->hashes_buf        = NULL;
+    hashes->digests_buf       = NULL;
+    hashes->digests_shown     = NULL;
+    hashes->digests_shown_tmp = NULL;
+    hashes->salts_buf         = NULL;
+    hashes->salts_shown       = NULL;
+    hashes->esalts_buf        = NULL;
+    hashes->hook_salts_buf    = NULL;
+
+    hashes->digests_cnt = 0;
+    hashes->salts_cnt   = 0;
+
+    return 0;
+  }
+
+  mm_hashes_link (hashcat_ctx);
+
+  hashes->hashfile        = user_options_extra->hc_hash;
+  hashes->hashlist_mode   = HL_MODE_FILE;
+  hashes->hashlist_format = hdr.hashlist_format;
+  hashes->hashes_cnt      = hdr.hashes_cnt;
+  hashes->hashes_cnt_orig = hdr.hashes_cnt_orig;
+  hashes->hash_info       = NULL;
+
+  return 1;
+}
+
+/// --mm-hash-cache: store what hashes_init_stage2 () built from a hash file for the next session. written to a temporary
+/// file first, ranks of one node share the profile dir
+void mm_hash_cache_save (hashcat_ctx_t *hashcat_ctx)
+{
+  hashes_t *hashes = hashcat_ctx->hashes;
+
+  if (mm_hash_cache_enabled (hashcat_ctx) == false) return;
+
+  if (hashes->hashlist_mode != HL_MODE_FILE) return;
+
+  if (hashes->hashes_cnt == 0) return;
+
+  mm_hash_cache_hdr_t hdr;
+
+  char *cache_file = NULL;
+
+  if (mm_hash_cache_key (hashcat_ctx, &hdr, &cache_file) == false) return;
+
+  hdr.hashlist_format = hashes->hashlist_format;
+  hdr.hashes_cnt      = hashes->hashes_cnt;
+  hdr.hashes_cnt_orig = hashes->hashes_cnt_orig;
+  hdr.salts_cnt       = hashes->salts_cnt;
+
+  char *tmp_file;
+
+  hc_asprintf (&tmp_file, "%s.%d.tmp", cache_file, hashcat_ctx->cur_proc_id);
+
+  FILE *fp = fopen (tmp_file, "wb");
+
+  if (fp != NULL)
+  {
+    const void *sections[4] = { hashes->digests_buf, hashes->salts_buf, hashes->esalts_buf, hashes->hook_salts_buf };
+
+    bool written = (fwrite (&hdr, sizeof (mm_hash_cache_hdr_t), 1, fp) == 1);
+
+    for (int section = 0; (written == true) && (section < 4); section++)
+    {
+      const u64 len = mm_hash_cache_section (&hdr, section);
+
+      if (len == 0) continue;
+
+      written = (fwrite (sections[section], 1, len, fp) == len);
+    }
+
+    if (fclose (fp) != 0) written = false;
+
+    if ((written == false) || (rename (tmp_file, cache_file) != 0)) unlink (tmp_file);
+  }
+
+  hcfree (tmp_file);
+  hcfree (cache_file);
+}
+
+/// remember a kernel cache file opencl_session_begin () used on rank 0
+void mm_kernel_cache_add (hashcat_ctx_t *hashcat_ctx, const char *cached_file)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_bcast_init_enabled (hashcat_ctx) == false) return;
+
+  if (hashcat_ctx->cur_proc_id != 0) return;
+
+  for (u32 i = 0; i < mm_ctx->kernel_files_cnt; i++)
+  {
+    if (strcmp (mm_ctx->kernel_files[i], cached_file) == 0) return;
+  }
+
+  if (mm_ctx->kernel_files_cnt == mm_ctx->kernel_files_avail)
+  {
+    mm_ctx->kernel_files = (char **) hcrealloc (mm_ctx->kernel_files, mm_ctx->kernel_files_avail * sizeof (char *), 8 * sizeof (char *));
+
+    mm_ctx->kernel_files_avail += 8;
+  }
+
+  mm_ctx->kernel_files[mm_ctx->kernel_files_cnt++] = hcstrdup (cached_file);
+}
+
+/// rank 0 sends the kernel binaries it built or loaded, the other ranks store them in their own kernel cache before
+/// they run opencl_session_begin (). the cache file name carries a checksum of the device name, driver and build
+/// options, so ranks with other devices never pick up a foreign binary. rc is the opencl_session_begin () result
+/// on rank 0. collective over all ranks
+int mm_kernel_cache_bcast (MAYBE_UNUSED hashcat_ctx_t *hashcat_ctx, const int rc)
+{
+  #if defined (ENABLE_MPI)
+  folder_config_t *folder_config = hashcat_ctx->folder_config;
+  mm_ctx_t        *mm_ctx        = hashcat_ctx->mm_ctx;
+
+  const bool root = (hashcat_ctx->cur_proc_id == 0);
+
+  /// { failed, files }
+  u64 hdr[2] = { 0 };
+
+  if (root == true)
+  {
+    hdr[0] = (rc == -1) ? 1 : 0;
+    hdr[1] = (rc == -1) ? 0 : mm_ctx->kernel_files_cnt;
+  }
+
+  mm_bcast_bytes (hashcat_ctx, hdr, sizeof (hdr));
+
+  for (u64 i = 0; i < hdr[1]; i++)
+  {
+    char name[256] = { 0 };
+
+    char *binary = NULL;
+
+    /// { name length, binary size }, a size of 0 means rank 0 has no such file
+    u64 file_hdr[2] = { 0 };
+
+    if (root == true)
+    {
+      char *cached_file = mm_ctx->kernel_files[i];
+
+      strncpy (name, filename_from_filepath (cached_file), sizeof (name) - 1);
+
+      file_hdr[0] = strlen (name);
+
+      hc_stat_t st;
+
+      FILE *fp = fopen (cached_file, "rb");
+
+      if ((fp != NULL) && (hc_stat (cached_file, &st) == 0))
+      {
+        binary = (char *) hcmalloc (st.st_size + 1);
+
+        if (fread (binary, 1, st.st_size, fp) == (size_t) st.st_size) file_hdr[1] = st.st_size;
+      }
+
+      if (fp != NULL) fclose (fp);
+    }
+
+    mm_bcast_bytes (hashcat_ctx, file_hdr, sizeof (file_hdr));
+
+    if (file_hdr[1] == 0)
+    {
+      hcfree (binary);
+
+      continue;
+    }
+
+    if (root == false) binary = (char *) hcmalloc (file_hdr[1] + 1);
+
+    mm_bcast_bytes (hashcat_ctx, name, file_hdr[0]);
+    mm_bcast_bytes (hashcat_ctx, binary, file_hdr[1]);
+
+    if (root == false)
+    {
+      char *cached_file;
+      char *tmp_file;
+
+      hc_asprintf (&cached_file, "%s/kernels/%s", folder_config->profile_dir, name);
+      hc_asprintf (&tmp_file, "%s.%d.tmp", cached_file, hashcat_ctx->cur_proc_id);
+
+      /// ranks of one node share the profile dir, the rename makes sure nobody loads a half written binary
+      if ((hc_path_read (cached_file) == false) || (hc_path_is_empty (cached_file) == true))
+      {
+        FILE *fp = fopen (tmp_file, "wb");
+
+        if (fp != NULL)
+        {
+          const bool written = (fwrite (binary, 1, file_hdr[1], fp) == file_hdr[1]);
+
+          fclose (fp);
+
+          if ((written == false) || (rename (tmp_file, cached_file) != 0)) unlink (tmp_file);
+        }
+      }
+
+      hcfree (tmp_file);
+      hcfree (cached_file);
+    }
+
+    hcfree (binary);
+  }
+
+  for (u32 i = 0; i < mm_ctx->kernel_files_cnt; i++) hcfree (mm_ctx->kernel_files[i]);
+
+  mm_ctx->kernel_files_cnt = 0;
+
+  return (hdr[0] == 1) ? -1 : 0;
+  #else
+  return rc;
+  #endif
 }
@@ -0,0 +1,562 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "mm_impl.h"
+#include "mm_notify.h"
+#include "mm_ckpt.h"
+#include "memory.h"
+#include "shared.h"
+#include "thread.h"
+#include "event.h"
+#include "timer.h"
+#include "hashcat.h"
+#include "potfile.h"
+
+/// reset the stop propagation state, called by the monitor thread before its loop
+void mm_notify_init (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  mm_ctx->done_sent     = false;
+  mm_ctx->done_cnt      = 0;
+  mm_ctx->stop_sent     = false;
+  mm_ctx->crack_origin  = false;
+  mm_ctx->acks_cnt      = 0;
+  mm_ctx->stop_msec     = 0;
+  mm_ctx->stop_recorded = false;
+
+  for (int event = MM_EVENT_NONE; event <= MM_EVENT_ERROR; event++)
+  {
+    mm_ctx->notify_msg[event][0] = event;
+    mm_ctx->notify_msg[event][1] = hashcat_ctx->cur_proc_id;
+  }
+
+  mm_ctx->node_done_cnt = 0;
+
+  mm_ctx->done_msg[0][0] = MM_EVENT_FINISHED;
+  mm_ctx->done_msg[0][1] = 1;
+  mm_ctx->done_msg[1][0] = MM_EVENT_FINISHED;
+  mm_ctx->done_msg[1][1] = (mm_ctx->topology == true) ? mm_ctx->node_size : 1;
+
+  #if defined (ENABLE_MPI)
+  mm_ctx->reqs_cnt = 0;
+  #endif
+}
+
+#if defined (ENABLE_MPI)
+/// synchronous send, so that mm_notify_finish() knows when nothing is in flight anymore.
+/// buf has to stay untouched until then
+void mm_notify_isend (hashcat_ctx_t *hashcat_ctx, const void *buf, const int cnt, MPI_Datatype type, const int dest, const int tag)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->reqs_cnt == mm_ctx->reqs_avail)
+  {
+    mm_ctx->reqs = (MPI_Request *) hcrealloc (mm_ctx->reqs, mm_ctx->reqs_avail * sizeof (MPI_Request), 16 * sizeof (MPI_Request));
+
+    mm_ctx->reqs_avail += 16;
+  }
+
+  MPI_Issend (buf, cnt, type, dest, tag, mm_ctx->comm, &mm_ctx->reqs[mm_ctx->reqs_cnt]);
+
+  mm_ctx->reqs_cnt++;
+}
+
+static void mm_notify_send (hashcat_ctx_t *hashcat_ctx, const int dest, const int tag, const int event)
+{
+  mm_notify_isend (hashcat_ctx, hashcat_ctx->mm_ctx->notify_msg[event], 2, MPI_INT, dest, tag);
+}
+
+/// true if news from src have to be passed on by us. a rank hands its own news to its node leader, a leader passes
+/// news from its node to the other leaders and news from anywhere to its node. every rank gets them exactly once
+static bool mm_route_relays (const hashcat_ctx_t *hashcat_ctx, const int src)
+{
+  const int me = hashcat_ctx->cur_proc_id;
+
+  if (src == me) return true;
+
+  /// without topology every rank already got it from the origin
+  if (hashcat_ctx->mm_ctx->topology == false) return false;
+
+  return (mm_leader_of (hashcat_ctx, me) == me);
+}
+
+static void mm_route_send (hashcat_ctx_t *hashcat_ctx, const int src, const void *buf, const int cnt, MPI_Datatype type, const int tag)
+{
+  const int me     = hashcat_ctx->cur_proc_id;
+  const int leader = mm_leader_of (hashcat_ctx, me);
+
+  if (mm_route_relays (hashcat_ctx, src) == false) return;
+
+  if (leader != me)
+  {
+    mm_notify_isend (hashcat_ctx, buf, cnt, type, leader, tag);
+
+    return;
+  }
+
+  const bool from_node = (src == me) || (mm_leader_of (hashcat_ctx, src) == me);
+
+  for (int rank = 0; rank < hashcat_ctx->total_proc_cnt; rank++)
+  {
+    if ((rank == me) || (rank == src)) continue;
+
+    const int rank_leader = mm_leader_of (hashcat_ctx, rank);
+
+    if ((rank_leader == me) || ((from_node == true) && (rank_leader == rank)))
+    {
+      mm_notify_isend (hashcat_ctx, buf, cnt, type, rank, tag);
+    }
+  }
+}
+#endif
+
+/// count ranks without work left. a leader reports its node as a whole once all of it is done, rank 0 sums up the nodes
+static void mm_notify_done (hashcat_ctx_t *hashcat_ctx, const int src, const int cnt)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  const int me = hashcat_ctx->cur_proc_id;
+
+  #if defined (ENABLE_MPI)
+  const int leader = mm_leader_of (hashcat_ctx, me);
+
+  if (leader != me)
+  {
+    mm_notify_isend (hashcat_ctx, mm_ctx->done_msg[0], 2, MPI_INT, leader, MM_TAG_DONE);
+
+    return;
+  }
+  #endif
+
+  if ((src != me) && (mm_leader_of (hashcat_ctx, src) != me))
+  {
+    mm_ctx->done_cnt += cnt;
+
+    return;
+  }
+
+  mm_ctx->node_done_cnt += cnt;
+
+  if (mm_ctx->node_done_cnt < mm_ctx->done_msg[1][1]) return;
+
+  if (me == 0)
+  {
+    mm_ctx->done_cnt += mm_ctx->node_done_cnt;
+  }
+  #if defined (ENABLE_MPI)
+  else
+  {
+    mm_notify_isend (hashcat_ctx, mm_ctx->done_msg[1], 2, MPI_INT, 0, MM_TAG_DONE);
+  }
+  #endif
+}
+
+/// remember a local crack, called from check_hash() with mux_display held
+void mm_share_crack (hashcat_ctx_t *hashcat_ctx, const u32 salt_pos, const u32 hash_pos, const char *line)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->multi_target == false) return;
+
+  if (mm_ctx->share_cnt + 2 > mm_ctx->share_avail)
+  {
+    mm_ctx->share_buf = (u32 *) hcrealloc (mm_ctx->share_buf, mm_ctx->share_avail * sizeof (u32), 256 * sizeof (u32));
+
+    mm_ctx->share_avail += 256;
+  }
+
+  mm_ctx->share_buf[mm_ctx->share_cnt++] = salt_pos;
+  mm_ctx->share_buf[mm_ctx->share_cnt++] = hash_pos;
+
+  if (mm_ctx->cracks_cnt == mm_ctx->cracks_avail)
+  {
+    mm_ctx->cracks = (char **) hcrealloc (mm_ctx->cracks, mm_ctx->cracks_avail * sizeof (char *), 16 * sizeof (char *));
+
+    mm_ctx->cracks_avail += 16;
+  }
+
+  mm_ctx->cracks[mm_ctx->cracks_cnt++] = hcstrdup (line);
+}
+
+#if defined (ENABLE_MPI)
+/// send buffers stay until mm_notify_finish ()
+void mm_share_keep (hashcat_ctx_t *hashcat_ctx, void *buf)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->share_sent_cnt == mm_ctx->share_sent_avail)
+  {
+    mm_ctx->share_sent = (void **) hcrealloc (mm_ctx->share_sent, mm_ctx->share_sent_avail * sizeof (void *), 16 * sizeof (void *));
+
+    mm_ctx->share_sent_avail += 16;
+  }
+
+  mm_ctx->share_sent[mm_ctx->share_sent_cnt++] = buf;
+}
+#endif
+
+/// send the cracks collected since the last poll to all other ranks
+static void mm_share_flush (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  if (mm_ctx->multi_target == false) return;
+
+  hc_thread_mutex_lock (status_ctx->mux_display);
+
+  u32 *buf = mm_ctx->share_buf;
+
+  const u32 cnt = mm_ctx->share_cnt;
+
+  if (cnt > 0)
+  {
+    mm_ctx->share_buf   = NULL;
+    mm_ctx->share_cnt   = 0;
+    mm_ctx->share_avail = 0;
+  }
+
+  hc_thread_mutex_unlock (status_ctx->mux_display);
+
+  if (cnt == 0) return;
+
+  #if defined (ENABLE_MPI)
+  mm_share_keep (hashcat_ctx, buf);
+
+  mm_route_send (hashcat_ctx, hashcat_ctx->cur_proc_id, buf, (int) cnt, MPI_UNSIGNED, MM_TAG_HASH);
+  #else
+  hcfree (buf);
+  #endif
+}
+
+#if defined (ENABLE_MPI)
+/// mark the digests another rank cracked, returns true once nothing is left to crack
+static bool mm_share_apply (hashcat_ctx_t *hashcat_ctx, const u32 *buf, const int cnt)
+{
+  hashes_t     *hashes     = hashcat_ctx->hashes;
+  opencl_ctx_t *opencl_ctx = hashcat_ctx->opencl_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  bool changed = false;
+
+  hc_thread_mutex_lock (status_ctx->mux_display);
+
+  for (int i = 0; i + 1 < cnt; i += 2)
+  {
+    const u32 salt_pos = buf[i + 0];
+    const u32 hash_pos = buf[i + 1];
+
+    if ((salt_pos >= hashes->salts_cnt) || (hash_pos >= hashes->digests_cnt)) continue;
+
+    if (hashes->digests_shown[hash_pos] == 1) continue;
+
+    salt_t *salt_buf = &hashes->salts_buf[salt_pos];
+
+    hashes->digests_shown[hash_pos] = 1;
+
+    hashes->digests_done++;
+
+    salt_buf->digests_done++;
+
+    if (salt_buf->digests_done == salt_buf->digests_cnt)
+    {
+      hashes->salts_shown[salt_pos] = 1;
+
+      hashes->salts_done++;
+    }
+
+    changed = true;
+  }
+
+  const bool all_done = (hashes->salts_done == hashes->salts_cnt);
+
+  hc_thread_mutex_unlock (status_ctx->mux_display);
+
+  /// the device threads upload digests_shown before their next batch
+  if (changed == true)
+  {
+    for (u32 device_id = 0; device_id < opencl_ctx->devices_cnt; device_id++)
+    {
+      opencl_ctx->devices_param[device_id].digests_shown_dirty = true;
+    }
+  }
+
+  return all_done;
+}
+#endif
+
+/// tell every other rank to stop, without going through rank 0
+static void mm_notify_stop (hashcat_ctx_t *hashcat_ctx, const int event)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  if (mm_ctx->stop_sent == true) return;
+
+  mm_ctx->stop_sent = true;
+
+  if (event == MM_EVENT_CRACKED) mm_ctx->crack_origin = true;
+
+  #if defined (ENABLE_MPI)
+  mm_route_send (hashcat_ctx, hashcat_ctx->cur_proc_id, mm_ctx->notify_msg[event], 2, MPI_INT, MM_TAG_STOP);
+  #endif
+}
+
+/// receive whatever arrived. returns the event of the first STOP, acks crack STOPs if ack is set
+static int mm_notify_recv (MAYBE_UNUSED hashcat_ctx_t *hashcat_ctx, MAYBE_UNUSED const bool ack)
+{
+  int event = MM_EVENT_NONE;
+
+  #if defined (ENABLE_MPI)
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  while (event == MM_EVENT_NONE)
+  {
+    int flag = 0;
+
+    MPI_Status status;
+
+    MPI_Iprobe (MPI_ANY_SOURCE, MPI_ANY_TAG, mm_ctx->comm, &flag, &status);
+
+    if (flag == 0) break;
+
+    if (status.MPI_TAG == MM_TAG_CKPT)
+    {
+      int len = 0;
+
+      MPI_Get_count (&status, MPI_BYTE, &len);
+
+      mm_range_t *ranges = (mm_range_t *) hcmalloc (MAX (1, len));
+
+      MPI_Recv (ranges, len, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, mm_ctx->comm, MPI_STATUS_IGNORE);
+
+      mm_ckpt_merge (hashcat_ctx, ranges, len / sizeof (mm_range_t));
+
+      hcfree (ranges);
+
+      continue;
+    }
+
+    if (status.MPI_TAG == MM_TAG_HASH)
+    {
+      int cnt = 0;
+
+      MPI_Get_count (&status, MPI_UNSIGNED, &cnt);
+
+      u32 *buf = (u32 *) hccalloc (cnt + 1, sizeof (u32));
+
+      MPI_Recv (buf, cnt, MPI_UNSIGNED, status.MPI_SOURCE, status.MPI_TAG, mm_ctx->comm, MPI_STATUS_IGNORE);
+
+      /// the others found the rest for us, stop just like on a crack STOP
+      if (mm_share_apply (hashcat_ctx, buf, cnt) == true) event = MM_EVENT_CRACKED;
+
+      if ((ack == true) && (mm_route_relays (hashcat_ctx, status.MPI_SOURCE) == true))
+      {
+        mm_share_keep (hashcat_ctx, buf);
+
+        mm_route_send (hashcat_ctx, status.MPI_SOURCE, buf, cnt, MPI_UNSIGNED, MM_TAG_HASH);
+      }
+      else
+      {
+        hcfree (buf);
+      }
+
+      continue;
+    }
+
+    int msg[2] = { 0 };
+
+    MPI_Recv (msg, 2, MPI_INT, status.MPI_SOURCE, status.MPI_TAG, mm_ctx->comm, MPI_STATUS_IGNORE);
+
+    if (status.MPI_TAG == MM_TAG_DONE)
+    {
+      /// late ones only count, their leader is gone already
+      if (ack == true) mm_notify_done (hashcat_ctx, status.MPI_SOURCE, msg[1]);
+      else             mm_ctx->done_cnt += msg[1];
+    }
+    else if (status.MPI_TAG == MM_TAG_ACK)
+    {
+      mm_ctx->acks_cnt++;
+
+      if (mm_ctx->acks_cnt + 1 == hashcat_ctx->total_proc_cnt)
+      {
+        mm_ctx->stop_msec     = hc_timer_get (mm_ctx->crack_timer);
+        mm_ctx->stop_recorded = true;
+      }
+    }
+    else if (status.MPI_TAG == MM_TAG_STOP)
+    {
+      if ((ack == true) && (msg[0] == MM_EVENT_CRACKED))
+      {
+        mm_notify_send (hashcat_ctx, msg[1], MM_TAG_ACK, MM_EVENT_CRACKED);
+      }
+
+      /// the first STOP is enough for everybody, a leader passes on just that one
+      if ((ack == true) && (mm_ctx->stop_sent == false))
+      {
+        mm_ctx->stop_sent = true;
+
+        mm_ctx->stop_msg[0] = msg[0];
+        mm_ctx->stop_msg[1] = msg[1];
+
+        mm_route_send (hashcat_ctx, status.MPI_SOURCE, mm_ctx->stop_msg, 2, MPI_INT, MM_TAG_STOP);
+      }
+
+      event = msg[0];
+    }
+  }
+  #endif
+
+  return event;
+}
+
+/// announce our own news and look for the news of the others
+static int mm_notify_poll (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t *mm_ctx = hashcat_ctx->mm_ctx;
+
+  mm_share_flush (hashcat_ctx);
+
+  /// same priority as the old Reduce: cracked, finished, error
+  if (hashcat_ctx->cracked[0] == 1)
+  {
+    mm_notify_stop (hashcat_ctx, MM_EVENT_CRACKED);
+
+    if ((hashcat_ctx->total_proc_cnt == 1) && (mm_ctx->stop_recorded == false))
+    {
+      mm_ctx->stop_msec     = hc_timer_get (mm_ctx->crack_timer);
+      mm_ctx->stop_recorded = true;
+    }
+
+    return MM_EVENT_CRACKED;
+  }
+
+  if ((hashcat_ctx->cracked[1] == 1) && (mm_ctx->done_sent == false))
+  {
+    mm_ctx->done_sent = true;
+
+    mm_notify_done (hashcat_ctx, hashcat_ctx->cur_proc_id, 1);
+  }
+
+  if (hashcat_ctx->cracked[2] == 1)
+  {
+    /// --mm-degraded: only we stop, the others take over what we left once they are done
+    if (mm_ctx->degraded == false)
+    {
+      mm_notify_stop (hashcat_ctx, MM_EVENT_ERROR);
+
+      return MM_EVENT_ERROR;
+    }
+
+    if (mm_ctx->failed == false)
+    {
+      mm_ctx->failed = true;
+
+      return MM_EVENT_FAILED;
+    }
+  }
+
+  const int event = mm_notify_recv (hashcat_ctx, true);
+
+  if (event != MM_EVENT_NONE) return event;
+
+  /// rank 0 is the only one who knows when all ranks are done
+  if ((hashcat_ctx->cur_proc_id == 0) && (mm_ctx->done_cnt == hashcat_ctx->total_proc_cnt))
+  {
+    mm_notify_stop (hashcat_ctx, MM_EVENT_FINISHED);
+
+    return MM_EVENT_FINISHED;
+  }
+
+  return MM_EVENT_NONE;
+}
+
+/// replaces the one second sleep of the monitor, wakes up as soon as any rank has news
+int mm_notify_wait (hashcat_ctx_t *hashcat_ctx, const u32 msec)
+{
+  for (u32 waited = 0; waited < msec; waited += MM_NOTIFY_POLL_MSEC)
+  {
+    const int event = mm_notify_poll (hashcat_ctx);
+
+    if (event != MM_EVENT_NONE) return event;
+
+    hc_sleep_msec (MM_NOTIFY_POLL_MSEC);
+  }
+
+  return mm_notify_poll (hashcat_ctx);
+}
+
+/// wait until every rank left its monitor loop and nothing is in flight, then log the crack latency
+void mm_notify_finish (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t     *mm_ctx     = hashcat_ctx->mm_ctx;
+  status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
+
+  #if defined (ENABLE_MPI)
+  MPI_Request barrier = MPI_REQUEST_NULL;
+
+  int barrier_done = 0;
+
+  while (barrier_done == 0)
+  {
+    /// late STOPs are not acked anymore, we must not start new sends here
+    mm_notify_recv (hashcat_ctx, false);
+
+    if (barrier == MPI_REQUEST_NULL)
+    {
+      int sent = 0;
+
+      MPI_Testall (mm_ctx->reqs_cnt, mm_ctx->reqs, &sent, MPI_STATUSES_IGNORE);
+
+      if (sent) MPI_Ibarrier (mm_ctx->comm, &barrier);
+    }
+    else
+    {
+      MPI_Test (&barrier, &barrier_done, MPI_STATUS_IGNORE);
+    }
+
+    if (barrier_done == 0) hc_sleep_msec (1);
+  }
+
+  mm_ctx->reqs_cnt = 0;
+
+  for (u32 i = 0; i < mm_ctx->share_sent_cnt; i++) hcfree (mm_ctx->share_sent[i]);
+
+  mm_ctx->share_sent_cnt = 0;
+  #endif
+
+  hcfree (mm_ctx->share_buf);
+
+  mm_ctx->share_buf   = NULL;
+  mm_ctx->share_cnt   = 0;
+  mm_ctx->share_avail = 0;
+
+  for (u32 i = 0; i < mm_ctx->cracks_cnt; i++) hcfree (mm_ctx->cracks[i]);
+
+  mm_ctx->cracks_cnt    = 0;
+  mm_ctx->cracks_logged = 0;
+
+  if (mm_ctx->crack_origin == false) return;
+
+  /// not everybody confirmed, report what we have so far
+  if (mm_ctx->stop_recorded == false)
+  {
+    mm_ctx->stop_msec     = hc_timer_get (mm_ctx->crack_timer);
+    mm_ctx->stop_recorded = true;
+  }
+
+  hc_thread_mutex_lock (status_ctx->mux_display);
+
+  mm_logfile_append (hashcat_ctx, "{\"crack_to_stop_msec\":\"%.3f\",\"acked\":\"%d/%d\"}\n",
+                     mm_ctx->stop_msec, mm_ctx->acks_cnt, hashcat_ctx->total_proc_cnt - 1);
+
+  hc_thread_mutex_unlock (status_ctx->mux_display);
+}
\ No newline at end of file
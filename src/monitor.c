@@ -10,15 +10,15 @@
 #include "hwmon.h"
 #include "timer.h"
 #include "hashes.h"
+#include "potfile.h"
 #include "thread.h"
 #include "restore.h"
 #include "shared.h"
 #include "status.h"
 #include "monitor.h"
-#ifdef ENABLE_MPI
-#include "mpi.h"
-#endif
 #include "mm_impl.h"
+#include "mm_notify.h"
+#include "mm_ckpt.h"
 
 int get_runtime_left (const hashcat_ctx_t *hashcat_ctx)
 {
@@ -51,6 +51,7 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
   hashes_t       *hashes        = hashcat_ctx->hashes;
   hwmon_ctx_t    *hwmon_ctx     = hashcat_ctx->hwmon_ctx;
   opencl_ctx_t   *opencl_ctx    = hashcat_ctx->opencl_ctx;
+  potfile_ctx_t  *potfile_ctx   = hashcat_ctx->potfile_ctx;
   restore_ctx_t  *restore_ctx   = hashcat_ctx->restore_ctx;
   status_ctx_t   *status_ctx    = hashcat_ctx->status_ctx;
   user_options_t *user_options  = hashcat_ctx->user_options;
@@ -61,6 +62,7 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
   bool restore_check      = false;
   bool hwmon_check        = false;
   bool performance_check  = false;
+  bool shards_check       = false;
 
   const int   sleep_time      = 1;      // 1s 
   const int   temp_threshold  = 1;      // degrees celcius
@@ -99,6 +101,11 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
     performance_check = true; // this check simply requires hwmon to work
   }
 
+  if ((potfile_ctx->enabled == true) && (potfile_ctx->shards == true))
+  {
+    shards_check = true;
+  }
+
   if ((runtime_check == false) && (remove_check == false) && (status_check == false) && (restore_check == false) && (hwmon_check == false) && (performance_check == false))
   {
     //return 0;
@@ -131,9 +138,9 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
   u32 remove_left   = user_options->remove_timer;
   //u32 status_left   = user_options->status_timer;
   u32 status_left   = user_options->mm_log_interval;
+  u32 merge_left    = MM_POTFILE_MERGE_INTERVAL;
 
-  int global_cracked[3] = {0};
-
+  mm_notify_init (hashcat_ctx);
 
   while (/*status_ctx->shutdown_inner == false*/true)
   {
@@ -142,20 +149,11 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
       hashcat_ctx->cracked[1] = 1; 
     }
 
-    hc_sleep (sleep_time);
-
-#ifdef ENABLE_MPI
-    MPI_Reduce(hashcat_ctx->cracked, global_cracked, 3, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
-    MPI_Bcast(global_cracked, 3, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Barrier(MPI_COMM_WORLD);
-#else
-    global_cracked[0] = hashcat_ctx->cracked[0];
-    global_cracked[1] = hashcat_ctx->cracked[1];
-    global_cracked[2] = hashcat_ctx->cracked[2];
-#endif
+    /// sleeps for sleep_time unless some rank (maybe us) cracked, failed or all are done
+    const int mm_event = mm_notify_wait (hashcat_ctx, sleep_time * 1000);
 
     /// at least 1 proc cracked
-    if (global_cracked[0] != 0)
+    if (mm_event == MM_EVENT_CRACKED)
     {
       hc_thread_mutex_lock (status_ctx->mux_display);
       if ( !hashcat_ctx->crack_log_done )
@@ -169,7 +167,7 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
     }
 
     /// all running over but not cracked
-    if (global_cracked[1] == hashcat_ctx->total_proc_cnt)
+    if (mm_event == MM_EVENT_FINISHED)
     {
       hc_thread_mutex_lock (status_ctx->mux_display);
       update_log(hashcat_ctx,true);
@@ -177,12 +175,19 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
       break;
     }
 
-    if (global_cracked[2] != 0)
+    if (mm_event == MM_EVENT_ERROR)
     {
       myabort(hashcat_ctx);
       break;
     }
 
+    /// --mm-degraded: we stop alone but stay around until everybody is done, our part runs again without us
+    if (mm_event == MM_EVENT_FAILED)
+    {
+      myabort(hashcat_ctx);
+      continue;
+    }
+
     if (status_ctx->devices_status == STATUS_INIT) continue;
 
     if (hwmon_check == true)
@@ -333,6 +338,9 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
 
       if (restore_left == 0)
       {
+        /// with --mm-cluster-restore rank 0 writes the progress of all ranks
+        mm_ckpt_report (hashcat_ctx);
+
         const int rc = cycle_restore (hashcat_ctx);
 
         if (rc == -1) return -1;
@@ -372,6 +380,24 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
       }
     }
 
+    if (shards_check == true)
+    {
+      hc_thread_mutex_lock (status_ctx->mux_display);
+
+      potfile_shard_flush (hashcat_ctx);
+
+      hc_thread_mutex_unlock (status_ctx->mux_display);
+
+      merge_left--;
+
+      if (merge_left == 0)
+      {
+        potfile_shard_merge (hashcat_ctx);
+
+        merge_left = MM_POTFILE_MERGE_INTERVAL;
+      }
+    }
+
     //if (status_check == true)
     {
       status_left--;
@@ -445,6 +471,24 @@ static int monitor (hashcat_ctx_t *hashcat_ctx)
     }
   }
 
+  /// the barrier in mm_notify_finish() makes sure rank 0 sees every shard complete
+  if (shards_check == true)
+  {
+    hc_thread_mutex_lock (status_ctx->mux_display);
+
+    potfile_shard_flush (hashcat_ctx);
+
+    hc_thread_mutex_unlock (status_ctx->mux_display);
+  }
+
+  /// ... and the final checkpoint report as well, --mm-degraded needs it even without a restore file
+  mm_ckpt_report (hashcat_ctx);
+
+  /// nothing may be in flight once the monitor is gone
+  mm_notify_finish (hashcat_ctx);
+
+  if (shards_check == true) potfile_shard_merge (hashcat_ctx);
+
   // final round of save_hash
 
   if (remove_check == true)
@@ -1706,3 +1706,59 @@ int mask_ctx_parse_maskfile (hashcat_ctx_t *hashcat_ctx)
 
   return 0;
 }
+
+/// keyspace of mask masks_pos the way mask_ctx_update_loop () counts it for -a 3, 0 if the mask gets skipped for its length.
+/// clobbers the state of the current mask, mask_ctx_update_loop () sets it up again
+int mask_ctx_keyspace (hashcat_ctx_t *hashcat_ctx, const u32 masks_pos, u64 *result)
+{
+  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  mask_ctx_t     *mask_ctx     = hashcat_ctx->mask_ctx;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  *result = 0;
+
+  mask_ctx->mask = mask_ctx->masks[masks_pos];
+
+  const int rc_mask_file = mask_ctx_parse_maskfile (hashcat_ctx);
+
+  if (rc_mask_file == -1) return -1;
+
+  cs_t *css_buf = (cs_t *) hccalloc (256, sizeof (cs_t));
+
+  u32 css_cnt = 0;
+
+  const int rc_gen_css = mp_gen_css (hashcat_ctx, mask_ctx->mask, strlen (mask_ctx->mask), mask_ctx->mp_sys, mask_ctx->mp_usr, css_buf, &css_cnt);
+
+  if (rc_gen_css == -1)
+  {
+    hcfree (css_buf);
+
+    return -1;
+  }
+
+  if ((css_cnt < hashconfig->pw_min) || (css_cnt > hashconfig->pw_max))
+  {
+    hcfree (css_buf);
+
+    return 0;
+  }
+
+  // the utf16 and salt positions added later hold a single char each, they do not change the count
+
+  u32 uniq_tbls[SP_PW_MAX][CHARSIZ] = { { 0 } };
+
+  mp_css_to_uniq_tbl (hashcat_ctx, css_cnt, css_buf, uniq_tbls);
+
+  sp_tbl_to_css (mask_ctx->root_table_buf, mask_ctx->markov_table_buf, mask_ctx->root_css_buf, mask_ctx->markov_css_buf, user_options->markov_threshold, uniq_tbls);
+
+  hcfree (css_buf);
+
+  if (sp_get_sum (0, css_cnt, mask_ctx->root_css_buf, result) == -1)
+  {
+    event_log_error (hashcat_ctx, "Integer overflow detected in keyspace of mask: %s", mask_ctx->mask);
+
+    return -1;
+  }
+
+  return 0;
+}
@@ -25,6 +25,7 @@
 #include "event.h"
 #include "dynloader.h"
 #include "opencl.h"
+#include "mm_impl.h"
 
 #if defined (__linux__)
 static const char dri_card0_path[] = "/dev/dri/card0";
@@ -1089,6 +1090,72 @@ int gidd_to_pw_t (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, c
   return 0;
 }
 
+/*
+ * The following section depends on the hash mode
+ */
+
+static void hook23_range (const mm_hook_t *hook)
+{
+  switch (hook->hash_mode)
+  {
+    // for 7z we only need device_param->hooks_buf, but other hooks could use any info from device_param. All of them should/must update hooks_buf
+    case 11600: seven_zip_hook_func (hook->device_param, hook->hashes, hook->salt_pos, hook->pw_beg, hook->pw_end); break;
+  }
+}
+
+/*
+ * END of hash mode specific hook operations
+ */
+
+static void *thread_hook23 (void *p)
+{
+  hook23_range ((const mm_hook_t *) p);
+
+  return NULL;
+}
+
+/// --mm-hook-threads: the hooks of one batch are independent of each other, split them over worker threads. each device
+/// thread brings its own workers, the GPU waits for the hooks either way
+static void run_hook23 (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 salt_pos, const u32 pws_cnt)
+{
+  hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
+  hashes_t       *hashes       = hashcat_ctx->hashes;
+  user_options_t *user_options = hashcat_ctx->user_options;
+
+  const u32 threads_cnt = MAX (1, MIN (user_options->mm_hook_threads, pws_cnt));
+
+  mm_hook_t *hooks = (mm_hook_t *) hccalloc (threads_cnt, sizeof (mm_hook_t));
+
+  for (u32 i = 0; i < threads_cnt; i++)
+  {
+    mm_hook_t *hook = hooks + i;
+
+    hook->device_param = device_param;
+    hook->hashes       = hashes;
+    hook->hash_mode    = hashconfig->hash_mode;
+    hook->salt_pos     = salt_pos;
+    hook->pw_beg       = (u32) (((u64) pws_cnt * (i + 0)) / threads_cnt);
+    hook->pw_end       = (u32) (((u64) pws_cnt * (i + 1)) / threads_cnt);
+  }
+
+  if (threads_cnt == 1)
+  {
+    hook23_range (hooks);
+  }
+  else
+  {
+    hc_thread_t *threads = (hc_thread_t *) hccalloc (threads_cnt, sizeof (hc_thread_t));
+
+    for (u32 i = 0; i < threads_cnt; i++) hc_thread_create (threads[i], thread_hook23, hooks + i);
+
+    hc_thread_wait (threads_cnt, threads);
+
+    hcfree (threads);
+  }
+
+  hcfree (hooks);
+}
+
 int choose_kernel (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 highest_pw_len, const u32 pws_cnt, const u32 fast_iteration, const u32 salt_pos)
 {
   hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
@@ -1229,25 +1296,17 @@ int choose_kernel (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
 
         if (CL_rc == -1) return -1;
 
-        CL_rc = hc_clEnqueueReadBuffer (hashcat_ctx, device_param->command_queue, device_param->d_hooks, CL_TRUE, 0, device_param->size_hooks, device_param->hooks_buf, 0, NULL, NULL);
+        // only the hooks of this batch
 
-        if (CL_rc == -1) return -1;
+        const size_t size_hooks = MIN ((size_t) pws_cnt * hashconfig->hook_size, device_param->size_hooks);
 
-        /*
-         * The following section depends on the hash mode
-         */
+        CL_rc = hc_clEnqueueReadBuffer (hashcat_ctx, device_param->command_queue, device_param->d_hooks, CL_TRUE, 0, size_hooks, device_param->hooks_buf, 0, NULL, NULL);
 
-        switch (hashconfig->hash_mode)
-        {
-          // for 7z we only need device_param->hooks_buf, but other hooks could use any info from device_param. All of them should/must update hooks_buf
-          case 11600: seven_zip_hook_func (device_param, hashes, salt_pos, pws_cnt); break;
-        }
+        if (CL_rc == -1) return -1;
 
-        /*
-         * END of hash mode specific hook operations
-         */
+        run_hook23 (hashcat_ctx, device_param, salt_pos, pws_cnt);
 
-        CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_hooks, CL_TRUE, 0, device_param->size_hooks, device_param->hooks_buf, 0, NULL, NULL);
+        CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_hooks, CL_TRUE, 0, size_hooks, device_param->hooks_buf, 0, NULL, NULL);
 
         if (CL_rc == -1) return -1;
       }
@@ -1383,6 +1442,30 @@ int run_kernel (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, con
   CL_rc = hc_clSetKernelArg (hashcat_ctx, kernel, 33, sizeof (cl_uint), device_param->kernel_params[33]); if (CL_rc == -1) return -1;
   CL_rc = hc_clSetKernelArg (hashcat_ctx, kernel, 34, sizeof (cl_uint), device_param->kernel_params[34]); if (CL_rc == -1) return -1;
 
+  // --mm-salt-batch: the arguments are captured at enqueue time, the next salt can go right behind us
+
+  if (device_param->kernel_defer == true)
+  {
+    if (kern_run == KERN_RUN_2)
+    {
+      if (hashconfig->opti_type & OPTI_TYPE_SLOW_HASH_SIMD)
+      {
+        num_elements = CEILDIV (num_elements, device_param->vector_width);
+      }
+    }
+
+    while (num_elements % kernel_threads) num_elements++;
+
+    const size_t global_work_size[3] = { num_elements,   1, 1 };
+    const size_t local_work_size[3]  = { kernel_threads, 1, 1 };
+
+    CL_rc = hc_clEnqueueNDRangeKernel (hashcat_ctx, device_param->command_queue, kernel, 1, NULL, global_work_size, local_work_size, 0, NULL, NULL);
+
+    if (CL_rc == -1) return -1;
+
+    return hc_clFlush (hashcat_ctx, device_param->command_queue);
+  }
+
   cl_event event;
 
   if ((hashconfig->opts_type & OPTS_TYPE_PT_BITSLICE) && (user_options->attack_mode == ATTACK_MODE_BF))
@@ -1631,6 +1714,8 @@ int run_kernel_amp (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param,
 
   if (CL_rc == -1) return -1;
 
+  if (device_param->kernel_defer == true) return 0;
+
   CL_rc = hc_clFinish (hashcat_ctx, device_param->command_queue);
 
   if (CL_rc == -1) return -1;
@@ -1702,6 +1787,91 @@ int run_kernel_bzero (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_para
   return run_kernel_memset (hashcat_ctx, device_param, buf, 0, size);
 }
 
+/// --mm-pinned: host memory the driver can hand to the DMA engine as it is. it stays mapped for the whole session, the
+/// transfers from and to it skip the copy into a staging buffer of the driver
+static int pinned_alloc (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const size_t size, cl_mem *h_buf, void **buf)
+{
+  int CL_rc;
+
+  CL_rc = hc_clCreateBuffer (hashcat_ctx, device_param->context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size, NULL, h_buf);
+
+  if (CL_rc == -1) return -1;
+
+  CL_rc = hc_clEnqueueMapBuffer (hashcat_ctx, device_param->command_queue, *h_buf, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, size, 0, NULL, NULL, buf);
+
+  if (CL_rc == -1) return -1;
+
+  // same as hcmalloc ()
+
+  memset (*buf, 0, size);
+
+  return 0;
+}
+
+static void pinned_free (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, cl_mem h_buf, void *buf)
+{
+  if (h_buf == NULL) return;
+
+  if (buf != NULL) hc_clEnqueueUnmapMemObject (hashcat_ctx, device_param->command_queue, h_buf, buf, 0, NULL, NULL);
+
+  hc_clFinish (hashcat_ctx, device_param->command_queue);
+
+  hc_clReleaseMemObject (hashcat_ctx, h_buf);
+}
+
+/// --mm-pack-pws: expand the packed candidates in d_pws_packed into the pw_t of d_pws_buf
+int run_kernel_pws_unpack (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 num)
+{
+  u32 stride  = device_param->pws_stride;
+  u32 gid_max = num;
+
+  u32 kernel_threads = device_param->kernel_threads_by_wgs_kernel_pws_unpack;
+
+  u32 num_elements = num;
+
+  while (num_elements % kernel_threads) num_elements++;
+
+  cl_kernel kernel = device_param->kernel_pws_unpack;
+
+  int CL_rc;
+
+  CL_rc = hc_clSetKernelArg (hashcat_ctx, kernel, 0, sizeof (cl_mem),  (void *) &device_param->d_pws_packed); if (CL_rc == -1) return -1;
+  CL_rc = hc_clSetKernelArg (hashcat_ctx, kernel, 1, sizeof (cl_mem),  (void *) &device_param->d_pws_buf);    if (CL_rc == -1) return -1;
+  CL_rc = hc_clSetKernelArg (hashcat_ctx, kernel, 2, sizeof (cl_uint), (void *) &stride);                     if (CL_rc == -1) return -1;
+  CL_rc = hc_clSetKernelArg (hashcat_ctx, kernel, 3, sizeof (cl_uint), (void *) &gid_max);                    if (CL_rc == -1) return -1;
+
+  const size_t global_work_size[3] = { num_elements,   1, 1 };
+  const size_t local_work_size[3]  = { kernel_threads, 1, 1 };
+
+  // the kernels queue up behind us. with --mm-pipeline the next upload into d_pws_packed runs on the copy queue, it waits for our event
+
+  cl_event *event = NULL;
+
+  if (device_param->command_queue_copy != NULL)
+  {
+    if (device_param->pws_unpack_event != NULL)
+    {
+      CL_rc = hc_clReleaseEvent (hashcat_ctx, device_param->pws_unpack_event);
+
+      if (CL_rc == -1) return -1;
+
+      device_param->pws_unpack_event = NULL;
+    }
+
+    event = &device_param->pws_unpack_event;
+  }
+
+  CL_rc = hc_clEnqueueNDRangeKernel (hashcat_ctx, device_param->command_queue, kernel, 1, NULL, global_work_size, local_work_size, 0, NULL, event);
+
+  if (CL_rc == -1) return -1;
+
+  CL_rc = hc_clFlush (hashcat_ctx, device_param->command_queue);
+
+  if (CL_rc == -1) return -1;
+
+  return 0;
+}
+
 int run_copy (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt)
 {
   combinator_ctx_t     *combinator_ctx      = hashcat_ctx->combinator_ctx;
@@ -1713,9 +1883,22 @@ int run_copy (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const
   {
     int CL_rc;
 
-    CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_pws_buf, CL_TRUE, 0, pws_cnt * sizeof (pw_t), device_param->pws_buf, 0, NULL, NULL);
+    if (device_param->pws_stride)
+    {
+      CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_pws_packed, CL_TRUE, 0, pws_cnt * device_param->pws_stride * sizeof (u32), device_param->pws_buf, 0, NULL, NULL);
 
-    if (CL_rc == -1) return -1;
+      if (CL_rc == -1) return -1;
+
+      CL_rc = run_kernel_pws_unpack (hashcat_ctx, device_param, pws_cnt);
+
+      if (CL_rc == -1) return -1;
+    }
+    else
+    {
+      CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_pws_buf, CL_TRUE, 0, pws_cnt * sizeof (pw_t), device_param->pws_buf, 0, NULL, NULL);
+
+      if (CL_rc == -1) return -1;
+    }
   }
   else if (user_options_extra->attack_kern == ATTACK_KERN_COMBI)
   {
@@ -1795,6 +1978,105 @@ int run_copy (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const
   return 0;
 }
 
+/// --mm-pipeline: start the upload of pws_buf_next, it runs on its own queue while the kernels work on d_pws_buf.
+/// packed candidates go to d_pws_packed, it was expanded into d_pws_buf already
+int run_copy_next (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt)
+{
+  int CL_rc;
+
+  if (device_param->pws_stride)
+  {
+    // the last unpack may still read d_pws_packed
+
+    const cl_uint wait_cnt = (device_param->pws_unpack_event != NULL) ? 1 : 0;
+
+    CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue_copy, device_param->d_pws_packed, CL_FALSE, 0, pws_cnt * device_param->pws_stride * sizeof (u32), device_param->pws_buf_next, wait_cnt, (wait_cnt) ? &device_param->pws_unpack_event : NULL, &device_param->pws_event);
+
+    if (CL_rc == -1) return -1;
+
+    if (wait_cnt)
+    {
+      CL_rc = hc_clReleaseEvent (hashcat_ctx, device_param->pws_unpack_event);
+
+      if (CL_rc == -1) return -1;
+
+      device_param->pws_unpack_event = NULL;
+    }
+  }
+  else
+  {
+    CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue_copy, device_param->d_pws_buf_next, CL_FALSE, 0, pws_cnt * sizeof (pw_t), device_param->pws_buf_next, 0, NULL, &device_param->pws_event);
+  }
+
+  if (CL_rc == -1) return -1;
+
+  CL_rc = hc_clFlush (hashcat_ctx, device_param->command_queue_copy);
+
+  if (CL_rc == -1) return -1;
+
+  return 0;
+}
+
+/// --mm-pipeline: wait for the upload of run_copy_next() and let the kernels use it from now on
+int run_copy_swap (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt)
+{
+  hashconfig_t *hashconfig = hashcat_ctx->hashconfig;
+
+  int CL_rc;
+
+  if (device_param->pws_event != NULL)
+  {
+    CL_rc = hc_clWaitForEvents (hashcat_ctx, 1, &device_param->pws_event);
+
+    if (CL_rc == -1) return -1;
+
+    CL_rc = hc_clReleaseEvent (hashcat_ctx, device_param->pws_event);
+
+    if (CL_rc == -1) return -1;
+
+    device_param->pws_event = NULL;
+  }
+
+  pw_t *pws_buf = device_param->pws_buf;
+
+  device_param->pws_buf      = device_param->pws_buf_next;
+  device_param->pws_buf_next = pws_buf;
+
+  cl_mem h_pws_buf = device_param->h_pws_buf;
+
+  device_param->h_pws_buf      = device_param->h_pws_buf_next;
+  device_param->h_pws_buf_next = h_pws_buf;
+
+  // the kernels of the last batch are done, expand right into their d_pws_buf
+
+  if (device_param->pws_stride)
+  {
+    if (pws_cnt == 0) return 0;
+
+    return run_kernel_pws_unpack (hashcat_ctx, device_param, pws_cnt);
+  }
+
+  cl_mem d_pws_buf = device_param->d_pws_buf;
+
+  device_param->d_pws_buf      = device_param->d_pws_buf_next;
+  device_param->d_pws_buf_next = d_pws_buf;
+
+  // the kernels got their buffers once at session start, tell them about the swap
+
+  if (hashconfig->attack_exec == ATTACK_EXEC_INSIDE_KERNEL)
+  {
+    CL_rc = hc_clSetKernelArg (hashcat_ctx, device_param->kernel1, 0, sizeof (cl_mem), &device_param->d_pws_buf); if (CL_rc == -1) return -1;
+    CL_rc = hc_clSetKernelArg (hashcat_ctx, device_param->kernel2, 0, sizeof (cl_mem), &device_param->d_pws_buf); if (CL_rc == -1) return -1;
+    CL_rc = hc_clSetKernelArg (hashcat_ctx, device_param->kernel3, 0, sizeof (cl_mem), &device_param->d_pws_buf); if (CL_rc == -1) return -1;
+  }
+  else
+  {
+    CL_rc = hc_clSetKernelArg (hashcat_ctx, device_param->kernel_amp, 0, sizeof (cl_mem), &device_param->d_pws_buf); if (CL_rc == -1) return -1;
+  }
+
+  return 0;
+}
+
 int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, const u32 pws_cnt)
 {
   combinator_ctx_t      *combinator_ctx     = hashcat_ctx->combinator_ctx;
@@ -1822,6 +2104,17 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
   }
   #endif
 
+  // other MPI ranks cracked something, don't let the kernel report it again
+
+  if (device_param->digests_shown_dirty == true)
+  {
+    device_param->digests_shown_dirty = false;
+
+    const int CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_digests_shown, CL_TRUE, 0, device_param->size_shown, hashes->digests_shown, 0, NULL, NULL);
+
+    if (CL_rc == -1) return -1;
+  }
+
   // find higest password length, this is for optimization stuff
 
   u32 highest_pw_len = 0;
@@ -1843,6 +2136,31 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
   device_param->outerloop_pos  = 0;
   device_param->outerloop_left = pws_cnt;
 
+  // with a single inner loop all salts see the same amplifiers, collect their cracks once per batch.
+  // plain_t has the salt_pos, only build_plain() needs innerloop_pos to stay put
+
+  u32 check_step = 0;
+  u32 check_cnt  = 0;
+
+  if   (hashconfig->attack_exec == ATTACK_EXEC_INSIDE_KERNEL) check_step = device_param->kernel_loops;
+  else                                                        check_step = 1;
+
+  if      (user_options_extra->attack_kern == ATTACK_KERN_STRAIGHT)  check_cnt = straight_ctx->kernel_rules_cnt;
+  else if (user_options_extra->attack_kern == ATTACK_KERN_COMBI)     check_cnt = combinator_ctx->combs_cnt;
+  else if (user_options_extra->attack_kern == ATTACK_KERN_BF)        check_cnt = mask_ctx->bfs_cnt;
+
+  const bool check_batch = ((hashconfig->opts_type & OPTS_TYPE_PT_NEVERCRACK) == 0) && (check_cnt <= check_step);
+
+  // --mm-salt-batch: nothing reads the results before the end of the batch, don't wait for each salt either.
+  // straight only, the other attacks generate their amplifiers per salt with blocking calls anyway
+
+  device_param->kernel_defer = (user_options->mm_salt_batch == true)
+                            && (check_batch == true)
+                            && (hashes->salts_cnt > 1)
+                            && (user_options->speed_only == false)
+                            && (user_options->attack_mode == ATTACK_MODE_STRAIGHT)
+                            && (hashconfig->hash_mode != 2000);
+
   // loop start: most outer loop = salt iteration, then innerloops (if multi)
 
   for (u32 salt_pos = 0; salt_pos < hashes->salts_cnt; salt_pos++)
@@ -1921,9 +2239,22 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
 
         while (i < innerloop_left)
         {
-          if (feof (combs_fp)) break;
+          // the amplifier dict is made of fixed-width records, padded with zeros, or of plain lines
+
+          int line_len = 0;
+
+          if (combinator_ctx->combs_width > 0)
+          {
+            if (fread (line_buf, 1, (size_t) combinator_ctx->combs_width, combs_fp) != (size_t) combinator_ctx->combs_width) break;
+
+            line_len = (int) strnlen (line_buf, (size_t) combinator_ctx->combs_width);
+          }
+          else
+          {
+            if (feof (combs_fp) || ferror (combs_fp)) break;
 
-          int line_len = fgetl (combs_fp, line_buf);
+            line_len = fgetl (combs_fp, line_buf);
+          }
 
           if (line_len >= PW_MAX1) continue;
 
@@ -1982,6 +2313,18 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
           i++;
         }
 
+        /// a broken block of a compressed amplifier dict, the rest of this batch was never read
+        if (ferror (combs_fp))
+        {
+          const char *dict = (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT) ? combinator_ctx->dict2 : combinator_ctx->dict1;
+
+          event_log_error (hashcat_ctx, "%s: Read error, stopping the attack.", dict);
+
+          myabort (hashcat_ctx);
+
+          return -1;
+        }
+
         for (u32 j = i; j < innerloop_left; j++)
         {
           device_param->combs_buf[j].i[0] = 0;
@@ -2010,7 +2353,7 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
       }
       else if (user_options->attack_mode == ATTACK_MODE_HYBRID1)
       {
-        u64 off = innerloop_pos;
+        u64 off = combinator_ctx->combs_off + innerloop_pos;
 
         device_param->kernel_params_mp_buf64[3] = off;
 
@@ -2020,7 +2363,7 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
       }
       else if (user_options->attack_mode == ATTACK_MODE_HYBRID2)
       {
-        u64 off = innerloop_pos;
+        u64 off = combinator_ctx->combs_off + innerloop_pos;
 
         device_param->kernel_params_mp_buf64[3] = off;
 
@@ -2033,7 +2376,7 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
 
       if (user_options->attack_mode == ATTACK_MODE_STRAIGHT)
       {
-        int CL_rc = hc_clEnqueueCopyBuffer (hashcat_ctx, device_param->command_queue, device_param->d_rules, device_param->d_rules_c, innerloop_pos * sizeof (kernel_rule_t), 0, innerloop_left * sizeof (kernel_rule_t), 0, NULL, NULL);
+        int CL_rc = hc_clEnqueueCopyBuffer (hashcat_ctx, device_param->command_queue, device_param->d_rules, device_param->d_rules_c, (straight_ctx->kernel_rules_off + innerloop_pos) * sizeof (kernel_rule_t), 0, innerloop_left * sizeof (kernel_rule_t), 0, NULL, NULL);
 
         if (CL_rc == -1) return -1;
       }
@@ -2121,7 +2464,7 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
        * result
        */
 
-      check_cracked (hashcat_ctx, device_param, salt_pos);
+      if (check_batch == false) check_cracked (hashcat_ctx, device_param, salt_pos);
 
       if (status_ctx->run_thread_level2 == false) break;
     }
@@ -2142,6 +2485,26 @@ int run_cracker (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, co
     if (status_ctx->run_thread_level2 == false) break;
   }
 
+  /**
+   * result, all salts at once
+   */
+
+  if (device_param->kernel_defer == true)
+  {
+    device_param->kernel_defer = false;
+
+    const int CL_rc = hc_clFinish (hashcat_ctx, device_param->command_queue);
+
+    if (CL_rc == -1) return -1;
+  }
+
+  if ((check_batch == true) && (user_options->speed_only == false))
+  {
+    const int rc_check = check_cracked (hashcat_ctx, device_param, 0);
+
+    if (rc_check == -1) return -1;
+  }
+
   //status screen makes use of this, can't reset here
   //device_param->outerloop_pos  = 0;
   //device_param->outerloop_left = 0;
@@ -2935,9 +3298,9 @@ int opencl_ctx_devices_init (hashcat_ctx_t *hashcat_ctx, const int comptime)
       char *device_name_chksum = (char *) hcmalloc (HCBUFSIZ_TINY);
 
       #if defined (__x86_64__)
-      const size_t dnclen = snprintf (device_name_chksum, HCBUFSIZ_TINY - 1, "%d-%u-%u-%s-%s-%s-%d-%u-%u", 64, device_param->platform_vendor_id, device_param->vector_width, device_param->device_name, device_param->device_version, device_param->driver_version, comptime, user_options->opencl_vector_width, user_options->hash_mode);
+      const size_t dnclen = snprintf (device_name_chksum, HCBUFSIZ_TINY - 1, "%d-%u-%u-%s-%s-%s-%d-%u-%u-%d", 64, device_param->platform_vendor_id, device_param->vector_width, device_param->device_name, device_param->device_version, device_param->driver_version, comptime, user_options->opencl_vector_width, user_options->hash_mode, MM_KERNEL_VERSION);
       #else
-      const size_t dnclen = snprintf (device_name_chksum, HCBUFSIZ_TINY - 1, "%d-%u-%u-%s-%s-%s-%d-%u-%u", 32, device_param->platform_vendor_id, device_param->vector_width, device_param->device_name, device_param->device_version, device_param->driver_version, comptime, user_options->opencl_vector_width, user_options->hash_mode);
+      const size_t dnclen = snprintf (device_name_chksum, HCBUFSIZ_TINY - 1, "%d-%u-%u-%s-%s-%s-%d-%u-%u-%d", 32, device_param->platform_vendor_id, device_param->vector_width, device_param->device_name, device_param->device_version, device_param->driver_version, comptime, user_options->opencl_vector_width, user_options->hash_mode, MM_KERNEL_VERSION);
       #endif
 
       u32 device_name_digest[4] = { 0 };
@@ -3632,7 +3995,7 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
     device_param->size_root_css   = size_root_css;
     device_param->size_markov_css = size_markov_css;
 
-    size_t size_results = sizeof (u32);
+    size_t size_results = 2 * sizeof (u32); // cracked count and the size of d_plain_bufs, see mark_hash()
 
     device_param->size_results = size_results;
 
@@ -4031,6 +4394,8 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
 
       generate_cached_kernel_filename (hashconfig->attack_exec, user_options_extra->attack_kern, hashconfig->kern_type, folder_config->profile_dir, device_name_chksum, cached_file);
 
+      mm_kernel_cache_add (hashcat_ctx, cached_file);
+
       bool cached = true;
 
       if (hc_path_read (cached_file) == false)
@@ -4234,6 +4599,8 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
 
       generate_cached_kernel_mp_filename (hashconfig->opti_type, hashconfig->opts_type, folder_config->profile_dir, device_name_chksum, cached_file);
 
+      mm_kernel_cache_add (hashcat_ctx, cached_file);
+
       bool cached = true;
 
       if (hc_path_read (cached_file) == false)
@@ -4375,6 +4742,8 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
 
       generate_cached_kernel_amp_filename (user_options_extra->attack_kern, folder_config->profile_dir, device_name_chksum, cached_file);
 
+      mm_kernel_cache_add (hashcat_ctx, cached_file);
+
       bool cached = true;
 
       if (hc_path_read (cached_file) == false)
@@ -4582,17 +4951,72 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
      * main host data
      */
 
-    pw_t *pws_buf = (pw_t *) hcmalloc (size_pws);
+    /// --mm-pinned: the buffers the candidates, the hooks and the cracks go through live in pinned memory
+
+    const bool pinned = user_options->mm_pinned;
+
+    if (pinned == true)
+    {
+      CL_rc = pinned_alloc (hashcat_ctx, device_param, size_pws, &device_param->h_pws_buf, (void **) &device_param->pws_buf);
+
+      if (CL_rc == -1) return -1;
+
+      CL_rc = pinned_alloc (hashcat_ctx, device_param, size_plains, &device_param->h_plain_bufs, (void **) &device_param->plain_bufs);
+
+      if (CL_rc == -1) return -1;
+    }
+    else
+    {
+      device_param->pws_buf = (pw_t *) hcmalloc (size_pws);
+    }
+
+    /// --mm-pipeline: a second pair of buffers and a queue of its own for the uploads
+
+    if ((user_options->mm_pipeline == true) && (user_options->attack_mode == ATTACK_MODE_STRAIGHT))
+    {
+      if (pinned == true)
+      {
+        CL_rc = pinned_alloc (hashcat_ctx, device_param, size_pws, &device_param->h_pws_buf_next, (void **) &device_param->pws_buf_next);
+
+        if (CL_rc == -1) return -1;
+      }
+      else
+      {
+        device_param->pws_buf_next = (pw_t *) hcmalloc (size_pws);
+      }
+
+      CL_rc = hc_clCreateBuffer (hashcat_ctx, device_param->context, CL_MEM_READ_ONLY, size_pws, NULL, &device_param->d_pws_buf_next);
+
+      if (CL_rc == -1) return -1;
+
+      CL_rc = hc_clCreateCommandQueue (hashcat_ctx, device_param->context, device_param->device, 0, &device_param->command_queue_copy);
+
+      if (CL_rc == -1) return -1;
+    }
 
-    device_param->pws_buf = pws_buf;
+    /// --mm-pack-pws: the packed candidates land here and get expanded into d_pws_buf
+
+    if ((user_options->mm_pack_pws == true) && (user_options->attack_mode == ATTACK_MODE_STRAIGHT))
+    {
+      CL_rc = hc_clCreateBuffer (hashcat_ctx, device_param->context, CL_MEM_READ_ONLY, size_pws, NULL, &device_param->d_pws_packed);
+
+      if (CL_rc == -1) return -1;
+    }
 
     comb_t *combs_buf = (comb_t *) hccalloc (KERNEL_COMBS, sizeof (comb_t));
 
     device_param->combs_buf = combs_buf;
 
-    void *hooks_buf = hcmalloc (size_hooks);
+    if (pinned == true)
+    {
+      CL_rc = pinned_alloc (hashcat_ctx, device_param, size_hooks, &device_param->h_hooks, &device_param->hooks_buf);
 
-    device_param->hooks_buf = hooks_buf;
+      if (CL_rc == -1) return -1;
+    }
+    else
+    {
+      device_param->hooks_buf = hcmalloc (size_hooks);
+    }
 
     /**
      * kernel args
@@ -4930,6 +5354,19 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
     CL_rc = hc_clSetKernelArg (hashcat_ctx, device_param->kernel_memset, 1, sizeof (cl_uint), device_param->kernel_params_memset[1]); if (CL_rc == -1) return -1;
     CL_rc = hc_clSetKernelArg (hashcat_ctx, device_param->kernel_memset, 2, sizeof (cl_uint), device_param->kernel_params_memset[2]); if (CL_rc == -1) return -1;
 
+    // GPU pws unpack, --mm-pack-pws
+
+    if (device_param->d_pws_packed)
+    {
+      CL_rc = hc_clCreateKernel (hashcat_ctx, device_param->program, "gpu_pws_unpack", &device_param->kernel_pws_unpack);
+
+      if (CL_rc == -1) return -1;
+
+      CL_rc = get_kernel_threads (hashcat_ctx, device_param, device_param->kernel_pws_unpack, &device_param->kernel_threads_by_wgs_kernel_pws_unpack);
+
+      if (CL_rc == -1) return -1;
+    }
+
     // MP start
 
     if (user_options->attack_mode == ATTACK_MODE_BF)
@@ -5026,6 +5463,10 @@ int opencl_session_begin (hashcat_ctx_t *hashcat_ctx)
     CL_rc = run_kernel_bzero (hashcat_ctx, device_param, device_param->d_plain_bufs,  size_plains);   if (CL_rc == -1) return -1;
     CL_rc = run_kernel_bzero (hashcat_ctx, device_param, device_param->d_result,      size_results);  if (CL_rc == -1) return -1;
 
+    const u32 plains_cnt = hashes->digests_cnt;
+
+    CL_rc = hc_clEnqueueWriteBuffer (hashcat_ctx, device_param->command_queue, device_param->d_result, CL_TRUE, sizeof (u32), sizeof (u32), &plains_cnt, 0, NULL, NULL); if (CL_rc == -1) return -1;
+
     /**
      * special buffers
      */
@@ -5137,11 +5578,20 @@ void opencl_session_destroy (hashcat_ctx_t *hashcat_ctx)
 
     if (device_param->skipped == true) continue;
 
-    hcfree (device_param->pws_buf);
+    if (device_param->h_pws_buf)      pinned_free (hashcat_ctx, device_param, device_param->h_pws_buf,      device_param->pws_buf);
+    else                              hcfree (device_param->pws_buf);
+    if (device_param->h_pws_buf_next) pinned_free (hashcat_ctx, device_param, device_param->h_pws_buf_next, device_param->pws_buf_next);
+    else                              hcfree (device_param->pws_buf_next);
+    if (device_param->h_hooks)        pinned_free (hashcat_ctx, device_param, device_param->h_hooks,        device_param->hooks_buf);
+    else                              hcfree (device_param->hooks_buf);
+
+    pinned_free (hashcat_ctx, device_param, device_param->h_plain_bufs, device_param->plain_bufs);
+
     hcfree (device_param->combs_buf);
-    hcfree (device_param->hooks_buf);
 
     if (device_param->d_pws_buf)        hc_clReleaseMemObject (hashcat_ctx, device_param->d_pws_buf);
+    if (device_param->d_pws_buf_next)   hc_clReleaseMemObject (hashcat_ctx, device_param->d_pws_buf_next);
+    if (device_param->d_pws_packed)     hc_clReleaseMemObject (hashcat_ctx, device_param->d_pws_packed);
     if (device_param->d_pws_amp_buf)    hc_clReleaseMemObject (hashcat_ctx, device_param->d_pws_amp_buf);
     if (device_param->d_rules)          hc_clReleaseMemObject (hashcat_ctx, device_param->d_rules);
     if (device_param->d_rules_c)        hc_clReleaseMemObject (hashcat_ctx, device_param->d_rules_c);
@@ -5186,20 +5636,34 @@ void opencl_session_destroy (hashcat_ctx_t *hashcat_ctx)
     if (device_param->kernel_tm)        hc_clReleaseKernel (hashcat_ctx, device_param->kernel_tm);
     if (device_param->kernel_amp)       hc_clReleaseKernel (hashcat_ctx, device_param->kernel_amp);
     if (device_param->kernel_memset)    hc_clReleaseKernel (hashcat_ctx, device_param->kernel_memset);
+    if (device_param->kernel_pws_unpack) hc_clReleaseKernel (hashcat_ctx, device_param->kernel_pws_unpack);
 
     if (device_param->program)          hc_clReleaseProgram (hashcat_ctx, device_param->program);
     if (device_param->program_mp)       hc_clReleaseProgram (hashcat_ctx, device_param->program_mp);
     if (device_param->program_amp)      hc_clReleaseProgram (hashcat_ctx, device_param->program_amp);
 
-    if (device_param->command_queue)    hc_clReleaseCommandQueue (hashcat_ctx, device_param->command_queue);
+    if (device_param->pws_event)          hc_clReleaseEvent (hashcat_ctx, device_param->pws_event);
+    if (device_param->pws_unpack_event)   hc_clReleaseEvent (hashcat_ctx, device_param->pws_unpack_event);
+
+    if (device_param->command_queue_copy) hc_clReleaseCommandQueue (hashcat_ctx, device_param->command_queue_copy);
+    if (device_param->command_queue)      hc_clReleaseCommandQueue (hashcat_ctx, device_param->command_queue);
 
     if (device_param->context)          hc_clReleaseContext (hashcat_ctx, device_param->context);
 
     device_param->pws_buf           = NULL;
+    device_param->pws_buf_next      = NULL;
     device_param->combs_buf         = NULL;
     device_param->hooks_buf         = NULL;
+    device_param->plain_bufs        = NULL;
+
+    device_param->h_pws_buf         = NULL;
+    device_param->h_pws_buf_next    = NULL;
+    device_param->h_hooks           = NULL;
+    device_param->h_plain_bufs      = NULL;
 
     device_param->d_pws_buf         = NULL;
+    device_param->d_pws_buf_next    = NULL;
+    device_param->d_pws_packed      = NULL;
     device_param->d_pws_amp_buf     = NULL;
     device_param->d_rules           = NULL;
     device_param->d_rules_c         = NULL;
@@ -5243,10 +5707,14 @@ void opencl_session_destroy (hashcat_ctx_t *hashcat_ctx)
     device_param->kernel_tm         = NULL;
     device_param->kernel_amp        = NULL;
     device_param->kernel_memset     = NULL;
+    device_param->kernel_pws_unpack = NULL;
     device_param->program           = NULL;
     device_param->program_mp        = NULL;
     device_param->program_amp       = NULL;
     device_param->command_queue     = NULL;
+    device_param->command_queue_copy = NULL;
+    device_param->pws_event         = NULL;
+    device_param->pws_unpack_event  = NULL;
     device_param->context           = NULL;
   }
 }
@@ -5281,6 +5749,8 @@ void opencl_session_reset (hashcat_ctx_t *hashcat_ctx)
 
     if (device_param->pws_buf) memset (device_param->pws_buf, 0, device_param->size_pws);
 
+    if (device_param->pws_buf_next) memset (device_param->pws_buf_next, 0, device_param->size_pws);
+
     device_param->pws_cnt = 0;
 
     device_param->words_off  = 0;
@@ -49,7 +49,7 @@ int build_plain (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param, pl
 
     plain_len = (int) pw.pw_len;
 
-    const u32 off = device_param->innerloop_pos + il_pos;
+    const u32 off = straight_ctx->kernel_rules_off + device_param->innerloop_pos + il_pos;
 
     plain_len = (int) apply_rules (straight_ctx->kernel_rules_buf[off].cmds, &plain_buf[0], &plain_buf[4], (u32) plain_len);
 
@@ -269,7 +269,7 @@ int build_debugdata (hashcat_ctx_t *hashcat_ctx, hc_device_param_t *device_param
 
   int plain_len = (int) pw.pw_len;
 
-  const u32 off = device_param->innerloop_pos + il_pos;
+  const u32 off = straight_ctx->kernel_rules_off + device_param->innerloop_pos + il_pos;
 
   // save rule
   if ((debug_mode == 1) || (debug_mode == 3) || (debug_mode == 4))
@@ -16,6 +16,7 @@
 #include "potfile.h"
 #include "locking.h"
 #include "shared.h"
+#include "mm_impl.h"
 
 // get rid of this later
 int sort_by_hash         (const void *v1, const void *v2, void *v3);
@@ -122,6 +123,17 @@ int potfile_init (hashcat_ctx_t *hashcat_ctx)
 
   potfile_ctx->tmp_buf = tmp_buf;
 
+  // rank-local shards instead of every rank appending to the same file
+
+  potfile_ctx->shards = user_options->mm_potfile_shards;
+
+  if (potfile_ctx->shards == true)
+  {
+    hc_asprintf (&potfile_ctx->shard_filename, "%s.%d", potfile_ctx->filename, hashcat_ctx->cur_proc_id);
+
+    potfile_ctx->shard_off = (long *) hccalloc (hashcat_ctx->total_proc_cnt, sizeof (long));
+  }
+
   // old potfile detection
 
   if (user_options->potfile_path == NULL)
@@ -152,6 +164,12 @@ void potfile_destroy (hashcat_ctx_t *hashcat_ctx)
   hcfree (potfile_ctx->out_buf);
   hcfree (potfile_ctx->tmp_buf);
 
+  hcfree (potfile_ctx->shard_filename);
+  hcfree (potfile_ctx->shard_buf);
+  hcfree (potfile_ctx->shard_off);
+  hcfree (potfile_ctx->merged);
+  hcfree (potfile_ctx->merged_off);
+
   memset (potfile_ctx, 0, sizeof (potfile_ctx_t));
 }
 
@@ -190,11 +208,14 @@ int potfile_write_open (hashcat_ctx_t *hashcat_ctx)
 
   if (potfile_ctx->enabled == false) return 0;
 
-  FILE *fp = fopen (potfile_ctx->filename, "ab");
+  /// with shards only potfile_shard_merge() writes to filename
+  const char *filename = (potfile_ctx->shards == true) ? potfile_ctx->shard_filename : potfile_ctx->filename;
+
+  FILE *fp = fopen (filename, "ab");
 
   if (fp == NULL)
   {
-    event_log_error (hashcat_ctx, "%s: %s", potfile_ctx->filename, strerror (errno));
+    event_log_error (hashcat_ctx, "%s: %s", filename, strerror (errno));
 
     return -1;
   }
@@ -210,13 +231,15 @@ void potfile_write_close (hashcat_ctx_t *hashcat_ctx)
 
   if (potfile_ctx->enabled == false) return;
 
+  if (potfile_ctx->shards == true) potfile_shard_flush (hashcat_ctx);
+
   fclose (potfile_ctx->fp);
 }
 
 void potfile_write_append (hashcat_ctx_t *hashcat_ctx, const char *out_buf, u8 *plain_ptr, unsigned int plain_len)
 {
   const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
-  const potfile_ctx_t  *potfile_ctx  = hashcat_ctx->potfile_ctx;
+  potfile_ctx_t        *potfile_ctx  = hashcat_ctx->potfile_ctx;
   const user_options_t *user_options = hashcat_ctx->user_options;
 
   if (potfile_ctx->enabled == false) return;
@@ -266,6 +289,30 @@ void potfile_write_append (hashcat_ctx_t *hashcat_ctx, const char *out_buf, u8 *
 
   tmp_buf[tmp_len] = 0;
 
+  /// the monitor writes the buffer to the shard once per second, no file lock per crack
+  if (potfile_ctx->shards == true)
+  {
+    const size_t rec_len = tmp_len + strlen (EOL);
+
+    if ((potfile_ctx->shard_len + rec_len) > potfile_ctx->shard_avail)
+    {
+      const size_t add_len = MAX (rec_len, POTFILE_SHARD_BUF);
+
+      potfile_ctx->shard_buf = (char *) hcrealloc (potfile_ctx->shard_buf, potfile_ctx->shard_avail, add_len);
+
+      potfile_ctx->shard_avail += add_len;
+    }
+
+    memcpy (potfile_ctx->shard_buf + potfile_ctx->shard_len, tmp_buf, tmp_len);
+    memcpy (potfile_ctx->shard_buf + potfile_ctx->shard_len + tmp_len, EOL, strlen (EOL));
+
+    potfile_ctx->shard_len += rec_len;
+
+    if (potfile_ctx->shard_len >= POTFILE_SHARD_BUF) potfile_shard_flush (hashcat_ctx);
+
+    return;
+  }
+
   lock_file (potfile_ctx->fp);
 
   fprintf (potfile_ctx->fp, "%s" EOL, tmp_buf);
@@ -278,6 +325,401 @@ void potfile_write_append (hashcat_ctx_t *hashcat_ctx, const char *out_buf, u8 *
   }
 }
 
+/// write the buffered records to the rank-local shard, caller holds mux_display once the attack runs
+void potfile_shard_flush (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  if (potfile_ctx->enabled == false) return;
+
+  if (potfile_ctx->shards == false) return;
+
+  if (potfile_ctx->shard_len == 0) return;
+
+  if (potfile_ctx->fp == NULL) return;
+
+  lock_file (potfile_ctx->fp);
+
+  if (fwrite (potfile_ctx->shard_buf, 1, potfile_ctx->shard_len, potfile_ctx->fp) != potfile_ctx->shard_len)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", potfile_ctx->shard_filename, strerror (errno));
+  }
+
+  fflush (potfile_ctx->fp);
+
+  if (unlock_file (potfile_ctx->fp))
+  {
+    event_log_error (hashcat_ctx, "%s: Failed to unlock file.", potfile_ctx->shard_filename);
+  }
+
+  potfile_ctx->shard_len = 0;
+}
+
+/// FNV-1a, 0 marks an empty slot of the merged set
+static u64 potfile_line_hash (const char *line_buf, const size_t line_len)
+{
+  u64 h = 0xcbf29ce484222325;
+
+  for (size_t i = 0; i < line_len; i++)
+  {
+    h ^= (u8) line_buf[i];
+    h *= 0x100000001b3;
+  }
+
+  return (h == 0) ? 1 : h;
+}
+
+/// true if the line of filename at off is line_buf and nothing more. a read error makes it a different line,
+/// the worst that does is a duplicate in the potfile
+static bool potfile_merged_equal (potfile_ctx_t *potfile_ctx, const u64 off, const char *line_buf, const size_t line_len)
+{
+  FILE *fp = potfile_ctx->merged_fp;
+
+  potfile_ctx->merged_seek = true;
+
+  if (fseek (fp, (long) off, SEEK_SET) != 0) return false;
+
+  char buf[0x1000];
+
+  for (size_t done = 0; done < line_len; )
+  {
+    const size_t len = MIN (sizeof (buf), line_len - done);
+
+    if (fread (buf, 1, len, fp) != len) return false;
+
+    if (memcmp (buf, line_buf + done, len) != 0) return false;
+
+    done += len;
+  }
+
+  const int c = fgetc (fp);
+
+  return (c == EOF) || (c == '\n') || (c == '\r');
+}
+
+/// returns true if the line was not in the set yet and is now, as the line at off of filename. a matching hash is
+/// confirmed against the line on disk, only a byte-equal line (same hash, same plain) counts as a duplicate
+static bool potfile_merged_insert (potfile_ctx_t *potfile_ctx, const char *line_buf, const size_t line_len, const u64 off)
+{
+  if (((potfile_ctx->merged_cnt + 1) * 2) > potfile_ctx->merged_avail)
+  {
+    const u64 old_avail = potfile_ctx->merged_avail;
+    u64      *old_set   = potfile_ctx->merged;
+    u64      *old_off   = potfile_ctx->merged_off;
+
+    potfile_ctx->merged_avail = (old_avail == 0) ? POTFILE_SHARD_SET : old_avail * 2;
+    potfile_ctx->merged       = (u64 *) hccalloc (potfile_ctx->merged_avail, sizeof (u64));
+    potfile_ctx->merged_off   = (u64 *) hccalloc (potfile_ctx->merged_avail, sizeof (u64));
+
+    for (u64 i = 0; i < old_avail; i++)
+    {
+      if (old_set[i] == 0) continue;
+
+      u64 slot = old_set[i] & (potfile_ctx->merged_avail - 1);
+
+      while (potfile_ctx->merged[slot] != 0) slot = (slot + 1) & (potfile_ctx->merged_avail - 1);
+
+      potfile_ctx->merged[slot]     = old_set[i];
+      potfile_ctx->merged_off[slot] = old_off[i];
+    }
+
+    hcfree (old_set);
+    hcfree (old_off);
+  }
+
+  const u64 h = potfile_line_hash (line_buf, line_len);
+
+  u64 slot = h & (potfile_ctx->merged_avail - 1);
+
+  while (potfile_ctx->merged[slot] != 0)
+  {
+    if ((potfile_ctx->merged[slot] == h) && (potfile_merged_equal (potfile_ctx, potfile_ctx->merged_off[slot], line_buf, line_len) == true)) return false;
+
+    slot = (slot + 1) & (potfile_ctx->merged_avail - 1);
+  }
+
+  potfile_ctx->merged[slot]     = h;
+  potfile_ctx->merged_off[slot] = off;
+
+  potfile_ctx->merged_cnt++;
+
+  return true;
+}
+
+/// rank 0: open filename for a merge, new lines are appended and the set reads the known ones back from it
+static int potfile_merged_open (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  FILE *fp = fopen (potfile_ctx->filename, "a+b");
+
+  if (fp == NULL)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", potfile_ctx->filename, strerror (errno));
+
+    return -1;
+  }
+
+  lock_file (fp);
+
+  fseek (fp, 0, SEEK_END);
+
+  potfile_ctx->merged_fp   = fp;
+  potfile_ctx->merged_end  = (u64) ftell (fp);
+  potfile_ctx->merged_seek = false;
+
+  return 0;
+}
+
+static int potfile_merged_close (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  FILE *fp = potfile_ctx->merged_fp;
+
+  const bool failed = (fflush (fp) != 0) || (ferror (fp) != 0);
+
+  if (unlock_file (fp))
+  {
+    event_log_error (hashcat_ctx, "%s: Failed to unlock file.", potfile_ctx->filename);
+  }
+
+  fclose (fp);
+
+  potfile_ctx->merged_fp = NULL;
+
+  if (failed == true)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", potfile_ctx->filename, strerror (errno));
+
+    return -1;
+  }
+
+  return 0;
+}
+
+/// (re)build the set from filename, merged_fp is open
+static void potfile_merged_load (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  hcfree (potfile_ctx->merged);
+  hcfree (potfile_ctx->merged_off);
+
+  potfile_ctx->merged        = NULL;
+  potfile_ctx->merged_off    = NULL;
+  potfile_ctx->merged_cnt    = 0;
+  potfile_ctx->merged_avail  = 0;
+  potfile_ctx->merged_loaded = true;
+
+  FILE *fp = fopen (potfile_ctx->filename, "rb");
+
+  if (fp == NULL) return;
+
+  char *line_buf = (char *) hcmalloc (HCBUFSIZ_LARGE);
+
+  while (!feof (fp))
+  {
+    const long off = ftell (fp);
+
+    const int line_len = fgetl (fp, line_buf);
+
+    if (line_len == 0) continue;
+
+    potfile_merged_insert (potfile_ctx, line_buf, (size_t) line_len, (u64) off);
+  }
+
+  hcfree (line_buf);
+
+  fclose (fp);
+}
+
+/// append the complete lines of a shard past *off which are not in the potfile yet to filename
+static void potfile_shard_collect (hashcat_ctx_t *hashcat_ctx, const char *shard_filename, long *off)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  FILE *fp = fopen (shard_filename, "rb");
+
+  if (fp == NULL) return;
+
+  fseek (fp, 0, SEEK_END);
+
+  const long end = ftell (fp);
+
+  if (end <= *off)
+  {
+    fclose (fp);
+
+    return;
+  }
+
+  fseek (fp, *off, SEEK_SET);
+
+  const size_t buf_len = (size_t) (end - *off);
+
+  char *buf = (char *) hcmalloc (buf_len);
+
+  const size_t nread = fread (buf, 1, buf_len, fp);
+
+  fclose (fp);
+
+  if (nread != buf_len)
+  {
+    event_log_warning (hashcat_ctx, "%s: Short read, merging again later.", shard_filename);
+  }
+
+  /// a record the owner is still writing stays for the next merge
+  size_t line_start = 0;
+
+  for (size_t i = 0; i < nread; i++)
+  {
+    if (buf[i] != '\n') continue;
+
+    size_t line_len = i - line_start;
+
+    if ((line_len > 0) && (buf[line_start + line_len - 1] == '\r')) line_len--;
+
+    if ((line_len > 0) && (potfile_merged_insert (potfile_ctx, buf + line_start, line_len, potfile_ctx->merged_end) == true))
+    {
+      /// a stream that was read from has to be positioned before it is written to again
+      if (potfile_ctx->merged_seek == true) fseek (potfile_ctx->merged_fp, 0, SEEK_END);
+
+      potfile_ctx->merged_seek = false;
+
+      fwrite (buf + line_start, 1, line_len, potfile_ctx->merged_fp);
+      fwrite (EOL, 1, strlen (EOL), potfile_ctx->merged_fp);
+
+      potfile_ctx->merged_end += line_len + strlen (EOL);
+    }
+
+    line_start = i + 1;
+  }
+
+  *off += (long) line_start;
+
+  hcfree (buf);
+}
+
+/// rank 0 only: move the new records of all shards into the potfile, duplicates are dropped
+int potfile_shard_merge (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  if (potfile_ctx->enabled == false) return 0;
+
+  if (potfile_ctx->shards == false) return 0;
+
+  if (hashcat_ctx->cur_proc_id != 0) return 0;
+
+  if (potfile_merged_open (hashcat_ctx) == -1) return -1;
+
+  if (potfile_ctx->merged_loaded == false) potfile_merged_load (hashcat_ctx);
+
+  for (int rank = 0; rank < hashcat_ctx->total_proc_cnt; rank++)
+  {
+    char *shard_filename;
+
+    hc_asprintf (&shard_filename, "%s.%d", potfile_ctx->filename, rank);
+
+    potfile_shard_collect (hashcat_ctx, shard_filename, &potfile_ctx->shard_off[rank]);
+
+    hcfree (shard_filename);
+  }
+
+  return potfile_merged_close (hashcat_ctx);
+}
+
+/// rank 0 only, before anybody opened a shard: learn what the potfile has, merge what an earlier session left in
+/// the shards (the stop may have come before the last merge) and truncate them
+int potfile_shard_prepare (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  if (potfile_ctx->enabled == false) return 0;
+
+  if (potfile_ctx->shards == false) return 0;
+
+  if (hashcat_ctx->cur_proc_id != 0) return 0;
+
+  if (potfile_merged_open (hashcat_ctx) == -1) return -1;
+
+  potfile_merged_load (hashcat_ctx);
+
+  /// the last session may have run with more ranks, their shards are numbered without gaps
+  for (int rank = 0; ; rank++)
+  {
+    char *shard_filename;
+
+    hc_asprintf (&shard_filename, "%s.%d", potfile_ctx->filename, rank);
+
+    if (hc_path_exist (shard_filename) == false)
+    {
+      hcfree (shard_filename);
+
+      if (rank >= hashcat_ctx->total_proc_cnt) break;
+
+      continue;
+    }
+
+    long off = 0;
+
+    potfile_shard_collect (hashcat_ctx, shard_filename, &off);
+
+    hcfree (shard_filename);
+  }
+
+  if (potfile_merged_close (hashcat_ctx) == -1) return -1;
+
+  for (int rank = 0; ; rank++)
+  {
+    char *shard_filename;
+
+    hc_asprintf (&shard_filename, "%s.%d", potfile_ctx->filename, rank);
+
+    const bool exist = hc_path_exist (shard_filename);
+
+    if (exist == true)
+    {
+      FILE *fp_shard = fopen (shard_filename, "wb");
+
+      if (fp_shard != NULL) fclose (fp_shard);
+    }
+
+    hcfree (shard_filename);
+
+    if (rank < hashcat_ctx->total_proc_cnt) potfile_ctx->shard_off[rank] = 0;
+    else if (exist == false) break;
+  }
+
+  return 0;
+}
+
+/// --mm-degraded renumbered the ranks, the next attack writes to the shard of our new rank. what rank 0 knew goes
+/// with the old numbering: a new rank 0 loads the set at its next merge and reads every shard from the start,
+/// the set drops what was merged already
+void potfile_shard_renumber (hashcat_ctx_t *hashcat_ctx)
+{
+  potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  if (potfile_ctx->shards == false) return;
+
+  hcfree (potfile_ctx->shard_filename);
+
+  hc_asprintf (&potfile_ctx->shard_filename, "%s.%d", potfile_ctx->filename, hashcat_ctx->cur_proc_id);
+
+  hcfree (potfile_ctx->merged);
+  hcfree (potfile_ctx->merged_off);
+
+  potfile_ctx->merged        = NULL;
+  potfile_ctx->merged_off    = NULL;
+  potfile_ctx->merged_cnt    = 0;
+  potfile_ctx->merged_avail  = 0;
+  potfile_ctx->merged_loaded = false;
+
+  for (int rank = 0; rank < hashcat_ctx->total_proc_cnt; rank++) potfile_ctx->shard_off[rank] = 0;
+}
+
 void potfile_update_hash (hashcat_ctx_t *hashcat_ctx, hash_t *found, char *line_pw_buf, int line_pw_len)
 {
   const loopback_ctx_t *loopback_ctx = hashcat_ctx->loopback_ctx;
@@ -320,6 +762,18 @@ void potfile_update_hashes (hashcat_ctx_t *hashcat_ctx, hash_t *hash_buf, hash_t
 }
 
 int potfile_remove_parse (hashcat_ctx_t *hashcat_ctx)
+{
+  const potfile_ctx_t *potfile_ctx = hashcat_ctx->potfile_ctx;
+
+  if (potfile_ctx->enabled == false) return 0;
+
+  /// rank 0 reads the potfile for everybody
+  if (potfile_ctx->shards == true) return mm_potfile_remove_parse (hashcat_ctx);
+
+  return potfile_remove_parse_file (hashcat_ctx);
+}
+
+int potfile_remove_parse_file (hashcat_ctx_t *hashcat_ctx)
 {
   const hashconfig_t   *hashconfig   = hashcat_ctx->hashconfig;
   const hashes_t       *hashes       = hashcat_ctx->hashes;
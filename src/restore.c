@@ -10,6 +10,8 @@
 #include "user_options.h"
 #include "shared.h"
 #include "restore.h"
+#include "mm_impl.h"
+#include "mm_ckpt.h"
 
 #if defined (_WIN)
 static void fsync (int fd)
@@ -165,6 +167,14 @@ static int write_restore (hashcat_ctx_t *hashcat_ctx)
   rd->dicts_pos = straight_ctx->dicts_pos;
   rd->words_cur = status_ctx->words_cur;
 
+  /// the job restarts at its first unfinished epoch, the ranges file knows the rest
+  if (hashcat_ctx->mm_ctx->ckpt_write == true)
+  {
+    mm_ckpt_position (hashcat_ctx, &rd->masks_pos, &rd->dicts_pos);
+
+    rd->words_cur = 0;
+  }
+
   char *new_restore_file = restore_ctx->new_restore_file;
 
   FILE *fp = fopen (new_restore_file, "wb");
@@ -207,12 +217,128 @@ static int write_restore (hashcat_ctx_t *hashcat_ctx)
   return 0;
 }
 
+/// { version, epochs_cnt, ranges_cnt } followed by the ranges, sorted and merged
+static int write_restore_ranges (hashcat_ctx_t *hashcat_ctx)
+{
+  const mm_ctx_t      *mm_ctx      = hashcat_ctx->mm_ctx;
+  const restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
+
+  const char *eff_ranges_file = restore_ctx->eff_ranges_file;
+  const char *new_ranges_file = restore_ctx->new_ranges_file;
+
+  FILE *fp = fopen (new_ranges_file, "wb");
+
+  if (fp == NULL)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", new_ranges_file, strerror (errno));
+
+    return -1;
+  }
+
+  const u32 hdr[3] = { RESTORE_RANGES_VERSION, mm_ctx->epochs_cnt, mm_ctx->ckpt_set_cnt };
+
+  const size_t nwrite = fwrite (hdr, sizeof (hdr), 1, fp)
+                      + fwrite (mm_ctx->ckpt_set, sizeof (mm_range_t), mm_ctx->ckpt_set_cnt, fp);
+
+  fflush (fp);
+
+  fsync (fileno (fp));
+
+  fclose (fp);
+
+  if (nwrite != 1 + mm_ctx->ckpt_set_cnt)
+  {
+    event_log_error (hashcat_ctx, "Cannot write %s", new_ranges_file);
+
+    return -1;
+  }
+
+  /// rename() replaces the old file in one step, a crash leaves either the old or the new ranges
+  if (rename (new_ranges_file, eff_ranges_file) == -1)
+  {
+    event_log_warning (hashcat_ctx, "Rename file '%s' to '%s': %s", new_ranges_file, eff_ranges_file, strerror (errno));
+  }
+
+  return 0;
+}
+
+int read_restore_ranges (hashcat_ctx_t *hashcat_ctx)
+{
+  mm_ctx_t      *mm_ctx      = hashcat_ctx->mm_ctx;
+  restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
+
+  const char *eff_ranges_file = restore_ctx->eff_ranges_file;
+
+  /// the session was started without --mm-cluster-restore, everything is unfinished
+  if (hc_path_exist (eff_ranges_file) == false) return 0;
+
+  FILE *fp = fopen (eff_ranges_file, "rb");
+
+  if (fp == NULL)
+  {
+    event_log_error (hashcat_ctx, "%s: %s", eff_ranges_file, strerror (errno));
+
+    return -1;
+  }
+
+  u32 hdr[3] = { 0 };
+
+  if (fread (hdr, sizeof (hdr), 1, fp) != 1)
+  {
+    event_log_error (hashcat_ctx, "Cannot read %s", eff_ranges_file);
+
+    fclose (fp);
+
+    return -1;
+  }
+
+  if ((hdr[0] != RESTORE_RANGES_VERSION) || (hdr[1] != mm_ctx->epochs_cnt))
+  {
+    event_log_error (hashcat_ctx, "%s does not belong to this attack.", eff_ranges_file);
+
+    fclose (fp);
+
+    return -1;
+  }
+
+  mm_range_t *ranges = (mm_range_t *) hccalloc (MAX (1, hdr[2]), sizeof (mm_range_t));
+
+  if (fread (ranges, sizeof (mm_range_t), hdr[2], fp) != hdr[2])
+  {
+    event_log_error (hashcat_ctx, "Cannot read %s", eff_ranges_file);
+
+    hcfree (ranges);
+
+    fclose (fp);
+
+    return -1;
+  }
+
+  fclose (fp);
+
+  mm_ctx->ckpt_restored       = ranges;
+  mm_ctx->ckpt_restored_cnt   = hdr[2];
+  mm_ctx->ckpt_restored_avail = MAX (1, hdr[2]);
+
+  return 0;
+}
+
 int cycle_restore (hashcat_ctx_t *hashcat_ctx)
 {
   restore_ctx_t *restore_ctx = hashcat_ctx->restore_ctx;
 
   if (restore_ctx->enabled == false) return 0;
 
+  /// with --mm-cluster-restore rank 0 writes for the whole job, the ranges go first so the restore file never is ahead of them
+  if (hashcat_ctx->mm_ctx->ckpt_write == true)
+  {
+    if (hashcat_ctx->cur_proc_id != 0) return 0;
+
+    const int rc_write_ranges = write_restore_ranges (hashcat_ctx);
+
+    if (rc_write_ranges == -1) return -1;
+  }
+
   const char *eff_restore_file = restore_ctx->eff_restore_file;
   const char *new_restore_file = restore_ctx->new_restore_file;
 
@@ -243,16 +369,23 @@ void unlink_restore (hashcat_ctx_t *hashcat_ctx)
 
   if (restore_ctx->enabled == false) return;
 
+  /// the other ranks may still be done with their part only
+  if ((hashcat_ctx->mm_ctx->ckpt_write == true) && (hashcat_ctx->cur_proc_id != 0)) return;
+
   if ((status_ctx->devices_status == STATUS_EXHAUSTED) && (status_ctx->run_thread_level1 == true)) // this is to check for [c]heckpoint
   {
     unlink (restore_ctx->eff_restore_file);
     unlink (restore_ctx->new_restore_file);
+    unlink (restore_ctx->eff_ranges_file);
+    unlink (restore_ctx->new_ranges_file);
   }
 
   if (status_ctx->devices_status == STATUS_CRACKED)
   {
     unlink (restore_ctx->eff_restore_file);
     unlink (restore_ctx->new_restore_file);
+    unlink (restore_ctx->eff_ranges_file);
+    unlink (restore_ctx->new_ranges_file);
   }
 }
 
@@ -291,6 +424,9 @@ int restore_ctx_init (hashcat_ctx_t *hashcat_ctx, int argc, char **argv)
     hc_asprintf (&restore_ctx->new_restore_file, "%s.new", user_options->restore_file_path);
   }
 
+  hc_asprintf (&restore_ctx->eff_ranges_file, "%s.mm",     restore_ctx->eff_restore_file);
+  hc_asprintf (&restore_ctx->new_ranges_file, "%s.mm.new", restore_ctx->eff_restore_file);
+
   restore_ctx->argc = argc;
   restore_ctx->argv = argv;
 
@@ -315,6 +451,8 @@ int restore_ctx_init (hashcat_ctx_t *hashcat_ctx, int argc, char **argv)
       return -1;
     }
 
+    restore_ctx->restored = true;
+
     user_options_init (hashcat_ctx);
 
     const int rc_options_getopt = user_options_getopt (hashcat_ctx, rd->argc, rd->argv);
@@ -333,6 +471,8 @@ void restore_ctx_destroy (hashcat_ctx_t *hashcat_ctx)
 
   hcfree (restore_ctx->eff_restore_file);
   hcfree (restore_ctx->new_restore_file);
+  hcfree (restore_ctx->eff_ranges_file);
+  hcfree (restore_ctx->new_ranges_file);
 
   hcfree (restore_ctx->rd);
 
@@ -1626,6 +1626,27 @@ char *status_get_cpt (const hashcat_ctx_t *hashcat_ctx)
   return cpt;
 }
 
+int status_get_bitmap_bits (const hashcat_ctx_t *hashcat_ctx)
+{
+  const bitmap_ctx_t *bitmap_ctx = hashcat_ctx->bitmap_ctx;
+
+  return bitmap_ctx->bitmap_bits;
+}
+
+double status_get_bitmap_fill (const hashcat_ctx_t *hashcat_ctx)
+{
+  const bitmap_ctx_t *bitmap_ctx = hashcat_ctx->bitmap_ctx;
+
+  return bitmap_ctx->bitmap_fill * 100;
+}
+
+double status_get_bitmap_fpr (const hashcat_ctx_t *hashcat_ctx)
+{
+  const bitmap_ctx_t *bitmap_ctx = hashcat_ctx->bitmap_ctx;
+
+  return bitmap_ctx->bitmap_fpr;
+}
+
 char *status_get_hwmon_dev (const hashcat_ctx_t *hashcat_ctx, const int device_id)
 {
   const opencl_ctx_t *opencl_ctx = hashcat_ctx->opencl_ctx;
@@ -15,6 +15,8 @@
 #include "rp_cpu.h"
 #include "straight.h"
 #include "wordlist.h"
+#include "mm_impl.h"
+#include "mm_dict.h"
 
 static int straight_ctx_add_wl (hashcat_ctx_t *hashcat_ctx, const char *dict)
 {
@@ -70,7 +72,7 @@ int straight_ctx_update_loop (hashcat_ctx_t *hashcat_ctx)
         logfile_sub_var_string ("rulefile", user_options->rp_files[i]);
       }
 
-      FILE *fd = fopen (straight_ctx->dict, "rb");
+      FILE *fd = mm_dict_open (hashcat_ctx, straight_ctx->dict);
 
       if (fd == NULL)
       {
@@ -79,10 +81,10 @@ int straight_ctx_update_loop (hashcat_ctx_t *hashcat_ctx)
         return -1;
       }
 
-      fseek (fd, hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_start * hashcat_ctx->fd_list[straight_ctx->dicts_pos].word_base, SEEK_SET);
+      fseek (fd, (long) mm_word_offset (hashcat_ctx->fd_list + straight_ctx->dicts_pos, fd, 0), SEEK_SET);
 
       //const int rc = count_words (hashcat_ctx, hashcat_ctx->fd_list + straight_ctx->dicts_pos, straight_ctx->dict, &status_ctx->words_cnt);
-      status_ctx->words_cnt = hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_end - hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_start + 1; 
+      status_ctx->words_cnt = (hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_end - hashcat_ctx->fd_list[straight_ctx->dicts_pos].words_start + 1) * straight_ctx->kernel_rules_cnt;
 
 
       //if (rc == -1)
@@ -105,62 +107,18 @@ int straight_ctx_update_loop (hashcat_ctx_t *hashcat_ctx)
   }
   else if (user_options->attack_mode == ATTACK_MODE_COMBI)
   {
-#if 0
     logfile_sub_string (combinator_ctx->dict1);
     logfile_sub_string (combinator_ctx->dict2);
 
-    if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_LEFT)
-    {
-      FILE *fd = fopen (combinator_ctx->dict1, "rb");
-
-      if (fd == NULL)
-      {
-        event_log_error (hashcat_ctx, "%s: %s", combinator_ctx->dict1, strerror (errno));
-
-        return -1;
-      }
-
-      const int rc = count_words (hashcat_ctx, fd, combinator_ctx->dict1, &status_ctx->words_cnt);
-
-      if (rc == -1)
-      {
-        event_log_error (hashcat_ctx, "Integer overflow detected in keyspace of wordlist: %s", combinator_ctx->dict1);
-
-        return -1;
-      }
+    /// our records of the base side dict, see combi_divide_workload()
+    const mm_extend_fd_t *mfd = hashcat_ctx->fd_list + straight_ctx->dicts_pos;
 
-      fclose (fd);
-    }
-    else if (combinator_ctx->combs_mode == COMBINATOR_MODE_BASE_RIGHT)
+    if (mfd->is_valid == -1)
     {
-      FILE *fd = fopen (combinator_ctx->dict2, "rb");
-
-      if (fd == NULL)
-      {
-        event_log_error (hashcat_ctx, "%s: %s", combinator_ctx->dict2, strerror (errno));
-
-        return -1;
-      }
-
-      const int rc = count_words (hashcat_ctx, fd, combinator_ctx->dict2, &status_ctx->words_cnt);
-
-      if (rc == -1)
-      {
-        event_log_error (hashcat_ctx, "Integer overflow detected in keyspace of wordlist: %s", combinator_ctx->dict2);
-
-        return -1;
-      }
-
-      fclose (fd);
+      return 1;
     }
 
-    if (status_ctx->words_cnt == 0)
-    {
-      logfile_sub_msg ("STOP");
-
-      return 0;
-    }
-#endif
+    status_ctx->words_cnt = (mfd->words_end - mfd->words_start + 1) * combinator_ctx->combs_cnt;
   }
   else if (user_options->attack_mode == ATTACK_MODE_BF)
   {
@@ -168,7 +126,6 @@ int straight_ctx_update_loop (hashcat_ctx_t *hashcat_ctx)
   }
   else if ((user_options->attack_mode == ATTACK_MODE_HYBRID1) || (user_options->attack_mode == ATTACK_MODE_HYBRID2))
   {
-#if 0
     if (induct_ctx->induction_dictionaries_cnt)
     {
       straight_ctx->dict = induct_ctx->induction_dictionaries[induct_ctx->induction_dictionaries_pos];
@@ -181,33 +138,14 @@ int straight_ctx_update_loop (hashcat_ctx_t *hashcat_ctx)
     logfile_sub_string (straight_ctx->dict);
     logfile_sub_string (mask_ctx->mask);
 
-    FILE *fd = fopen (straight_ctx->dict, "rb");
-
-    if (fd == NULL)
+    if (mm_hybrid_split (hashcat_ctx) == 1)
     {
-      event_log_error (hashcat_ctx, "%s: %s", straight_ctx->dict, strerror (errno));
-
-      return -1;
+      return 1;
     }
 
-    const int rc = count_words (hashcat_ctx, fd, straight_ctx->dict, &status_ctx->words_cnt);
-
-    if (rc == -1)
-    {
-      event_log_error (hashcat_ctx, "Integer overflow detected in keyspace of wordlist: %s", straight_ctx->dict);
+    const mm_extend_fd_t *mfd = hashcat_ctx->fd_list + straight_ctx->dicts_pos;
 
-      return -1;
-    }
-
-    fclose (fd);
-
-    if (status_ctx->words_cnt == 0)
-    {
-      logfile_sub_msg ("STOP");
-
-      return 0;
-    }
-#endif
+    status_ctx->words_cnt = (mfd->words_end - mfd->words_start + 1) * combinator_ctx->combs_cnt;
   }
 
   return 0;
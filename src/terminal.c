@@ -1039,6 +1039,15 @@ void status_display (hashcat_ctx_t *hashcat_ctx)
       hashcat_status->cpt);
   }
 
+  if (hashcat_status->digests_cnt > 1000)
+  {
+    event_log_info (hashcat_ctx,
+      "Bitmaps..........: %d bits, %.2f%% filled, %.2e false positive rate",
+      hashcat_status->bitmap_bits,
+      hashcat_status->bitmap_fill,
+      hashcat_status->bitmap_fpr);
+  }
+
   switch (hashcat_status->progress_mode)
   {
     case PROGRESS_MODE_KEYSPACE_KNOWN:
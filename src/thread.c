@@ -118,6 +118,9 @@ void hc_signal (void (callback) (int))
 
 int mycracked (hashcat_ctx_t *hashcat_ctx)
 {
+  /// first crack on this rank, the stop latency is measured from here
+  if (hashcat_ctx->cracked[0] == 0) hc_timer_set (&hashcat_ctx->mm_ctx->crack_timer);
+
   hashcat_ctx->cracked[0] = 1;
 
   status_ctx_t *status_ctx = hashcat_ctx->status_ctx;
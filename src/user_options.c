@@ -114,6 +114,24 @@ static const struct option long_options[] =
   {"mm-log-interval",           required_argument, 0, IDX_MM_LOG_INTERVAL},
   {"mm-help",                   no_argument,       0, IDX_MM_HELP},
   {"mm-stdout-enable",          no_argument,       0, IDX_MM_STDOUT_ENABLE},
+  {"mm-dynamic",                no_argument,       0, IDX_MM_DYNAMIC},
+  {"mm-chunk-time",             required_argument, 0, IDX_MM_CHUNK_TIME},
+  {"mm-speed-split",            no_argument,       0, IDX_MM_SPEED_SPLIT},
+  {"mm-multi-target",           no_argument,       0, IDX_MM_MULTI_TARGET},
+  {"mm-potfile-shards",         no_argument,       0, IDX_MM_POTFILE_SHARDS},
+  {"mm-bcast-init",             no_argument,       0, IDX_MM_BCAST_INIT},
+  {"mm-node-topology",          no_argument,       0, IDX_MM_NODE_TOPOLOGY},
+  {"mm-cluster-restore",        no_argument,       0, IDX_MM_CLUSTER_RESTORE},
+  {"mm-degraded",               no_argument,       0, IDX_MM_DEGRADED},
+  {"mm-shared-reader",          no_argument,       0, IDX_MM_SHARED_READER},
+  {"mm-pipeline",               no_argument,       0, IDX_MM_PIPELINE},
+  {"mm-pack-pws",               no_argument,       0, IDX_MM_PACK_PWS},
+  {"mm-salt-batch",             no_argument,       0, IDX_MM_SALT_BATCH},
+  {"mm-parse-threads",          required_argument, 0, IDX_MM_PARSE_THREADS},
+  {"mm-hash-cache",             no_argument,       0, IDX_MM_HASH_CACHE},
+  {"mm-bitmap-fpr",             required_argument, 0, IDX_MM_BITMAP_FPR},
+  {"mm-pinned",                 no_argument,       0, IDX_MM_PINNED},
+  {"mm-hook-threads",           required_argument, 0, IDX_MM_HOOK_THREADS},
 
   {0, 0, 0, 0}
 };
@@ -231,6 +249,24 @@ int user_options_init (hashcat_ctx_t *hashcat_ctx)
   user_options->mm_attack_mode            = MM_STRAIGHT; 
   user_options->mm_usage                  = USAGE;
   user_options->mm_stdout_enable          = false;
+  user_options->mm_dynamic                = false;
+  user_options->mm_chunk_time             = DEFAULT_MM_CHUNK_TIME;
+  user_options->mm_speed_split            = false;
+  user_options->mm_multi_target           = false;
+  user_options->mm_potfile_shards         = false;
+  user_options->mm_bcast_init             = false;
+  user_options->mm_node_topology          = false;
+  user_options->mm_cluster_restore        = false;
+  user_options->mm_degraded               = false;
+  user_options->mm_shared_reader          = false;
+  user_options->mm_pipeline               = false;
+  user_options->mm_pack_pws               = false;
+  user_options->mm_salt_batch             = false;
+  user_options->mm_parse_threads          = 0;
+  user_options->mm_hash_cache             = false;
+  user_options->mm_bitmap_fpr             = 0;
+  user_options->mm_pinned                 = false;
+  user_options->mm_hook_threads           = 0;
 
   return 0;
 }
@@ -430,6 +466,24 @@ int user_options_getopt (hashcat_ctx_t *hashcat_ctx, int argc, char **argv)
       case IDX_MM_LOG_INTERVAL:           user_options->mm_log_interval           = atoi (optarg);  break;
       case IDX_MM_HELP:                   user_options->mm_usage                  = true;           break;
       case IDX_MM_STDOUT_ENABLE:          user_options->mm_stdout_enable          = true;           break;
+      case IDX_MM_DYNAMIC:                user_options->mm_dynamic                = true;           break;
+      case IDX_MM_CHUNK_TIME:             user_options->mm_chunk_time             = atoi (optarg);  break;
+      case IDX_MM_SPEED_SPLIT:            user_options->mm_speed_split            = true;           break;
+      case IDX_MM_MULTI_TARGET:           user_options->mm_multi_target           = true;           break;
+      case IDX_MM_POTFILE_SHARDS:         user_options->mm_potfile_shards         = true;           break;
+      case IDX_MM_BCAST_INIT:             user_options->mm_bcast_init             = true;           break;
+      case IDX_MM_NODE_TOPOLOGY:          user_options->mm_node_topology          = true;           break;
+      case IDX_MM_CLUSTER_RESTORE:        user_options->mm_cluster_restore        = true;           break;
+      case IDX_MM_DEGRADED:               user_options->mm_degraded               = true;           break;
+      case IDX_MM_SHARED_READER:          user_options->mm_shared_reader          = true;           break;
+      case IDX_MM_PIPELINE:               user_options->mm_pipeline               = true;           break;
+      case IDX_MM_PACK_PWS:               user_options->mm_pack_pws               = true;           break;
+      case IDX_MM_SALT_BATCH:             user_options->mm_salt_batch             = true;           break;
+      case IDX_MM_PARSE_THREADS:          user_options->mm_parse_threads          = atoi (optarg);  break;
+      case IDX_MM_HASH_CACHE:             user_options->mm_hash_cache             = true;           break;
+      case IDX_MM_BITMAP_FPR:             user_options->mm_bitmap_fpr             = atoi (optarg);  break;
+      case IDX_MM_PINNED:                 user_options->mm_pinned                 = true;           break;
+      case IDX_MM_HOOK_THREADS:           user_options->mm_hook_threads           = atoi (optarg);  break;
 
       default:
       {
@@ -731,6 +785,34 @@ int user_options_sanity (hashcat_ctx_t *hashcat_ctx)
     return -1;
   }
 
+  if (user_options->mm_chunk_time < 1)
+  {
+    event_log_error (hashcat_ctx, "Invalid mm-chunk-time specified.");
+
+    return -1;
+  }
+
+  if (user_options->mm_parse_threads > MM_PARSE_THREADS_MAX)
+  {
+    event_log_error (hashcat_ctx, "Invalid mm-parse-threads specified.");
+
+    return -1;
+  }
+
+  if (user_options->mm_bitmap_fpr > MM_BITMAP_FPR_MAX)
+  {
+    event_log_error (hashcat_ctx, "Invalid mm-bitmap-fpr specified.");
+
+    return -1;
+  }
+
+  if (user_options->mm_hook_threads > MM_HOOK_THREADS_MAX)
+  {
+    event_log_error (hashcat_ctx, "Invalid mm-hook-threads specified.");
+
+    return -1;
+  }
+
   if (user_options->opencl_vector_width_chgd == true)
   {
     if (is_power_of_2 (user_options->opencl_vector_width) == false || user_options->opencl_vector_width > 16)
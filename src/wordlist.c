@@ -50,6 +50,7 @@ int load_segment (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd, FILE *fd )
   wl_data_t *wl_data = hashcat_ctx->wl_data;
 
   long left_len = left_size(mfd, fd);
+  const long left_all = left_len;
   if (left_len == 0)
   {
     return -1;
@@ -63,13 +64,31 @@ int load_segment (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd, FILE *fd )
   }
 
   /// make sure that left_len can be divided by mfd->word_base
-  left_len = ( left_len / mfd->word_base) * mfd->word_base;
+  if (mfd->word_base > 0)
+  {
+    left_len = ( left_len / mfd->word_base) * mfd->word_base;
+  }
 
   // NOTE: use (never changing) ->incr here instead of ->avail otherwise the buffer gets bigger and bigger
   wl_data->pos = 0;
 
   wl_data->cnt = fread (wl_data->buf, 1, left_len, fd);
 
+  /// newline dict, keep whole lines only and read the cut one again with the next segment
+  if ((mfd->word_base == 0) && (left_len < left_all) && (wl_data->cnt > 0))
+  {
+    u64 keep = wl_data->cnt;
+
+    while ((keep > 0) && (wl_data->buf[keep - 1] != '\n')) keep--;
+
+    if ((keep > 0) && (keep < wl_data->cnt))
+    {
+      fseek (fd, -(long) (wl_data->cnt - keep), SEEK_CUR);
+
+      wl_data->cnt = keep;
+    }
+  }
+
   wl_data->buf[wl_data->cnt] = 0;
 
   //if (wl_data->cnt == 0) return 0;
@@ -202,6 +221,11 @@ void get_next_word (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd, FILE* fd, c
 
     //wl_data->func (ptr, wl_data->cnt - wl_data->pos, &len, &off);
 
+    if (mfd->word_base == 0)
+    {
+      wl_data->func (ptr, wl_data->cnt - wl_data->pos, &len, &off);
+    }
+
     wl_data->pos += off;
 
     // do the on-the-fly encoding
@@ -270,24 +294,43 @@ void get_next_word (hashcat_ctx_t *hashcat_ctx, mm_extend_fd_t *mfd, FILE* fd, c
 
   load_segment (hashcat_ctx, mfd, fd);
 
+  /// read error, e.g. a broken block of a compressed dict. the words from here on were not tried, so stop the attack
+  /// before they count as processed. an aborted run does not mark the range finished in the cluster checkpoint
+  if (wl_data->cnt == 0)
+  {
+    event_log_error (hashcat_ctx, "%s: Read error, stopping the attack.", hashcat_ctx->straight_ctx->dict);
+
+    myabort (hashcat_ctx);
+
+    *out_buf = wl_data->buf;
+    *out_len = 0;
+
+    return;
+  }
+
   get_next_word (hashcat_ctx, mfd, fd, out_buf, out_len);
 }
 
-void pw_add (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len)
+void pw_add_buf (pw_t *pws_buf, u32 *pws_cnt, const u8 *pw_buf, const int pw_len)
 {
-  //if (device_param->pws_cnt < device_param->kernel_power)
-  //{
-    pw_t *pw = (pw_t *) device_param->pws_buf + device_param->pws_cnt;
+  pw_t *pw = pws_buf + *pws_cnt;
+
+  u8 *ptr = (u8 *) pw->i;
 
-    u8 *ptr = (u8 *) pw->i;
+  memcpy (ptr, pw_buf, pw_len);
 
-    memcpy (ptr, pw_buf, pw_len);
+  memset (ptr + pw_len, 0, sizeof (pw->i) - pw_len);
 
-    memset (ptr + pw_len, 0, sizeof (pw->i) - pw_len);
+  pw->pw_len = pw_len;
 
-    pw->pw_len = pw_len;
+  (*pws_cnt)++;
+}
 
-    device_param->pws_cnt++;
+void pw_add (hc_device_param_t *device_param, const u8 *pw_buf, const int pw_len)
+{
+  //if (device_param->pws_cnt < device_param->kernel_power)
+  //{
+    pw_add_buf (device_param->pws_buf, &device_param->pws_cnt, pw_buf, pw_len);
   //}
   //else
   //{
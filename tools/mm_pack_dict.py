@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# Author......: likuan
+# License.....: MIT
+#
+# Packs a dict into the block-compressed format hashcat reads through mm_dict_open ().
+# Every block is a raw LZMA2 stream of its own, so a rank decodes only the blocks of its range.
+#
+#   mm_pack_dict.py rockyou.txt.gz rockyou.hcwz
+#   mm_pack_dict.py --width 12 words.12 words.12.hcwz
+#
+# The input may be plain, .gz or .xz. --width keeps fixed-width records of that many bytes,
+# without it the dict is packed as it is and read line by line.
+
+import argparse
+import bz2
+import gzip
+import lzma
+import struct
+import sys
+
+MM_WLZ_MAGIC   = 0x5a574348
+MM_WLZ_VERSION = 1
+MM_WLZ_HDR     = '<IIIIQQQQ'
+
+# same limit as MM_WLZ_BLOCK_MAX in include/mm_dict.h
+BLOCK_MAX = 64 * 1024 * 1024
+
+def open_input (path):
+  if path.endswith ('.gz'):
+    return gzip.open (path, 'rb')
+  if path.endswith ('.xz') or path.endswith ('.lzma'):
+    return lzma.open (path, 'rb')
+  if path.endswith ('.bz2'):
+    return bz2.open (path, 'rb')
+  return open (path, 'rb')
+
+# only the last block may be shorter than block_size
+def read_block (fin, size):
+  raw = b''
+  while len (raw) < size:
+    chunk = fin.read (size - len (raw))
+    if len (chunk) == 0:
+      break
+    raw += chunk
+  return raw
+
+# LZMA2 dictionary size byte, the smallest one that covers dict_size
+def lzma2_props (dict_size):
+  for props in range (40):
+    if ((2 | (props & 1)) << ((props // 2) + 11)) >= dict_size:
+      return props
+  return 40
+
+def main ():
+  parser = argparse.ArgumentParser (description = 'pack a dict into blocks of LZMA2 streams')
+  parser.add_argument ('input')
+  parser.add_argument ('output')
+  parser.add_argument ('--width', type = int, default = 0, help = 'record width of a fixed-width dict, 0 for a newline dict')
+  parser.add_argument ('--block-size', type = int, default = 1024 * 1024, help = 'uncompressed bytes per block')
+  parser.add_argument ('--preset', type = int, default = 6, help = 'xz preset, 0-9')
+  args = parser.parse_args ()
+
+  block_size = args.block_size
+
+  if args.width > 0:
+    block_size = max (1, block_size // args.width) * args.width
+
+  if block_size <= 0 or block_size > BLOCK_MAX:
+    sys.exit ('block size has to be in 1..%d' % BLOCK_MAX)
+
+  dict_size = max (4096, block_size)
+
+  filters = [{ 'id': lzma.FILTER_LZMA2, 'preset': args.preset, 'dict_size': dict_size }]
+
+  offs     = []
+  raw_size = 0
+
+  with open_input (args.input) as fin, open (args.output, 'wb') as fout:
+    fout.write (b'\0' * struct.calcsize (MM_WLZ_HDR))
+
+    while True:
+      raw = read_block (fin, block_size)
+
+      if len (raw) == 0:
+        break
+
+      offs.append (fout.tell ())
+
+      fout.write (lzma.compress (raw, format = lzma.FORMAT_RAW, filters = filters))
+
+      raw_size += len (raw)
+
+    if args.width > 0 and raw_size % args.width != 0:
+      sys.exit ('%s: size is not a multiple of %d' % (args.input, args.width))
+
+    offs.append (fout.tell ())
+
+    index_off = fout.tell ()
+
+    fout.write (struct.pack ('<%dQ' % len (offs), *offs))
+
+    fout.seek (0)
+
+    fout.write (struct.pack (MM_WLZ_HDR, MM_WLZ_MAGIC, MM_WLZ_VERSION, args.width, lzma2_props (dict_size), block_size, raw_size, len (offs) - 1, index_off))
+
+if __name__ == '__main__':
+  main ()
@@ -0,0 +1,422 @@
+/**
+ * Author......: likuan
+ * License.....: MIT
+ */
+
+/// checks of the workload split, the checkpoint ranges and the dict reading, see tools/mm_test.sh.
+/// links against the objects of the library, no device and no MPI job are needed
+
+#include "common.h"
+#include "types.h"
+#include "memory.h"
+#include "mm_impl.h"
+#include "mm_dict.h"
+#include "mm_ckpt.h"
+
+#include <stdarg.h>
+#include <inttypes.h>
+
+static int failed = 0;
+
+static void check (const bool ok, const char *fmt, ...)
+{
+  if (ok == true) return;
+
+  va_list ap;
+
+  va_start (ap, fmt);
+
+  printf ("FAIL: ");
+  vprintf (fmt, ap);
+  printf ("\n");
+
+  va_end (ap);
+
+  failed++;
+}
+
+static void event (const u32 id, hashcat_ctx_t *hashcat_ctx, MAYBE_UNUSED const void *buf, MAYBE_UNUSED const size_t len)
+{
+  if (id == EVENT_LOG_ERROR) printf ("error: %s\n", hashcat_ctx->event_ctx->msg_buf);
+}
+
+/// same xorshift on every platform, the checks are reproducible
+static u64 rnd_state = 0x9e3779b97f4a7c15;
+
+static u64 rnd (const u64 max)
+{
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 7;
+  rnd_state ^= rnd_state << 17;
+
+  return (max == 0) ? 0 : rnd_state % max;
+}
+
+static char *slurp (const char *path, u64 *len)
+{
+  FILE *fp = fopen (path, "rb");
+
+  if (fp == NULL) return NULL;
+
+  fseek (fp, 0, SEEK_END);
+
+  *len = (u64) ftell (fp);
+
+  rewind (fp);
+
+  char *buf = (char *) hcmalloc (*len + 1);
+
+  if (fread (buf, 1, *len, fp) != *len) *len = 0;
+
+  fclose (fp);
+
+  return buf;
+}
+
+/// the slices of all word groups cover [0, total) in rank order, the ranks of a word group share one slice
+static void test_slice (void)
+{
+  const u64 totals[] = { 0, 1, 7, 1000, 4096, 1234567, 0xffffffffffULL };
+
+  const double speeds[] = { 1, 3, 0.5, 1e6, 2, 7, 1, 1, 0.25 };
+
+  hashcat_ctx_t hashcat_ctx;
+  mm_ctx_t      mm_ctx;
+
+  memset (&hashcat_ctx, 0, sizeof (hashcat_ctx));
+  memset (&mm_ctx,      0, sizeof (mm_ctx));
+
+  hashcat_ctx.mm_ctx = &mm_ctx;
+
+  for (size_t t = 0; t < sizeof (totals) / sizeof (totals[0]); t++)
+  {
+    const u64 total = totals[t];
+
+    for (int cnt = 1; cnt <= 9; cnt++)
+    {
+      for (u32 groups = 1; groups <= 3; groups++)
+      {
+        if ((cnt % groups) != 0) continue;
+
+        for (int weighted = 0; weighted < 2; weighted++)
+        {
+          mm_ctx.rule_groups = groups;
+          mm_ctx.speeds      = (weighted == 1) ? (double *) speeds : NULL;
+
+          hashcat_ctx.total_proc_cnt = cnt;
+
+          u64 prev_end = 0;
+          u64 grp_beg  = 0;
+          u64 grp_end  = 0;
+
+          for (int rank = 0; rank < cnt; rank++)
+          {
+            hashcat_ctx.cur_proc_id = rank;
+
+            u64 start = 0;
+            u64 end   = 0;
+
+            mm_get_slice (&hashcat_ctx, total, &start, &end);
+
+            if ((rank % groups) == 0)
+            {
+              check (start == prev_end, "slice total %" PRIu64 " cnt %d groups %u weighted %d rank %d: starts at %" PRIu64 ", previous ends at %" PRIu64, total, cnt, groups, weighted, rank, start, prev_end);
+
+              grp_beg  = start;
+              grp_end  = end;
+              prev_end = end;
+            }
+            else
+            {
+              check ((start == grp_beg) && (end == grp_end), "slice total %" PRIu64 " cnt %d groups %u weighted %d rank %d: differs from its word group", total, cnt, groups, weighted, rank);
+            }
+
+            check (start <= end, "slice total %" PRIu64 " cnt %d rank %d: [%" PRIu64 ", %" PRIu64 ")", total, cnt, rank, start, end);
+          }
+
+          check (prev_end == total, "slice total %" PRIu64 " cnt %d groups %u weighted %d: ends at %" PRIu64, total, cnt, groups, weighted, prev_end);
+        }
+      }
+    }
+  }
+}
+
+/// the set stays sorted, disjoint and covers exactly the words reported so far
+static void test_range_merge (void)
+{
+  #define EPOCHS 3
+  #define WORDS  500
+
+  hashcat_ctx_t hashcat_ctx;
+  mm_ctx_t      mm_ctx;
+
+  memset (&hashcat_ctx, 0, sizeof (hashcat_ctx));
+  memset (&mm_ctx,      0, sizeof (mm_ctx));
+
+  hashcat_ctx.mm_ctx = &mm_ctx;
+
+  bool done[EPOCHS][WORDS];
+
+  memset (done, 0, sizeof (done));
+
+  for (int round = 0; round < 200; round++)
+  {
+    mm_range_t ranges[8];
+
+    const u32 cnt = 1 + (u32) rnd (8);
+
+    for (u32 i = 0; i < cnt; i++)
+    {
+      mm_range_t *range = ranges + i;
+
+      const u64 start = rnd (WORDS);
+      const u64 len   = 1 + rnd ((round < 100) ? 10 : WORDS - start);
+
+      range->epoch = rnd (EPOCHS);
+      range->total = WORDS;
+      range->start = start;
+      range->end   = MIN (WORDS, start + len);
+
+      for (u64 w = range->start; w < range->end; w++) done[range->epoch][w] = true;
+    }
+
+    mm_ckpt_merge (&hashcat_ctx, ranges, cnt);
+
+    bool seen[EPOCHS][WORDS];
+
+    memset (seen, 0, sizeof (seen));
+
+    for (u32 i = 0; i < mm_ctx.ckpt_set_cnt; i++)
+    {
+      const mm_range_t *range = mm_ctx.ckpt_set + i;
+
+      check ((range->start < range->end) && (range->end <= WORDS), "merge round %d: range %u is [%" PRIu64 ", %" PRIu64 ")", round, i, range->start, range->end);
+
+      if (i > 0)
+      {
+        const mm_range_t *prev = range - 1;
+
+        check ((prev->epoch < range->epoch) || ((prev->epoch == range->epoch) && (prev->end < range->start)), "merge round %d: range %u is not behind range %u", round, i, i - 1);
+      }
+
+      for (u64 w = range->start; (w < range->end) && (w < WORDS); w++) seen[range->epoch][w] = true;
+    }
+
+    check (memcmp (done, seen, sizeof (done)) == 0, "merge round %d: the set does not match the reported words", round);
+  }
+
+  check (mm_ctx.ckpt_set_cnt >= EPOCHS, "merge: %u ranges left", mm_ctx.ckpt_set_cnt);
+
+  hcfree (mm_ctx.ckpt_set);
+
+  #undef EPOCHS
+  #undef WORDS
+}
+
+/// line starts of a newline dict the simple way, a last line without a newline counts
+static u64 *line_starts (const char *buf, const u64 len, u64 *cnt)
+{
+  u64 *offs = (u64 *) hccalloc (len + 2, sizeof (u64));
+
+  u64 n = 0;
+
+  for (u64 i = 0; i < len; i++)
+  {
+    if ((i == 0) || (buf[i - 1] == '\n')) offs[n++] = i;
+  }
+
+  offs[n] = len;
+
+  *cnt = n;
+
+  return offs;
+}
+
+/// words_cnt and the offset of every line, once from a fresh index and once from the one saved to the profile dir
+static void test_index (hashcat_ctx_t *hashcat_ctx, const char *dict_file)
+{
+  u64 len = 0;
+
+  char *buf = slurp (dict_file, &len);
+
+  check (buf != NULL, "%s: missing", dict_file);
+
+  if (buf == NULL) return;
+
+  u64 ref_cnt = 0;
+
+  u64 *ref = line_starts (buf, len, &ref_cnt);
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    mm_extend_fd_t mfd;
+
+    memset (&mfd, 0, sizeof (mfd));
+
+    check (get_entry_cnt (hashcat_ctx, (char *) dict_file, &mfd) == 1, "%s pass %d: get_entry_cnt failed", dict_file, pass);
+
+    check (mfd.words_cnt == ref_cnt, "%s pass %d: %lu lines, expected %" PRIu64, dict_file, pass, mfd.words_cnt, ref_cnt);
+
+    FILE *fp = fopen (dict_file, "rb");
+
+    if ((fp != NULL) && (mfd.words_cnt == ref_cnt))
+    {
+      int bad = 0;
+
+      for (u64 i = 0; i <= ref_cnt; i++)
+      {
+        if (mm_word_offset (&mfd, fp, i) != ref[i]) bad++;
+      }
+
+      /// the same through words_start, the way a rank looks at its range
+      for (int i = 0; i < 100; i++)
+      {
+        mfd.words_start = rnd (ref_cnt + 1);
+
+        const u64 idx = rnd (ref_cnt - mfd.words_start + 1);
+
+        if (mm_word_offset (&mfd, fp, idx) != ref[mfd.words_start + idx]) bad++;
+      }
+
+      check (bad == 0, "%s pass %d: %d wrong line offsets", dict_file, pass, bad);
+    }
+
+    if (fp != NULL) fclose (fp);
+
+    release_entry_cnt (&mfd);
+  }
+
+  hcfree (ref);
+  hcfree (buf);
+}
+
+/// a compressed dict reads back byte for byte as the dict it was packed from, at any position
+static void test_wlz (hashcat_ctx_t *hashcat_ctx, const char *dict_file, const char *packed_file)
+{
+  u64 len = 0;
+
+  char *ref = slurp (dict_file, &len);
+
+  check (ref != NULL, "%s: missing", dict_file);
+
+  if (ref == NULL) return;
+
+  mm_extend_fd_t plain;
+  mm_extend_fd_t packed;
+
+  memset (&plain,  0, sizeof (plain));
+  memset (&packed, 0, sizeof (packed));
+
+  const int rc_plain  = get_entry_cnt (hashcat_ctx, (char *) dict_file,   &plain);
+  const int rc_packed = get_entry_cnt (hashcat_ctx, (char *) packed_file, &packed);
+
+  check ((rc_plain == 1) && (rc_packed == 1), "%s: get_entry_cnt failed", packed_file);
+
+  check (packed.packed == true, "%s: not taken as a compressed dict", packed_file);
+
+  check ((packed.words_cnt == plain.words_cnt) && (packed.word_base == plain.word_base) && (packed.file_size == len), "%s: %lu words of width %d in %" PRIu64 " bytes, expected %lu of width %d in %" PRIu64, packed_file, packed.words_cnt, packed.word_base, packed.file_size, plain.words_cnt, plain.word_base, len);
+
+  FILE *fp_plain  = fopen (dict_file, "rb");
+  FILE *fp_packed = mm_dict_open (hashcat_ctx, packed_file);
+
+  check (fp_packed != NULL, "%s: mm_dict_open failed", packed_file);
+
+  if ((fp_plain != NULL) && (fp_packed != NULL) && (rc_plain == 1) && (rc_packed == 1))
+  {
+    char *buf = (char *) hcmalloc (len + 1);
+
+    int bad = 0;
+
+    for (int i = 0; i < 300; i++)
+    {
+      plain.words_start = packed.words_start = rnd (plain.words_cnt + 1);
+
+      const u64 off = mm_word_offset (&packed, fp_packed, 0);
+
+      if (off != mm_word_offset (&plain, fp_plain, 0))
+      {
+        bad++;
+
+        continue;
+      }
+
+      if (fseek (fp_packed, (long) off, SEEK_SET) != 0)
+      {
+        bad++;
+
+        continue;
+      }
+
+      const size_t want = (size_t) rnd (20000);
+      const size_t got  = fread (buf, 1, want, fp_packed);
+
+      const size_t expect = (off + want > len) ? (size_t) (len - off) : want;
+
+      if ((got != expect) || (memcmp (buf, ref + off, got) != 0)) bad++;
+
+      if ((u64) ftell (fp_packed) != off + got) bad++;
+    }
+
+    rewind (fp_packed);
+
+    if ((fread (buf, 1, len + 1, fp_packed) != len) || (memcmp (buf, ref, len) != 0)) bad++;
+
+    check (ferror (fp_packed) == 0, "%s: read error", packed_file);
+
+    check (bad == 0, "%s: %d reads differ from %s", packed_file, bad, dict_file);
+
+    hcfree (buf);
+  }
+
+  if (fp_plain  != NULL) fclose (fp_plain);
+  if (fp_packed != NULL) fclose (fp_packed);
+
+  release_entry_cnt (&plain);
+  release_entry_cnt (&packed);
+
+  hcfree (ref);
+}
+
+int main (int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf (stderr, "usage: %s dir [dict packed_dict]...\n", argv[0]);
+
+    return -1;
+  }
+
+  hashcat_ctx_t   hashcat_ctx;
+  event_ctx_t     event_ctx;
+  folder_config_t folder_config;
+
+  memset (&hashcat_ctx,   0, sizeof (hashcat_ctx));
+  memset (&event_ctx,     0, sizeof (event_ctx));
+  memset (&folder_config, 0, sizeof (folder_config));
+
+  /// the line indexes go to the scratch dir
+  folder_config.profile_dir = argv[1];
+
+  hashcat_ctx.event         = event;
+  hashcat_ctx.event_ctx     = &event_ctx;
+  hashcat_ctx.folder_config = &folder_config;
+
+  test_slice ();
+  test_range_merge ();
+
+  for (int i = 2; i + 1 < argc; i += 2)
+  {
+    const char *ext = strrchr (argv[i], '.');
+
+    /// dict.N is a fixed-width dict, it has no index
+    if ((ext == NULL) || (atoi (ext + 1) == 0)) test_index (&hashcat_ctx, argv[i]);
+
+    #if defined (MM_WLZ_STREAM)
+    test_wlz (&hashcat_ctx, argv[i], argv[i + 1]);
+    #endif
+  }
+
+  printf ("%s: %d failed\n", argv[0], failed);
+
+  return (failed == 0) ? 0 : -1;
+}
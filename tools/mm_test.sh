@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+
+##
+## Author......: likuan
+## License.....: MIT
+##
+
+## Runs tools/mm_test.c, build it with "make check" from the top dir. The dicts are packed by
+## tools/mm_pack_dict.py, the same way as for a real attack, and have to read back unchanged.
+
+TDIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+
+BIN="${1:-./mm_test.bin}"
+
+OUTD="$(mktemp -d)"
+
+trap 'rm -rf "${OUTD}"' EXIT
+
+## more lines than MM_DICT_INDEX_STRIDE, with empty and CRLF lines, the blocks end in the middle of lines
+
+python3 - "${OUTD}" <<'PY' || exit 1
+import random, sys
+
+d = sys.argv[1]
+r = random.Random (7)
+
+lines = []
+
+for i in range (20000):
+  n = r.choice ([0, 1, 3, 8, 8, 12, 30])
+  w = ''.join (r.choice ('abcdefghijklmnopqrstuvwxyz0123456789') for _ in range (n))
+  lines.append (w + ('\r' if i % 97 == 0 else ''))
+
+nl = ('\n'.join (lines) + '\n').encode ()
+
+open (d + '/term.txt',   'wb').write (nl)
+open (d + '/unterm.txt', 'wb').write (nl[:-1])
+open (d + '/exact.txt',  'wb').write (b'x\n' * 8192)
+open (d + '/fixed.12',   'wb').write (b''.join (('%-12s' % w.strip ()[:12]).encode () for w in lines))
+PY
+
+for DICT in term.txt unterm.txt exact.txt; do
+  python3 "${TDIR}/mm_pack_dict.py" --block-size 65536 "${OUTD}/${DICT}" "${OUTD}/${DICT}.hcwz" > /dev/null || exit 1
+done
+
+python3 "${TDIR}/mm_pack_dict.py" --block-size 65532 --width 12 "${OUTD}/fixed.12" "${OUTD}/fixed.12.hcwz" > /dev/null || exit 1
+
+"${BIN}" "${OUTD}" \
+  "${OUTD}/term.txt"   "${OUTD}/term.txt.hcwz" \
+  "${OUTD}/unterm.txt" "${OUTD}/unterm.txt.hcwz" \
+  "${OUTD}/exact.txt"  "${OUTD}/exact.txt.hcwz" \
+  "${OUTD}/fixed.12"   "${OUTD}/fixed.12.hcwz"